@@ -0,0 +1,91 @@
+/*
+ * Written by Eran Kravitz
+ * Email: kravitzer@gmail.com
+ */
+
+#pragma once
+
+#include "Graph\defs.h"
+#include "Graph\CompactGraph.h"
+#include "Graph\MultiSourceBFS.h"
+#include "Graph\BidirectionalBFS.h"
+#include <vector>
+#include <memory>
+
+namespace hyperbolicity
+{
+	/*
+	 * @brief	The distances an SA process needs between the nodes of its state, without the distance matrix of the whole graph.
+	 *			A move replaces a node of the state with one of its neighbors, so only the distances from the new node to the other three
+	 *			are needed, and each is within 1 of the replaced node's. These are read from a small LRU cache of distance rows (of the
+	 *			current and recent state nodes) when possible, and otherwise found by a bidirectional search bounded by the replaced
+	 *			node's distance + 1. A state node that keeps missing the cache gets its row computed.
+	 * @note	Keeps its own search buffers, so it is not thread-safe - every process (or chain) needs its own.
+	 */
+	class DistanceOracle
+	{
+	public:
+		/*
+		 * @param	graph			The graph. Must outlive this instance.
+		 * @param	maxCachedRows	Maximal number of rows cached (at least 4, so that the rows of a whole state fit).
+		 */
+		DistanceOracle(const CompactGraph& graph, size_t maxCachedRows);
+		~DistanceOracle();
+
+		/*
+		 * @brief	Sets rows[i] to the row of nodes[i], calculating the ones not cached in a single run. The rows remain valid until
+		 *			the next call to this instance.
+		 */
+		void getRows(const node_index_t* nodes, size_t count, const compact_distance_t** rows);
+
+		/*
+		 * @param	newNode			A neighbor of one of the state's nodes, about to replace it.
+		 * @param	node			Another node of the state.
+		 * @param	oldDistance		The distance between the replaced node and node.
+		 * @param	searchCount		Number of searches made for node's distances since it joined the state. Incremented by every search,
+		 *							and once it is above SearchesPerRow, node's row is calculated & cached instead.
+		 * @returns	The distance between the new node and node.
+		 */
+		distance_t getNewDistance(node_index_t newNode, node_index_t node, distance_t oldDistance, unsigned int& searchCount);
+
+		//number of searches for the distances of a state node, after which its row is calculated and cached
+		static const unsigned int SearchesPerRow = 8;
+
+	private:
+		//do *not* allow copy ctor / assignment operator
+		DistanceOracle(const DistanceOracle&);
+		DistanceOracle& operator=(const DistanceOracle&);
+
+		/*
+		 * @returns	The cached row of the given node, nullptr if it is not cached.
+		 */
+		const compact_distance_t* findRow(node_index_t node);
+
+		/*
+		 * @brief	Makes room in the cache for the given node's row, evicting the least recently used one if the cache is full.
+		 * @returns	The row to calculate the node's distances into.
+		 */
+		compact_distance_t* allocateRow(node_index_t node);
+
+		//a cached distance row, and the last time (in row lookups) it was used
+		struct CachedRow
+		{
+			node_index_t node;
+			unsigned long long lastUse;
+			std::vector<compact_distance_t> distances;
+		};
+
+		const CompactGraph& _graph;
+		size_t _maxCachedRows;
+
+		//the buffers for full rows and for bounded searches
+		MultiSourceBFS _bfs;
+		BidirectionalBFS _pairSearch;
+		//the row cache, and the number of lookups so far
+		std::vector<CachedRow> _rows;
+		unsigned long long _lookupCount;
+	};
+
+	typedef std::shared_ptr<DistanceOracle> distance_oracle_ptr_t;
+
+} // namespace hyperbolicity
@@ -7,7 +7,10 @@
 
 #include "Algorithm\IGraphAlg.h"
 #include "Algorithm\DeltaHyperbolicity.h"
+#include "Graph\DynamicDistances.h"
+#include "Algorithm\RandomStream.h"
 #include <string>
+#include <vector>
 #include <boost\circular_buffer.hpp>
 #include <unordered_map>
 #include <unordered_set>
@@ -24,6 +27,8 @@ namespace hyperbolicity
 	 *			This implementation also remembers the last p Double-Sweeps (p is a parameter) and at each step (after the p'th step):
 	 *			For each node that appeard in at least q (also a parameter) of the Double-Sweeps, try to see if it is a part of a cycle and
 	 *			remove it if possible.
+	 *			Distance rows of the double-sweep nodes are kept across steps, and survive cycle removals (which never change the
+	 *			distances between the remaining nodes) by being remapped to the new node indices, along with the double-sweep history.
 	 */
 	class IDSweepMinExt : public IGraphAlg
 	{
@@ -64,6 +69,17 @@ namespace hyperbolicity
 		 */
 		delta_t runOnSweepCollection(node_ptr_t& node);
 
+		/*
+		 * @brief	Remaps the double-sweep history to the new node indices after nodes were removed, dropping sweeps of removed nodes.
+		 * @param	mapping		The new index of each old node index (see DynamicDistances::synchronize()).
+		 */
+		void remapSweeps(const std::vector<node_index_t>& mapping);
+
+		/*
+		 * @brief	Decrements the number of sweeps the given node appears in, dropping its distance row when it reaches 0.
+		 */
+		void releaseSweepNode(node_index_t node);
+
 		//collection of the last X double sweep results (X is a constant set in the cpp file)
 		boost::circular_buffer<std::pair<node_index_t, node_index_t>> _doubleSweeps;
 		//maps the node index to the number of times it appeared in the last double sweeps
@@ -73,6 +89,10 @@ namespace hyperbolicity
 		//this set holds the nodes that were tested and found irremovable (so there's no point in testing them on every step)
 		//we save the label instead of the index because after we remove nodes, indices may change
 		std::unordered_set<std::string> _irremovableNodes;
+		//distance rows of the nodes in the double-sweep history (and of the current v3)
+		std::shared_ptr<DynamicDistances> _distances;
+		//selects v3 among the candidates
+		RandomStream _random;
 	};
 
 	extern "C" __declspec(dllexport) IGraphAlg* CreateAlgorithm();
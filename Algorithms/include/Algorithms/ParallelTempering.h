@@ -0,0 +1,139 @@
+/*
+ * Written by Eran Kravitz
+ * Email: kravitzer@gmail.com
+ */
+
+#pragma once
+
+#include "SADefs.h"
+#include "SimulatedAnnealing.h"
+#include "Algorithm\IGraphAlg.h"
+#include "Algorithm\RandomStream.h"
+#include "Algorithm\WorkerPool.h"
+#include "Graph\CompactGraph.h"
+#include "DistanceOracle.h"
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace hyperbolicity
+{
+	/*
+	 * @brief	Replica-exchange (parallel tempering) variant of the simulated annealing process. Several chains run at once, each with its
+	 *			own probability & temperature functions and random stream. The chains' starting temperatures are spaced geometrically
+	 *			from the functions' initial temperature down to their final one, however many chains there are (so the first chain
+	 *			explores and the last one climbs).
+	 *			Each step runs MovesPerStep moves of every chain on worker threads, then offers the chains' states to be exchanged:
+	 *			going over the chains from the hottest to the coldest, two consecutive chains at temperatures t1 > t2 and deltas d1, d2
+	 *			swap their states with probability min(1, exp((d1 - d2) * (1/t2 - 1/t1))), so a good state found by a hot chain sinks
+	 *			to the cold ones, and a cold chain stuck at a local maximum gets to leave it.
+	 *			Every chain reads its distances from its own DistanceOracle, which moves along with the state when states are exchanged.
+	 *			The chains run on a pool of threads kept for the lifetime of the instance.
+	 */
+	class ParallelTempering : public IGraphAlg
+	{
+	public:
+		/*
+		 * @param	probabilityFactory	Creates the probability function of a chain.
+		 * @param	tempFactory			Creates the temperature function of a chain.
+		 * @param	callbackFunction	Called once per step with the coldest chain's state (may be null).
+		 * @param	chainCount			Number of chains (at least 2).
+		 * @param	threadCount			Number of chains run in parallel (unless limited - see IGraphAlg::setThreadLimit()).
+		 * @param	seed				The seed of the chains' random streams.
+		 */
+		ParallelTempering(sa_prob_func_factory_t probabilityFactory, sa_temp_func_factory_t tempFactory, sa_callback_func_ptr callbackFunction,
+						  unsigned int chainCount, unsigned int threadCount, unsigned long long seed);
+		virtual ~ParallelTempering();
+
+		/*
+		 * @returns	True once every chain's temperature is <= 0, false otherwise.
+		 */
+		virtual bool isComplete() const;
+
+		/*
+		 * @returns	The chains' temperatures & deltas, and the number of exchanges made.
+		 */
+		virtual std::string getStatistics() const;
+
+	private:
+		//do *not* allow copy ctor / assignment operator
+		ParallelTempering(const ParallelTempering& other);
+		ParallelTempering& operator=(const ParallelTempering& other);
+
+		/*
+		 * @brief	A single chain - its SA functions and temperature, current state and the best state it saw during the current step.
+		 */
+		struct Chain
+		{
+			Chain(sa_prob_func_ptr probabilityFunction, sa_temp_func_ptr tempFunction, unsigned long long seed, unsigned long long stream,
+				  const CompactGraph& graph);
+
+			sa_prob_func_ptr probFunc;
+			sa_temp_func_ptr tempFunc;
+			sa_temp_t temp;
+			RandomStream random;
+
+			node_index_t nodes[4];
+			//the 6 distances between the nodes (v1->v2, v1->v3, v1->v4, v2->v3, v2->v4, v3->v4, in that order!)
+			distance_t distances[6];
+			delta_t delta;
+			//the distances from the state's nodes, and the number of searches for each state node since it joined the state
+			distance_oracle_ptr_t oracle;
+			unsigned int searchCounts[4];
+
+			node_index_t bestNodes[4];
+			delta_t bestDelta;
+		};
+
+		/*
+		 * @brief	See documentation in IGraphAlg and in the class description above.
+		 */
+		virtual DeltaHyperbolicity stepImpl();
+		virtual void initImpl(const node_combination_t& initialState);
+
+		/*
+		 * @brief	Runs the given number of moves of a chain (fewer if its temperature reaches 0).
+		 */
+		void runChain(Chain& chain, unsigned int moveCount) const;
+
+		/*
+		 * @brief	Offers every pair of consecutive chains (by temperature) to exchange their states (along with their oracles).
+		 */
+		void exchangeStates();
+
+		/*
+		 * @brief	Sets the chain's nodes to the given ones, and calculates their distances & delta.
+		 */
+		static void setState(Chain& chain, const node_index_t* nodes);
+
+		/*
+		 * @returns	The delta of the given 6 distances (ordered as in Chain::distances).
+		 */
+		static delta_t calculateDelta(const distance_t* distances);
+
+		//number of moves of every chain between two exchanges
+		static const unsigned int MovesPerStep = 256;
+		//maximal number of distance rows cached by every chain
+		static const size_t RowsPerChain = 8;
+		//number of trials to find a neighbor that is not already in the state, before giving up the move
+		static const unsigned int MaxNeighborTrials = 16;
+
+		sa_prob_func_factory_t _probFactory;
+		sa_temp_func_factory_t _tempFactory;
+		sa_callback_func_ptr _callbackFunc;
+		unsigned int _chainCount;
+		unsigned int _threadCount;
+		unsigned long long _seed;
+
+		std::vector<Chain> _chains;
+		//random stream for the exchanges
+		RandomStream _random;
+		unsigned long long _exchangeCount;
+
+		//snapshot of the graph for selecting neighbors & calculating distances
+		compact_graph_ptr_t _compactGraph;
+		//the threads running the chains (created by the initialization, as the thread limit may have changed)
+		std::shared_ptr<WorkerPool> _pool;
+	};
+
+} // namespace hyperbolicity
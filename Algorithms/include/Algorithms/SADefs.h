@@ -7,6 +7,7 @@
 
 #include "Graph\defs.h"
 #include <memory>
+#include <functional>
 
 namespace hyperbolicity
 {
@@ -18,6 +19,10 @@ namespace hyperbolicity
 	typedef std::shared_ptr<ISaTempPolicyFunction>		sa_temp_func_ptr;
 	typedef std::shared_ptr<ISaCallbackFunction>		sa_callback_func_ptr;
 
+	//create a new instance of a function, for a process that needs one per chain (the functions may keep state)
+	typedef std::function<sa_prob_func_ptr ()>			sa_prob_func_factory_t;
+	typedef std::function<sa_temp_func_ptr ()>			sa_temp_func_factory_t;
+
 	typedef double			sa_temp_t;
 	typedef double			sa_probability_t;
 
@@ -7,7 +7,12 @@
 
 #include "SADefs.h"
 #include "Algorithm\IGraphAlg.h"
+#include "Algorithm\RandomStream.h"
+#include "Graph\CompactGraph.h"
+#include "DistanceOracle.h"
 #include <string>
+#include <vector>
+#include <memory>
 
 namespace hyperbolicity
 {
@@ -51,6 +56,12 @@ namespace hyperbolicity
 		 */
 		virtual sa_temp_t GetInitialTemperature() const = 0;
 
+		/*
+		 * @returns	The lowest temperature the process runs at (positive, and at most the initial temperature) - the policy ends the
+		 *			process once the temperature drops below it.
+		 */
+		virtual sa_temp_t GetFinalTemperature() const = 0;
+
 		/*
 		 * @brief	Resets any internal state the instance might have, in order to start over when necessary.
 		 */
@@ -81,6 +92,13 @@ namespace hyperbolicity
 
 	/*
 	 * @brief	An implementation for the simulated annealing algorithm.
+	 *			A move replaces a node of the state with one of its neighbors, so only the distances from the new node to the other three
+	 *			are needed. These are read from a DistanceOracle (a small cache of rows, and searches bounded by the replaced node's
+	 *			distance + 1).
+	 *			In the rejection-free mode, every step evaluates all the moves of the current state at once (the rows of the state's nodes
+	 *			hold the distances to all of their neighbors) and makes one of them, selected with probability proportional to the
+	 *			chance of the regular process proposing & accepting it. No step is wasted on a rejected move, which is what most steps
+	 *			of the regular process are once the temperature is low.
 	 */
 	class SimulatedAnnealing : public IGraphAlg
 	{
@@ -90,8 +108,11 @@ namespace hyperbolicity
 		 * @param	probabilityFunction		The probability method to be used in the process.
 		 * @param	tempFunction			The temperature method to be used in the process.
 		 * @param	callbackFunction		The callback method to be called on every step of the SA (may be null).
+		 * @param	isRejectionFree			True to run in the rejection-free mode (see the class description above).
+		 * @param	seed					The seed of the random stream selecting the moves & accepting them.
 		 */
-		SimulatedAnnealing(sa_prob_func_ptr probabilityFunction, sa_temp_func_ptr tempFunction, sa_callback_func_ptr callbackFunction);
+		SimulatedAnnealing(sa_prob_func_ptr probabilityFunction, sa_temp_func_ptr tempFunction, sa_callback_func_ptr callbackFunction, bool isRejectionFree = false,
+						   unsigned long long seed = 0);
 
 		/*
 		 * @brief	Default dtor.
@@ -119,11 +140,29 @@ namespace hyperbolicity
 		virtual void initImpl(const node_combination_t& initialState);
 
 		/*
-		 * @brief	Calculates the 6 distances for the current state.
+		 * @brief	A single step of the rejection-free mode.
+		 */
+		DeltaHyperbolicity stepRejectionFree();
+
+		/*
+		 * @brief	Sets rows[i] to the row of the i'th node of the current state, calculating the ones not cached in a single run.
+		 */
+		void getStateRows(const compact_distance_t* rows[4]);
+
+		/*
+		 * @brief	Calculates the 6 distances for the current state (caching the rows of its nodes).
 		 * @returns	The delta for the current state, based on those 6 distances.
 		 */
 		delta_t calculateCurrentDelta();
 
+		/*
+		 * @param	newNode			A neighbor of one of the state's nodes, about to replace it.
+		 * @param	stateIndex		Index (in the state) of another node of the state.
+		 * @param	oldDistance		The distance between the replaced node and the other node.
+		 * @returns	The distance between the new node and the other node.
+		 */
+		distance_t getNewDistance(node_index_t newNode, unsigned int stateIndex, distance_t oldDistance);
+
 		/*
 		 * @brief	Starts the SA process.
 		 * @param	graph			The graph to run on.
@@ -141,7 +180,7 @@ namespace hyperbolicity
          * @returns The index of the node in the state structure that changed (NOTE: not the index of the node,
          *          but the index in the state collection! e.g. b/w 0 to 3!!).
 		 */
-		unsigned int getNeighbor(const graph_ptr_t graph, const node_combination_t& curState, node_combination_t* newState) const;
+		unsigned int getNeighbor(const graph_ptr_t graph, const node_combination_t& curState, node_combination_t* newState);
 
 		//current state & delta
 		node_combination_t _curState;
@@ -149,12 +188,34 @@ namespace hyperbolicity
 
 		//is this the first step after initialization
 		bool _isFirstStep;
+		//run in the rejection-free mode
+		bool _isRejectionFree;
+		//random stream for selecting the moves & accepting them
+		RandomStream _random;
+
+		//a move of the rejection-free mode - replacing the state's node at the given index with the given node, and the sum of
+		//the rates of all moves up to & including this one
+		struct Move
+		{
+			unsigned int stateIndex;
+			node_index_t node;
+			delta_t delta;
+			double cumulativeRate;
+		};
+		std::vector<Move> _moves;
 
-		//collection to be used when calculating distances to some specific nodes
-		node_ptr_collection_t _destinationNodes;
 		//the 6 distances needed to calculate delta (v1->v2, v1->v3, v1->v4, v2->v3, v2->v4, v3->v4, in that order!)
 		distance_t _nodeDistances[6];
 
+		//maximal number of cached distance rows
+		static const size_t MaxCachedRows = 16;
+
+		//snapshot of the graph for calculating distances, the distances between the state's nodes, and the number of searches for
+		//each state node since it joined the state
+		compact_graph_ptr_t _compactGraph;
+		distance_oracle_ptr_t _distances;
+		unsigned int _searchCount[4];
+
 		//SA parameters (see ctor for details)
 		sa_temp_t _temp;
 		sa_prob_func_ptr _probFunc;
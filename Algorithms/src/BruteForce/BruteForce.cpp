@@ -1,18 +1,20 @@
 #include "BruteForce.h"
 #include "Graph\defs.h"
 #include "Graph\GraphAlgorithms.h"
-#include "Graph\NodeDistances.h"
 #include "Algorithm\DeltaHyperbolicity.h"
 #include "Algorithm\State.h"
 #include "Algorithm\HyperbolicityAlgorithms.h"
+#include "Algorithm\FourPointKernel.h"
 #include <time.h>
 #include <string>
+#include <algorithm>
+#include <thread>
 
 using namespace std;
 
 namespace hyperbolicity
 {
-	BruteForce::BruteForce() : IGraphAlg()
+	BruteForce::BruteForce(unsigned int threadCount /* = 1 */) : IGraphAlg(), _threadCount(max(1u, threadCount))
 	{
 		//empty
 	}
@@ -24,91 +26,130 @@ namespace hyperbolicity
 
 	bool BruteForce::isComplete() const
 	{
-		return ( (_v4 == _graph->size() - node_combination_t::size() + 3) &&
-				 (_v3 == _graph->size() - node_combination_t::size() + 2) &&
-				 (_v2 == _graph->size() - node_combination_t::size() + 1) &&
-				 (_v1 == _graph->size() - node_combination_t::size() + 0) );
+		//the last v1 is n-4, as v2, v3 & v4 must follow it
+		return (_v1 + node_combination_t::size() > _graph->size());
+	}
+
+	bool BruteForce::isExact() const
+	{
+		return true;
+	}
+
+	bool BruteForce::supportsWeightedGraph() const
+	{
+		return true;
 	}
 
 	void BruteForce::initImpl(const node_combination_t&)
 	{
 		_v1 = 0;
-		_v2 = 1;
-		_v3 = 2;
-		_v4 = 2;	//each step advances the current state, so we start at state "-1" (i.e. one prior to the initial)
-
-        _v1Distances = getDistancesForRemainingNodes(_v1);
-        _v2Distances = getDistancesForRemainingNodes(_v2);
-        _v3Distances = getDistancesForRemainingNodes(_v3);
+		_distances = DistanceMatrixFactory::create(*getCompactGraph(), DistanceMatrixFactory::DefaultMemoryBudget, [this](double progress) -> bool
+		{
+			reportProgress(progress);
+			return !isStopRequested();
+		});
+		_denseDistances = dynamic_pointer_cast<DenseDistanceMatrix>(_distances);
+		const unsigned int threadCount = limitThreads(_threadCount);
+		if ( (nullptr == _pool.get()) || (_pool->threadCount() != threadCount) ) _pool = shared_ptr<WorkerPool>(new WorkerPool(threadCount));
 	}
 
 	DeltaHyperbolicity BruteForce::stepImpl()
 	{
-        node_index_t tmpv1 = _v1;
-        node_index_t tmpv2 = _v2;
-        node_index_t tmpv3 = _v3;
+		const node_index_t blockEnd = min(_v1 + _pool->threadCount() * V1PerThread, _graph->size() - node_combination_t::size() + 1);
+		atomic<node_index_t> nextV1(_v1);
+		vector<SearchResult> results(_pool->threadCount());
+		_pool->run([this, blockEnd, &nextV1, &results](unsigned int i)
+		{
+			try
+			{
+				searchBlock(nextV1, blockEnd, results[i]);
+			}
+			catch (...)
+			{
+				//the other threads are stopped by taking the rest of the block
+				nextV1 = blockEnd;
+				throw;
+			}
+		});
 
-		node_combination_t curState = advanceState();
-        if (tmpv3 != _v3) _v3Distances = getDistancesForRemainingNodes(_v3);
-        if (tmpv1 != _v2) _v2Distances = getDistancesForRemainingNodes(_v2);
-        if (tmpv1 != _v1) _v1Distances = getDistancesForRemainingNodes(_v1);
+		//the block is searched only if no thread was stopped - otherwise the run is over, and the search must not be taken as complete
+		const SearchResult* best = &results.front();
+		bool isStopped = false;
+		for (auto it = results.cbegin(); it != results.cend(); ++it)
+		{
+			if (it->doubleDelta > best->doubleDelta) best = &*it;
+			isStopped = isStopped || it->isStopped;
+		}
+		if (!isStopped) _v1 = blockEnd;
 
-        distance_t d1 = _v1Distances[_v2] + _v3Distances[_v4];
-        distance_t d2 = _v1Distances[_v3] + _v2Distances[_v4];
-        distance_t d3 = _v1Distances[_v4] + _v2Distances[_v3];
-		delta_t curDelta = HyperbolicityAlgorithms::calculateDeltaFromDistances(d1, d2, d3);
+		//every v1 in a block searched has at least one 4-tuple, so only a stopped step may have no result
+		if (best->doubleDelta < 0) return DeltaHyperbolicity();
 
-		return DeltaHyperbolicity(curDelta, curState);
+		node_combination_t state(_graph->getNode(best->nodes[0]), _graph->getNode(best->nodes[1]), _graph->getNode(best->nodes[2]), _graph->getNode(best->nodes[3]));
+		return DeltaHyperbolicity(best->doubleDelta / 2.0, state);
 	}
 
-	node_combination_t BruteForce::advanceState()
+	void BruteForce::searchBlock(atomic<node_index_t>& nextV1, node_index_t blockEnd, SearchResult& result) const
 	{
-		do
+		result.doubleDelta = -1;
+		result.isStopped = false;
+		const size_t n = _graph->size();
+		//only used if the matrix is not dense
+		vector<compact_distance_t> v1Buffer, v2Buffer, v3Buffer;
+		if (nullptr == _denseDistances.get())
+		{
+			v1Buffer.resize(n);
+			v2Buffer.resize(n);
+			v3Buffer.resize(n);
+		}
+
+		for (node_index_t v1 = nextV1++; v1 < blockEnd; v1 = nextV1++)
 		{
-			//increment v4
-			_v4 = (_v4 + 1) % _graph->size();
-			if (0 == _v4)
+			const compact_distance_t* v1Distances = getRow(v1, v1Buffer);
+			for (node_index_t v2 = v1 + 1; v2 + 2 < n; ++v2)
 			{
-				//v4 overlapped, increment v3
-				_v3 = (_v3 + 1) % (_graph->size() - 1);
-				if (0 == _v3)
+				//the other threads see the same request, so there is no need to take the rest of the block
+				if (isStopRequested())
 				{
-					//v3 overlapped, increment v3
-					_v2 = (_v2 + 1) % (_graph->size() - 2);
-					if (0 == _v2)
-					{
-						//v2 overlapped, increment v3
-						_v1 = (_v1 + 1) % (_graph->size() - 3);
-						//it's impossible for v1 to overlap as well - just make sure
-						if (0 == _v1) throw std::logic_error("Brute force algorithm completed, yet another step was required");
-						_v2 = _v1 + 1;
-					}
-					_v3 = _v2 + 1;
+					result.isStopped = true;
+					return;
+				}
+				const compact_distance_t* v2Distances = getRow(v2, v2Buffer);
+				for (node_index_t v3 = v2 + 1; v3 + 1 < n; ++v3)
+				{
+					//scan every v4 following v3 for the current triple
+					const compact_distance_t* v3Distances = getRow(v3, v3Buffer);
+					const node_index_t first = v3 + 1;
+					FourPointKernel::Result cur = FourPointKernel::scanRows(
+						v1Distances[v2], v3Distances + first,
+						v1Distances[v3], v2Distances + first,
+						v2Distances[v3], v1Distances + first,
+						n - first);
+					if (cur.doubleDelta <= result.doubleDelta) continue;
+
+					result.doubleDelta = cur.doubleDelta;
+					result.nodes[0] = v1;
+					result.nodes[1] = v2;
+					result.nodes[2] = v3;
+					result.nodes[3] = first + min(cur.index, n - first - 1);
 				}
-				_v4 = _v3 + 1;
 			}
-		} while (!node_combination_t::isStateValid( _graph->getNode(_v1), _graph->getNode(_v2), _graph->getNode(_v3), _graph->getNode(_v4) ) );
-
-		return node_combination_t( _graph->getNode(_v1), _graph->getNode(_v2), _graph->getNode(_v3), _graph->getNode(_v4) );
+		}
 	}
 
-    distance_dict_t BruteForce::getDistancesForRemainingNodes(node_index_t curIndex)
-    {
-        node_ptr_collection_t nodesToSearch;
-        for (node_index_t i = curIndex + 1; i < _graph->size(); ++i)
-        {
-            nodesToSearch.push_back(_graph->getNode(i));
-        }
+	const compact_distance_t* BruteForce::getRow(node_index_t u, vector<compact_distance_t>& buffer) const
+	{
+		if (nullptr != _denseDistances.get()) return _denseDistances->row(u);
 
-        NodeDistances nd(_graph, _graph->getNode(curIndex));
-        return nd.getDistances(nodesToSearch);
-    }
+		_distances->getRow(u, buffer.data());
+		return buffer.data();
+	}
 
 
 
 	IGraphAlg* CreateAlgorithm()
 	{
-		IGraphAlg* alg = new BruteForce();
+		IGraphAlg* alg = new BruteForce(thread::hardware_concurrency());
 		return alg;
 	}
 
@@ -7,22 +7,48 @@
 
 #include "Algorithm\IGraphAlg.h"
 #include "Algorithm\DeltaHyperbolicity.h"
+#include "Algorithm\WorkerPool.h"
+#include "Graph\DistanceMatrix.h"
 #include <string>
+#include <vector>
+#include <atomic>
+#include <memory>
 
 namespace hyperbolicity
 {
 	/*
 	 * @brief	Implementation for the brute-force solution for finding delta hyperbolicity. Obviously takes a significant amount of time
-	 *			even on small graphs, so it should only be run on VERY small graphs. Simply goes over all 4-node combinations,
-	 *			looking for the one that produces that maximal delta hyperbolicity.
+	 *			even on small graphs, so it should only be run on small graphs. Simply goes over all 4-node combinations v1 < v2 < v3 < v4,
+	 *			looking for the one that produces that maximal delta hyperbolicity. Each step covers a block of consecutive v1 values,
+	 *			which the threads take one at a time (so that the shorter searches of higher v1 values even out). For every triple, all
+	 *			v4 > v3 are evaluated at once by the batched four-point kernel. The distance matrix comes from DistanceMatrixFactory, so it
+	 *			may be any representation: the rows of a dense matrix are read in place, those of any other one are copied into buffers
+	 *			of the searching thread. The threads are a pool kept for the whole run.
+	 *			Initialization stops early once asked to (see IGraphAlg::isStopRequested()) while calculating the distances, and a step
+	 *			stops between v2 values - the block of a stopped step is not counted as searched, and a step stopped before evaluating
+	 *			any 4-tuple returns no state.
+	 *			On a weighted graph (see IGraphAlg::setWeightedGraph()) the 4-tuples are evaluated by its distances.
 	 */
 	class BruteForce : public IGraphAlg
 	{
 	public:
-		BruteForce();
+		/*
+		 * @param	threadCount	Number of threads to search with.
+		 */
+		explicit BruteForce(unsigned int threadCount = 1);
 		virtual ~BruteForce();
 		bool isComplete() const;
 
+		/*
+		 * @returns	True - every 4-tuple is evaluated.
+		 */
+		virtual bool isExact() const;
+
+		/*
+		 * @returns	True - the distances are found on the weighted graph, when one is set.
+		 */
+		virtual bool supportsWeightedGraph() const;
+
 	private:
 		/*
 		 * @brief	See documentation in IGraphAlg and in the class description above.
@@ -31,21 +57,39 @@ namespace hyperbolicity
 		virtual DeltaHyperbolicity stepImpl();
 
 		/*
-		 * @brief	Advances the current state to the next.
+		 * @brief	The best 4-tuple found by a single thread (doubleDelta is -1 if it did not evaluate any), and whether it was stopped
+		 *			before finishing its part of the block.
+		 */
+		struct SearchResult
+		{
+			distance_t doubleDelta;
+			node_index_t nodes[4];
+			bool isStopped;
+		};
+
+		/*
+		 * @brief	The work of a single thread in a step: takes v1 values until reaching the end of the block, and searches all
+		 *			4-tuples starting with each.
 		 */
-		node_combination_t advanceState();
+		void searchBlock(std::atomic<node_index_t>& nextV1, node_index_t blockEnd, SearchResult& result) const;
 
-        /*
-         * @returns The distances from the node whose index is given, to every node with an index higher than its own.
-         */
-        distance_dict_t getDistancesForRemainingNodes(node_index_t curIndex);
+		/*
+		 * @returns	The row of the given node - in place if the matrix is dense, otherwise copied into buffer (which must have room for
+		 *			the whole row).
+		 */
+		const compact_distance_t* getRow(node_index_t u, std::vector<compact_distance_t>& buffer) const;
 
-		//The maximal number of trials to get 4 different nodes out of separate double-sweeps
-		static const unsigned int MaxNumOfTrials = 50;
+		//number of v1 values each thread covers in a single step (on average)
+		static const size_t V1PerThread = 4;
 
-		//the indecis of the current nodes, iterated in order
-		node_index_t _v1, _v2, _v3, _v4;
-        distance_dict_t _v1Distances, _v2Distances, _v3Distances;
+		//number of threads to search with (unless limited - see IGraphAlg::setThreadLimit()), and the threads (created by the initialization)
+		unsigned int _threadCount;
+		std::shared_ptr<WorkerPool> _pool;
+		//the first v1 of the next step
+		node_index_t _v1;
+		//distances between every pair of nodes, and the same matrix if it is dense (null otherwise)
+		distance_matrix_ptr_t _distances;
+		std::shared_ptr<DenseDistanceMatrix> _denseDistances;
 	};
 
 	extern "C" __declspec(dllexport) IGraphAlg* CreateAlgorithm();
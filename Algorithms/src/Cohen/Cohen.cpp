@@ -2,17 +2,21 @@
 #include "Graph\defs.h"
 #include "Algorithm\DeltaHyperbolicity.h"
 #include "Graph\GraphAlgorithms.h"
-#include "Graph\NodeDistances.h"
 #include "Algorithm\State.h"
 #include "Algorithm\HyperbolicityAlgorithms.h"
+#include "Algorithm\FourPointKernel.h"
+#include "Graph\TiledDistanceMatrix.h"
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <sstream>
+#include <thread>
 
 using namespace std;
 
 namespace hyperbolicity
 {
-	Cohen::Cohen() : IGraphAlg(), _bestDelta(0)
+	Cohen::Cohen(unsigned int threadCount /* = 1 */) : IGraphAlg(), _threadCount(max(1u, threadCount)), _evaluatedCount(0), _prunedCount(0), _bestDelta(0)
 	{
 		//empty
 	}
@@ -24,126 +28,364 @@ namespace hyperbolicity
 
 	bool Cohen::isComplete() const
 	{
-        return (_end >= _l1);
+		//an initialization that was stopped leaves no pairs - the search was not even started
+		if (_pairs.empty()) return false;
+
+		//also complete once the lower bound has reached a known upper bound
+		const delta_t upperBound = currentUpperBound();
+		return ( (_end >= _l1) || ( (InfiniteDelta != upperBound) && (currentLowerBound() >= upperBound) ) );
+	}
+
+	bool Cohen::isExact() const
+	{
+		return true;
+	}
+
+	bool Cohen::supportsWeightedGraph() const
+	{
+		return true;
+	}
+
+	std::string Cohen::getStatistics() const
+	{
+		stringstream statistics;
+		statistics << "4-tuples evaluated: " << _evaluatedCount << ", pruned: " << _prunedCount;
+		return statistics.str();
 	}
 
 	void Cohen::initImpl(const node_combination_t&)
 	{
-		_distances.clear();
 		_pairs.clear();
 		_bestDelta = 0;
+		_evaluatedCount = _prunedCount = 0;
+
+		//find distances (the first half of the initialization), and keep only the far-apart pairs (the second half) - either may be stopped
+		const compact_graph_ptr_t compactGraph = getCompactGraph();
+		_distances = DistanceMatrixFactory::create(*compactGraph, DistanceMatrixFactory::DefaultMemoryBudget, [this](double progress) -> bool
+		{
+			reportProgress(progress / 2);
+			return !isStopRequested();
+		}, true);
+		if ( (nullptr == _distances.get()) || !loadFarApartPairs(*compactGraph) )
+		{
+			_pairs.clear();
+			return;
+		}
 
-        //find distances and add to array in a sorted manner
-		for (unsigned int i = 0; i < _graph->size(); ++i)
-        {
-            node_ptr_t cur = _graph->getNode(i);
-            NodeDistances curDistances(_graph, cur);
-            _distances[i] = curDistances.getDistances();
-            for (distance_dict_t::const_iterator it = _distances[i].cbegin(); it != _distances[i].cend(); ++it)
-            {
-                if (it->first > i) addToArray(i, it);
-            }
-        }
-
-        //initialize iterators
-        _l1 = _l2 = _pairs.size()-1;
-        _l1Pos = 0;
-		_l2Pos = 0;
-		_end = 0;
-		advancePointers();
+		//a step searches a whole distance, starting from the farthest one - and only a 4-tuple that beats the lower bound matters, so the
+		//distances it rules out are never searched
+		_l1 = _pairs.size() - 1;
+		_end = static_cast<size_t>(2 * currentLowerBound());
+		indexPartners();
+		const unsigned int threadCount = limitThreads(_threadCount);
+		if ( (nullptr == _pool.get()) || (_pool->threadCount() != threadCount) ) _pool = shared_ptr<WorkerPool>(new WorkerPool(threadCount));
 	}
 
 	DeltaHyperbolicity Cohen::stepImpl()
 	{
-        node_combination_t nodes(_graph->getNode(_pairs[_l1].at(_l1Pos).first), _graph->getNode(_pairs[_l1].at(_l1Pos).second), _graph->getNode(_pairs[_l2].at(_l2Pos).first), _graph->getNode(_pairs[_l2].at(_l2Pos).second));
-        distance_t d1 = static_cast<distance_t>(_l1 + _l2);
-        distance_t d2 = _distances[_pairs[_l1].at(_l1Pos).first][_pairs[_l2].at(_l2Pos).first] + _distances[_pairs[_l1].at(_l1Pos).second][_pairs[_l2].at(_l2Pos).second];
-        distance_t d3 = _distances[_pairs[_l1].at(_l1Pos).first][_pairs[_l2].at(_l2Pos).second] + _distances[_pairs[_l1].at(_l1Pos).second][_pairs[_l2].at(_l2Pos).first];
-        delta_t delta = HyperbolicityAlgorithms::calculateDeltaFromDistances(d1, d2, d3);
-
-        if (delta > _bestDelta)
-        {
-            _bestDelta = delta;
-            _end = static_cast<size_t>(_bestDelta*2);
-        }
-
-        //advance pointers to be ready for next step
-        advancePointers();
-
-        return DeltaHyperbolicity(delta, nodes);
+		//the lower bound may have been raised since the last step
+		_end = max(_end, static_cast<size_t>(2 * currentLowerBound()));
+
+		//the nodes that have a pair at distance _l1 or more
+		size_t activeCount = 0;
+		while ( (activeCount < _nodesByFarthestPartner.size()) &&
+				(_partners[_partnerOffsets[_nodesByFarthestPartner[activeCount]]].distance >= _l1) )
+		{
+			++activeCount;
+		}
+
+		//the best delta is shared as twice its value, so that it can be compared & swapped as an integer
+		atomic<size_t> nextPair(0);
+		atomic<distance_t> bestDoubleDelta(static_cast<distance_t>(_end));
+		vector<SearchResult> results(_pool->threadCount());
+		const size_t l1 = _l1;
+		_pool->run([this, l1, activeCount, &nextPair, &bestDoubleDelta, &results](unsigned int i)
+		{
+			try
+			{
+				searchPairs(l1, activeCount, nextPair, bestDoubleDelta, results[i]);
+			}
+			catch (...)
+			{
+				//the other threads are stopped by taking the rest of the pairs
+				nextPair = _pairCounts[l1];
+				throw;
+			}
+		});
+
+		//this distance is done (unless the step was stopped), and any 4-tuple of a smaller one has delta at most half of it
+		if (isStopRequested())
+		{
+			reportProgress(min(1.0, static_cast<double>(nextPair) / max<size_t>(1, _pairCounts[l1])));
+		}
+		else
+		{
+			--_l1;
+			reportProgress(1);
+		}
+		_end = static_cast<size_t>(bestDoubleDelta);
+		_bestDelta = max(_bestDelta, bestDoubleDelta / 2.0);
+
+		const SearchResult* best = &results.front();
+		for (auto it = results.cbegin(); it != results.cend(); ++it)
+		{
+			_evaluatedCount += it->evaluatedCount;
+			_prunedCount += it->prunedCount;
+			if (it->doubleDelta > best->doubleDelta) best = &*it;
+		}
+
+		//nothing evaluated beat the lower bound, so there is no state to report
+		if (best->doubleDelta < 0) return DeltaHyperbolicity();
+
+		return DeltaHyperbolicity(best->doubleDelta / 2.0, node_combination_t(_graph->getNode(best->nodes[0]), _graph->getNode(best->nodes[1]),
+																			   _graph->getNode(best->nodes[2]), _graph->getNode(best->nodes[3])));
 	}
 
-    void Cohen::addToArray(const node_index_t origin, const distance_dict_t::const_iterator& it)
-    {
-        if (_pairs.size() <= static_cast<size_t>(it->second))
-        {
-            _pairs.resize(it->second + 1);
-        }
-
-        pair<node_index_t, node_index_t> pairToAdd(origin, it->first);
-
-        vector<pair<node_index_t, node_index_t>>& pairCollection = _pairs[it->second];
-        int32_t binaryLowerBound = -1, binaryUpperBound = static_cast<int32_t>(pairCollection.size());
-        while (binaryLowerBound < binaryUpperBound - 1)
-        {
-            size_t binarySearchLocation = (binaryUpperBound + binaryLowerBound) / 2;
-            if ( (pairCollection[binarySearchLocation].first < pairToAdd.first) ||
-                 (pairCollection[binarySearchLocation].first == pairToAdd.first && (pairCollection[binarySearchLocation].second < pairToAdd.second) ) )
-            {
-                binaryLowerBound = static_cast<int32_t>(binarySearchLocation);
-            }
-            else
-            {
-                binaryUpperBound = static_cast<int32_t>(binarySearchLocation);
-            }
-        }
-        
-        //add element before upper bound
-        pairCollection.insert(pairCollection.cbegin()+binaryUpperBound, pairToAdd);
-    }
-
-	void Cohen::advancePointers()
+	void Cohen::searchPairs(size_t l1, size_t activeCount, atomic<size_t>& nextPair, atomic<distance_t>& bestDoubleDelta, SearchResult& result) const
 	{
-		do
+		result.doubleDelta = -1;
+		result.evaluatedCount = result.prunedCount = 0;
+		const size_t size = _distances->size();
+		vector<compact_distance_t> firstRow(size), secondRow(size);
+		//whether each node is acceptable / valuable for the current pair, filled for the active nodes only
+		vector<char> isAcceptable(size), isValuable(size);
+		const size_t pairCount = _pairCounts[l1];
+
+		//number of pairs at distance above l1, i.e. the pairs every pair at l1 is matched with (besides the following ones at l1)
+		unsigned long long fartherPairCount = 0;
+		for (size_t l2 = l1 + 1; l2 < _pairCounts.size(); ++l2)
+		{
+			fartherPairCount += _pairCounts[l2];
+		}
+
+		for (size_t begin = nextPair.fetch_add(PairsPerChunk); begin < pairCount; begin = nextPair.fetch_add(PairsPerChunk))
 		{
-			++_l2Pos;
-			while (_l2Pos == _pairs[_l2].size())
+			//a stopped step leaves the distance unfinished (see searchStepImpl())
+			if (isStopRequested()) return;
+
+			for (size_t i = begin; i < min(pairCount, begin + PairsPerChunk); ++i)
 			{
-				++_l1Pos;
-				while (_l1Pos == _pairs[_l1].size() || ( _l1 == _l2 && _l1Pos == _pairs[_l1].size()-1 ))
-				{
-					//if _l2 is at 0, we can't take it any lower - i.e. we're done
-					if (0 == _l2) return;
+				//no 4-tuple with a pair at distance l1 has delta above l1 / 2
+				const distance_t h = bestDoubleDelta;
+				if (h >= static_cast<distance_t>(l1)) return;
 
-					--_l2;
-					while (_l2 < _l1)
-					{
-						--_l1;
-						_l2 = _pairs.size() - 1;
+				const unsigned int first = _pairs[l1][2 * i];
+				const unsigned int second = _pairs[l1][2 * i + 1];
+				_distances->getRow(first, firstRow.data());
+				_distances->getRow(second, secondRow.data());
 
-						//if we've reached end position - we're done
-						if (_end >= _l1) return;
+				for (size_t k = 0; k < activeCount; ++k)
+				{
+					const unsigned int v = _nodesByFarthestPartner[k];
+					if ( (CompactInfiniteDistance == firstRow[v]) || (CompactInfiniteDistance == secondRow[v]) )
+					{
+						isAcceptable[v] = isValuable[v] = false;
+						continue;
 					}
-					_l1Pos = 0;
+					const distance_t slack = static_cast<distance_t>(l1) - firstRow[v] - secondRow[v];
+					isAcceptable[v] = (slack + 2 * _eccentricities[v] > 2 * h);
+					isValuable[v] = (slack + _eccentricities[v] > h);
 				}
-            
-				if (_l2 != _l1)
+
+				unsigned long long evaluatedCount = 0;
+				for (size_t k = 0; k < activeCount; ++k)
 				{
-					_l2Pos = 0;
+					const unsigned int v = _nodesByFarthestPartner[k];
+					if (!isValuable[v]) continue;
+
+					for (size_t p = _partnerOffsets[v]; (p < _partnerOffsets[v + 1]) && (_partners[p].distance >= l1); ++p)
+					{
+						const Partner& partner = _partners[p];
+						const unsigned int w = partner.node;
+
+						//a pair with both nodes valuable is taken from its smaller node, and pairs at l1 are only matched with the following ones
+						if ( !isAcceptable[w] || (isValuable[w] && w < v) ) continue;
+						if ( (partner.distance == l1) && (partner.index <= i) ) continue;
+
+						distance_t doubleDelta = FourPointKernel::doubleDelta(static_cast<distance_t>(l1 + partner.distance),
+																			  firstRow[v] + secondRow[w], firstRow[w] + secondRow[v]);
+						++evaluatedCount;
+						if (doubleDelta <= result.doubleDelta) continue;
+
+						result.doubleDelta = doubleDelta;
+						result.nodes[0] = first;
+						result.nodes[1] = second;
+						result.nodes[2] = v;
+						result.nodes[3] = w;
+
+						//publish it to the other threads, unless one of them has already found better
+						distance_t shared = bestDoubleDelta;
+						while ( (doubleDelta > shared) && !bestDoubleDelta.compare_exchange_weak(shared, doubleDelta) );
+					}
 				}
-				else
+
+				result.evaluatedCount += evaluatedCount;
+				result.prunedCount += fartherPairCount + (pairCount - i - 1) - evaluatedCount;
+			}
+		}
+	}
+
+	void Cohen::indexPartners()
+	{
+		const size_t size = _distances->size();
+		_partnerOffsets.assign(size + 1, 0);
+		for (size_t d = 0; d < _pairs.size(); ++d)
+		{
+			for (size_t k = 0; k < _pairs[d].size(); ++k)
+			{
+				++_partnerOffsets[_pairs[d][k] + 1];
+			}
+		}
+		for (size_t v = 0; v < size; ++v)
+		{
+			_partnerOffsets[v + 1] += _partnerOffsets[v];
+		}
+
+		//going over the distances from the farthest keeps each node's pairs sorted farthest first
+		_partners.resize(_partnerOffsets[size]);
+		vector<size_t> positions(_partnerOffsets.cbegin(), _partnerOffsets.cend() - 1);
+		for (size_t d = _pairs.size(); d-- > 0; )
+		{
+			for (size_t k = 0; k < _pairCounts[d]; ++k)
+			{
+				const unsigned int u = _pairs[d][2 * k], v = _pairs[d][2 * k + 1];
+				Partner fromU = { v, static_cast<compact_distance_t>(d), static_cast<unsigned int>(k) };
+				Partner fromV = { u, static_cast<compact_distance_t>(d), static_cast<unsigned int>(k) };
+				_partners[positions[u]++] = fromU;
+				_partners[positions[v]++] = fromV;
+			}
+		}
+
+		_nodesByFarthestPartner.clear();
+		for (unsigned int v = 0; v < size; ++v)
+		{
+			if (_partnerOffsets[v] < _partnerOffsets[v + 1]) _nodesByFarthestPartner.push_back(v);
+		}
+		sort(_nodesByFarthestPartner.begin(), _nodesByFarthestPartner.end(), [this](unsigned int a, unsigned int b)
+		{
+			return _partners[_partnerOffsets[a]].distance > _partners[_partnerOffsets[b]].distance;
+		});
+	}
+
+	bool Cohen::loadFarApartPairs(const CompactGraph& graph)
+	{
+		_pairs.assign(_distances->getMaxDistance() + 1, vector<unsigned int>());
+		_eccentricities.assign(_distances->size(), 0);
+
+		//a tiled matrix has its far-apart pairs marked, and is read in file order - reading it by rows would seek all over the file
+		const TiledDistanceMatrix* tiledDistances = dynamic_cast<const TiledDistanceMatrix*>(_distances.get());
+		const bool isLoaded = ( ( (nullptr != tiledDistances) && tiledDistances->hasFarApartPairs() ) ?
+								loadFarApartPairsFromTiles(*tiledDistances) : loadFarApartPairsFromRows(graph) );
+		if (!isLoaded) return false;
+
+		_pairCounts.resize(_pairs.size());
+		for (size_t i = 0; i < _pairs.size(); ++i)
+		{
+			_pairCounts[i] = _pairs[i].size() / 2;
+		}
+		return true;
+	}
+
+	bool Cohen::loadFarApartPairsFromTiles(const TiledDistanceMatrix& distances)
+	{
+		//every pair u < v is in a single tile, on or above the diagonal
+		TiledDistanceMatrix::TileReader reader(distances);
+		const unsigned long long totalTileCount = static_cast<unsigned long long>(distances.getTileCount()) * (distances.getTileCount() + 1) / 2;
+		unsigned long long tileCount = 0;
+		const TiledDistanceMatrix::TileReader::Tile* tile = nullptr;
+		while (reader.next(tile))
+		{
+			const bool isDiagonal = (tile->rowBegin == tile->colBegin);
+			for (size_t r = 0; r < tile->rowEnd - tile->rowBegin; ++r)
+			{
+				const node_index_t u = tile->rowBegin + r;
+				for (size_t c = (isDiagonal ? r + 1 : 0); c < tile->colEnd - tile->colBegin; ++c)
 				{
-					_l2Pos = _l1Pos + 1;
+					const compact_distance_t distance = tile->getDistance(r, c);
+					if (CompactInfiniteDistance == distance) continue;
+
+					const node_index_t v = tile->colBegin + c;
+					if (distance > _eccentricities[u]) _eccentricities[u] = distance;
+					if (distance > _eccentricities[v]) _eccentricities[v] = distance;
+					if (!tile->isFarApart(r, c)) continue;
+					_pairs[distance].push_back(static_cast<unsigned int>(u));
+					_pairs[distance].push_back(static_cast<unsigned int>(v));
 				}
 			}
-		} while (_pairs[_l1].size() <= _l1Pos || _pairs[_l2].size() <= _l2Pos);
+
+			reportProgress(0.5 + 0.5 * ++tileCount / totalTileCount);
+			if (isStopRequested()) return false;
+		}
+		return true;
 	}
 
+	bool Cohen::loadFarApartPairsFromRows(const CompactGraph& graph)
+	{
+		const size_t size = _distances->size();
+		vector<compact_distance_t> row(size);
+
+		//a pair (u, v), u < v, is far-apart if no neighbor of v is farther from u than v is, and the same holds the other way around.
+		//the first is found in u's row and the second in v's, so the nodes v are taken in blocks, small enough that a bit for every u < v
+		//of the block fits in PendingMemoryBudget, and each block is a pass over the rows up to its end
+		const size_t blockSize = static_cast<size_t>(max(1ULL, min(static_cast<unsigned long long>(size), PendingMemoryBudget * 8 / max<size_t>(1, size))));
+		unsigned long long totalRowCount = 0, rowCount = 0;
+		for (size_t blockBegin = 0; blockBegin < size; blockBegin += blockSize)
+		{
+			totalRowCount += min(size, blockBegin + blockSize);
+		}
+
+		for (node_index_t blockBegin = 0; blockBegin < size; blockBegin += blockSize)
+		{
+			const node_index_t blockEnd = min(size, blockBegin + blockSize);
+			//pending[v - blockBegin][u] is set if no neighbor of v is farther from u than v is
+			vector<vector<bool>> pending(blockEnd - blockBegin);
+			for (node_index_t v = blockBegin; v < blockEnd; ++v)
+			{
+				pending[v - blockBegin].assign(v, false);
+			}
+
+			for (node_index_t u = 0; u < blockEnd; ++u)
+			{
+				_distances->getRow(u, row.data());
+
+				//the rows before the block were already read by an earlier pass
+				if (u >= blockBegin)
+				{
+					for (node_index_t v = 0; v < size; ++v)
+					{
+						if (CompactInfiniteDistance != row[v] && row[v] > _eccentricities[u]) _eccentricities[u] = row[v];
+					}
+
+					const vector<bool>& candidates = pending[u - blockBegin];
+					for (node_index_t v = 0; v < u; ++v)
+					{
+						if (candidates[v] && GraphAlgorithms::isFarthestAmongNeighbors(graph, row.data(), v))
+						{
+							_pairs[row[v]].push_back(static_cast<unsigned int>(v));
+							_pairs[row[v]].push_back(static_cast<unsigned int>(u));
+						}
+					}
+					vector<bool>().swap(pending[u - blockBegin]);
+				}
+
+				if (0 == ++rowCount % RowsPerProgressCheck)
+				{
+					reportProgress(0.5 + 0.5 * rowCount / totalRowCount);
+					if (isStopRequested()) return false;
+				}
 
+				for (node_index_t v = max(u + 1, blockBegin); v < blockEnd; ++v)
+				{
+					if (CompactInfiniteDistance != row[v] && GraphAlgorithms::isFarthestAmongNeighbors(graph, row.data(), v)) pending[v - blockBegin][u] = true;
+				}
+			}
+		}
+		return true;
+	}
 
 	IGraphAlg* CreateAlgorithm()
 	{
-		IGraphAlg* alg = new Cohen();
+		IGraphAlg* alg = new Cohen(max(1u, thread::hardware_concurrency()));
 		return alg;
 	}
 
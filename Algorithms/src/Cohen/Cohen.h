@@ -7,23 +7,66 @@
 
 #include "Algorithm\IGraphAlg.h"
 #include "Algorithm\DeltaHyperbolicity.h"
+#include "Algorithm\WorkerPool.h"
+#include "Graph\DistanceMatrix.h"
+#include "Graph\CompactGraph.h"
+#include "Graph\TiledDistanceMatrix.h"
 #include <string>
 #include <vector>
+#include <atomic>
+#include <memory>
 
 namespace hyperbolicity
 {
 	/*
 	 * @brief	Implementation for the Cohen, Coudert, Lancin solution for finding delta hyperbolicity. Calculates the distances for every pair
-     *          of vertices, sorts them in decreasing order, and iterates 4-tuples in that order. When a new delta h* is found, all pairs of distance
-     *          2h* or less are removed from the collection and are not considered.
+	 *			of vertices, sorts them in decreasing order, and iterates 4-tuples in that order. When a new delta h* is found, all pairs of
+	 *			distance 2h* or less are removed from the collection and are not considered.
+	 *			Distances are kept in a distance matrix, which is encoded or moved to disk for graphs too large for memory.
+	 *			Only far-apart pairs are iterated: (u, v) is far-apart if no neighbor of v is farther from u than v is, and vice versa.
+	 *			Some 4-tuple attaining delta has both of its pairs of largest distance sum far-apart, so the result is unchanged, while
+	 *			on sparse graphs far-apart pairs are a tiny fraction of all pairs.
+	 *			Each step covers all the 4-tuples whose smaller pair is at the current distance. The pairs at that distance are handed out
+	 *			to the threads of a pool (kept for the whole run) in chunks, and the threads share the best delta found, so that a thread
+	 *			stops as soon as any of them has found a delta the current distance cannot improve on. For each pair (x, y), only the
+	 *			far-apart pairs (v, w) with both nodes acceptable and at least one of them valuable are evaluated (after Borassi et al.):
+	 *			with h twice the best delta, and s(v) = d(x, v) + d(y, v),
+	 *				v is acceptable if d(x, y) + 2 * ecc(v) - s(v) > 2h, otherwise every 4-tuple containing x, y, v has 2 * delta <= h
+	 *				v is valuable if d(x, y) + ecc(v) - s(v) > h, otherwise every 4-tuple x, y, v, w where w is not valuable either has
+	 *				2 * delta <= h (valuable nodes are always acceptable).
+	 *			The search starts from the current lower bound rather than from 0, so only 4-tuples that beat it are searched for, and
+	 *			the run is complete as soon as the lower bound reaches a known upper bound. A step that finds no such 4-tuple returns no state.
+	 *			Both the initialization and the search steps stop early once asked to (see IGraphAlg::isStopRequested()) - the distances
+	 *			are computed a batch of sources at a time, the far-apart pairs are loaded a group of rows (or a tile) at a time, and the
+	 *			pairs of a search step are taken a chunk at a time.
+	 *			On a weighted graph (see IGraphAlg::setWeightedGraph()) the pairs are weighted as well - the pruning above holds for
+	 *			any graph metric, and the far-apart test follows the weights (see GraphAlgorithms::isFarthestAmongNeighbors()).
 	 */
 	class Cohen : public IGraphAlg
 	{
 	public:
-		Cohen();
+		/*
+		 * @param	threadCount	Number of threads to search with (at least 1).
+		 */
+		explicit Cohen(unsigned int threadCount = 1);
 		virtual ~Cohen();
 		bool isComplete() const;
 
+		/*
+		 * @returns	True - every 4-tuple that could beat the lower bound is evaluated.
+		 */
+		virtual bool isExact() const;
+
+		/*
+		 * @returns	True - the distances and far-apart pairs are found on the weighted graph, when one is set.
+		 */
+		virtual bool supportsWeightedGraph() const;
+
+		/*
+		 * @returns	The number of 4-tuples evaluated and pruned by the search.
+		 */
+		virtual std::string getStatistics() const;
+
 	private:
 		/*
 		 * @brief	See documentation in IGraphAlg and in the class description above.
@@ -31,23 +74,89 @@ namespace hyperbolicity
 		virtual void initImpl(const node_combination_t&);
 		virtual DeltaHyperbolicity stepImpl();
 
-        /*
-         * @brief   Adds the pair of nodes given to the appropriate place in the pair array.
-         */
-        void addToArray(const node_index_t origin, const distance_dict_t::const_iterator& it);
-
-		void advancePointers();
-
-        //for each node, holds its distance map
-        std::unordered_map<node_index_t, distance_dict_t> _distances;
-        //vector where after initialization, element i has the collection of pairs at distance i
-        std::vector<std::vector<std::pair<node_index_t, node_index_t>>> _pairs;
-        //iterators on the pairs vector, and the end iterator which marks the last element to be considered
-        size_t _l1, _l2, _end;
-        //the current position inside the pair vector at elements _l1 and _l2
-        size_t _l1Pos, _l2Pos;
-        //best delta found so far
-        delta_t _bestDelta;
+		/*
+		 * @brief	Finds the far-apart pairs and places them in _pairs by distance, and the eccentricity of every node.
+		 * @returns	False if it was stopped before reading the whole matrix.
+		 */
+		bool loadFarApartPairs(const CompactGraph& graph);
+
+		/*
+		 * @brief	Loads the far-apart pairs marked in a tiled matrix, in a single pass over its tiles in file order.
+		 */
+		bool loadFarApartPairsFromTiles(const TiledDistanceMatrix& distances);
+
+		/*
+		 * @brief	Finds the far-apart pairs by reading each row of the distance matrix once, unless the candidate pairs do not fit in
+		 *			PendingMemoryBudget - then the rows are read in several passes.
+		 */
+		bool loadFarApartPairsFromRows(const CompactGraph& graph);
+
+		/*
+		 * @brief	The best 4-tuple found by a single thread (doubleDelta is -1 if it did not evaluate any), and the thread's counters.
+		 */
+		struct SearchResult
+		{
+			distance_t doubleDelta;
+			unsigned int nodes[4];
+			unsigned long long evaluatedCount;
+			unsigned long long prunedCount;
+		};
+
+		/*
+		 * @brief	A far-apart pair, as seen from one of its nodes.
+		 */
+		struct Partner
+		{
+			unsigned int node;
+			compact_distance_t distance;
+			//the pair's position in _pairs[distance]
+			unsigned int index;
+		};
+
+		/*
+		 * @brief	The work of a single thread in a search step: takes chunks of the pairs at distance l1 until there are none left,
+		 *			or until the shared best delta cannot be improved at this distance.
+		 * @param	activeCount		Number of nodes (from the beginning of _nodesByFarthestPartner) that have a pair at distance l1 or more.
+		 */
+		void searchPairs(size_t l1, size_t activeCount, std::atomic<size_t>& nextPair, std::atomic<distance_t>& bestDoubleDelta, SearchResult& result) const;
+
+		/*
+		 * @brief	Builds the pairs of each node (_partners, _partnerOffsets), and the order of _nodesByFarthestPartner.
+		 */
+		void indexPartners();
+
+		//number of pairs taken by a thread at once in a search step
+		static const size_t PairsPerChunk = 16;
+		//number of rows read between checks for a stop request while loading the far-apart pairs
+		static const size_t RowsPerProgressCheck = 64;
+		//number of bytes for the candidate pairs kept while loading the far-apart pairs (beyond it, the rows are read in several passes)
+		static const unsigned long long PendingMemoryBudget = 1ULL << 28;
+
+		//number of threads to search with (unless limited - see IGraphAlg::setThreadLimit()), and the threads (created by the initialization)
+		unsigned int _threadCount;
+		std::shared_ptr<WorkerPool> _pool;
+
+		//eccentricity of each node
+		std::vector<compact_distance_t> _eccentricities;
+		//the far-apart pairs of node v are _partners[_partnerOffsets[v]] to _partners[_partnerOffsets[v+1]], farthest first
+		std::vector<Partner> _partners;
+		std::vector<size_t> _partnerOffsets;
+		//the nodes in decreasing order of their farthest far-apart partner
+		std::vector<unsigned int> _nodesByFarthestPartner;
+		//counters of the search
+		unsigned long long _evaluatedCount, _prunedCount;
+
+		//distances between every pair of nodes
+		distance_matrix_ptr_t _distances;
+		//number of far-apart pairs at each distance
+		std::vector<size_t> _pairCounts;
+		//element i holds the far-apart pairs at distance i, flattened (pair k is at 2k, 2k+1)
+		std::vector<std::vector<unsigned int>> _pairs;
+		//the distance of the pairs the next step starts from, and the distance at which the search ends (pairs at it or below cannot
+		//beat the best delta)
+		size_t _l1, _end;
+		//best delta found so far
+		delta_t _bestDelta;
 	};
 
 	extern "C" __declspec(dllexport) IGraphAlg* CreateAlgorithm();
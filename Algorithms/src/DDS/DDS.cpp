@@ -1,17 +1,18 @@
 #include "DDS.h"
 #include "Graph\defs.h"
 #include "Graph\GraphAlgorithms.h"
-#include "Graph\NodeDistances.h"
 #include "Algorithm\DeltaHyperbolicity.h"
 #include "Algorithm\HyperbolicityAlgorithms.h"
-#include <time.h>
+#include "Algorithm\FourPointKernel.h"
 #include <string>
+#include <thread>
+#include <algorithm>
 
 using namespace std;
 
 namespace hyperbolicity
 {
-	DDS::DDS() : IGraphAlg() 
+	DDS::DDS(unsigned int threadCount /* = 1 */, unsigned long long seed /* = 0 */) : IGraphAlg(), _threadCount(max(1u, threadCount)), _seed(seed)
 	{
 		//empty
 	}
@@ -23,36 +24,54 @@ namespace hyperbolicity
 
 	DeltaHyperbolicity DDS::stepImpl() 
 	{
-		HyperbolicityAlgorithms::DoubleSweepResult ds1 = HyperbolicityAlgorithms::doubleSweep(_graph);
-		HyperbolicityAlgorithms::DoubleSweepResult ds2 = HyperbolicityAlgorithms::doubleSweep(_graph);
-		
+		const CompactGraph& graph = *_compactGraph;
+		ParallelSampler::Sample best = _sampler->run(_threadCount, [&graph](ParallelSampler::Worker& worker, ParallelSampler::Sample& sample)
+		{
+			samplePair(graph, worker, sample);
+		});
+
+		node_combination_t state(_graph->getNode(best.nodes[0]), _graph->getNode(best.nodes[1]), _graph->getNode(best.nodes[2]), _graph->getNode(best.nodes[3]));
+		return DeltaHyperbolicity(best.doubleDelta / 2.0, state);
+	}
+
+	void DDS::samplePair(const CompactGraph& graph, ParallelSampler::Worker& worker, ParallelSampler::Sample& sample)
+	{
+		//rows 0 & 1 hold the distances from the first node of each double sweep, row 2 is scratch
+		compact_distance_t* ds1Dists = worker.rows[0].data();
+		compact_distance_t* ds2Dists = worker.rows[1].data();
+		compact_distance_t* otherDists = worker.rows[2].data();
+		HyperbolicityAlgorithms::CompactSweepResult ds1 = HyperbolicityAlgorithms::doubleSweep(graph, worker.bfs, worker.random, ds1Dists, otherDists);
+		HyperbolicityAlgorithms::CompactSweepResult ds2 = HyperbolicityAlgorithms::doubleSweep(graph, worker.bfs, worker.random, ds2Dists, otherDists);
+
 		unsigned int numOfTrials = 1;
 
 		while ( (ds1.u == ds2.u) || (ds1.v == ds2.u) || (ds1.u == ds2.v) || (ds1.v == ds2.v) || (ds1.u == ds1.v) || (ds2.u == ds2.v) )
 		{
 			if (numOfTrials >= MaxNumOfTrials) throw std::exception("Exceeded the maximal number of trials allowed!");
-			ds2 = HyperbolicityAlgorithms::doubleSweep(_graph);
+			ds2 = HyperbolicityAlgorithms::doubleSweep(graph, worker.bfs, worker.random, ds2Dists, otherDists);
 			++numOfTrials;
 		}
 
-		node_combination_t state(ds1.u, ds1.v, ds2.u, ds2.v);
 		//at this point we have the distances from ds1.u and ds2.u to all other nodes in the graph
 		//all we need to calculate the delta is the distance from ds1.v to ds2.v
-		NodeDistances distanceFromDs1v(_graph, ds1.v);
-		distance_t ds1vToDs2v = distanceFromDs1v.getDistance(ds2.v);
+		worker.bfs.run(ds1.v, otherDists);
 
 		//calculate the sum of distances of the three matchings for the 4 vertices
 		distance_t d1 = ds1.dist + ds2.dist;
-		distance_t d2 = ds1.uDistances[ds2.u->getIndex()] + ds1vToDs2v;
-		distance_t d3 = ds1.uDistances[ds2.v->getIndex()] + ds2.uDistances[ds1.v->getIndex()];
+		distance_t d2 = ds1Dists[ds2.u] + otherDists[ds2.v];
+		distance_t d3 = ds1Dists[ds2.v] + ds2Dists[ds1.v];
 
-		delta_t delta = HyperbolicityAlgorithms::calculateDeltaFromDistances(d1, d2, d3);
-		return DeltaHyperbolicity(delta, state);
+		sample.doubleDelta = FourPointKernel::doubleDelta(d1, d2, d3);
+		sample.nodes[0] = ds1.u;
+		sample.nodes[1] = ds1.v;
+		sample.nodes[2] = ds2.u;
+		sample.nodes[3] = ds2.v;
 	}
 
 	void DDS::initImpl(const node_combination_t&)
 	{
-		//empty
+		_compactGraph = compact_graph_ptr_t(new CompactGraph(_graph));
+		_sampler = parallel_sampler_ptr_t(new ParallelSampler(*_compactGraph, limitThreads(_threadCount), 3, _seed));
 	}
 
 	bool DDS::isComplete() const
@@ -65,10 +84,7 @@ namespace hyperbolicity
 
 	IGraphAlg* CreateAlgorithm()
 	{
-		//initialize random seed (necessary before calling doubleSweep() )
-		srand(static_cast<unsigned int>(time(nullptr)));
-
-		IGraphAlg* alg = new DDS();
+		IGraphAlg* alg = new DDS(thread::hardware_concurrency(), RandomStream::createSeed());
 		return alg;
 	}
 
@@ -76,4 +92,4 @@ namespace hyperbolicity
 	{
 		if (alg) delete alg;
 	}
-} // namespace hyperbolicity
\ No newline at end of file
+} // namespace hyperbolicity
@@ -7,6 +7,8 @@
 
 #include "Algorithm\IGraphAlg.h"
 #include "Algorithm\DeltaHyperbolicity.h"
+#include "Algorithm\ParallelSampler.h"
+#include "Graph\CompactGraph.h"
 #include <string>
 
 namespace hyperbolicity
@@ -15,11 +17,17 @@ namespace hyperbolicity
 	 * @brief	Implementation for the double-double-sweep algorithm. This algorithm runs a double-sweep on the graph,
 	 *			and then repeatedly runs another double-sweep until receiving 4 total different nodes. It then uses these
 	 *			4 nodes to calculate the delta hyperbolicity, and returns the result.
+	 *			Each step draws a pair of double sweeps on every thread in parallel (each thread with its own random stream), and returns
+	 *			the best.
 	 */
 	class DDS : public IGraphAlg
 	{
 	public:
-		DDS();
+		/*
+		 * @param	threadCount	Number of pairs of double sweeps drawn in parallel at each step.
+		 * @param	seed		The seed of the threads' random streams.
+		 */
+		explicit DDS(unsigned int threadCount = 1, unsigned long long seed = 0);
 		virtual ~DDS();
 
 	private:
@@ -30,8 +38,20 @@ namespace hyperbolicity
 		virtual void initImpl(const node_combination_t& initialState);
 		virtual bool isComplete() const;
 
+		/*
+		 * @brief	Draws a pair of double sweeps with 4 different nodes, using the rows of the given worker.
+		 * @throws	std::exception	If the maximal number of trials to get 4 different nodes is exceeded.
+		 */
+		static void samplePair(const CompactGraph& graph, ParallelSampler::Worker& worker, ParallelSampler::Sample& sample);
+
 		//The maximal number of trials to get 4 different nodes out of separate double-sweeps
 		static const unsigned int MaxNumOfTrials = 50;
+
+		unsigned int _threadCount;
+		unsigned long long _seed;
+		//snapshot of the graph for calculating distance rows, and the threads drawing the double sweeps
+		compact_graph_ptr_t _compactGraph;
+		parallel_sampler_ptr_t _sampler;
 	};
 
 	extern "C" __declspec(dllexport) IGraphAlg* CreateAlgorithm();
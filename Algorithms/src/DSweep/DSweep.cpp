@@ -2,16 +2,17 @@
 #include "Graph\defs.h"
 #include "Algorithm\DeltaHyperbolicity.h"
 #include "Algorithm\HyperbolicityAlgorithms.h"
+#include "Algorithm\FourPointKernel.h"
 #include "Graph\GraphAlgorithms.h"
-#include "Graph\NodeDistances.h"
-#include <time.h>
 #include <string>
+#include <thread>
+#include <algorithm>
 
 using namespace std;
 
 namespace hyperbolicity
 {
-	DSweep::DSweep() : IGraphAlg() 
+	DSweep::DSweep(unsigned int threadCount /* = 1 */, unsigned long long seed /* = 0 */) : IGraphAlg(), _threadCount(max(1u, threadCount)), _seed(seed)
 	{
 		//empty
 	}
@@ -23,26 +24,43 @@ namespace hyperbolicity
 
 	DeltaHyperbolicity DSweep::stepImpl() 
 	{
-		//first perform a double sweep
-		HyperbolicityAlgorithms::DoubleSweepResult ds = HyperbolicityAlgorithms::doubleSweep(_graph);
+		const CompactGraph& graph = *_compactGraph;
+		ParallelSampler::Sample best = _sampler->run(_threadCount, [&graph](ParallelSampler::Worker& worker, ParallelSampler::Sample& sample)
+		{
+			sampleSweep(graph, worker, sample);
+		});
+		if (best.doubleDelta < 0) throw std::exception("No node is balanced between the nodes of any of the double-sweeps");
 
-		node_ptr_t& v1 = ds.u;
-		node_ptr_t& v2 = ds.v;
-		distance_dict_t& v1Dists = ds.uDistances;
-		distance_dict_t v2Dists = NodeDistances(_graph, v2).getDistances();;
+		node_combination_t state(_graph->getNode(best.nodes[0]), _graph->getNode(best.nodes[1]), _graph->getNode(best.nodes[2]), _graph->getNode(best.nodes[3]));
+		return DeltaHyperbolicity(best.doubleDelta / 2.0, state);
+	}
 
-		distance_t distV1V2 = v1Dists[v2->getIndex()];
+	void DSweep::sampleSweep(const CompactGraph& graph, ParallelSampler::Worker& worker, ParallelSampler::Sample& sample)
+	{
+		const size_t size = graph.size();
+		compact_distance_t* v1Dists = worker.rows[0].data();
+		compact_distance_t* v2Dists = worker.rows[1].data();
+		compact_distance_t* v3Dists = worker.rows[2].data();
+
+		//first perform a double sweep (v3's row is not needed yet, so it holds the origin's distances meanwhile)
+		HyperbolicityAlgorithms::CompactSweepResult ds = HyperbolicityAlgorithms::doubleSweep(graph, worker.bfs, worker.random, v1Dists, v3Dists);
+		const node_index_t v1 = ds.u;
+		const node_index_t v2 = ds.v;
+		worker.bfs.run(v2, v2Dists);
+
+		distance_t distV1V2 = ds.dist;
 		distance_t distV1V3 = 0;
 		distance_t distV2V3 = 0;
-		node_ptr_collection_t v3Candidates;
+		node_index_t v3 = v1;
+		size_t v3CandidateCount = 0;
 
-		for (unsigned int i = 0; i < _graph->size(); ++i)
+		for (node_index_t i = 0; i < size; ++i)
 		{
-			node_ptr_t curNode = _graph->getNode(i);
-			if ( (curNode == v1) || (curNode == v2) ) continue;
+			if ( (i == v1) || (i == v2) ) continue;
+			if ( (CompactInfiniteDistance == v1Dists[i]) || (CompactInfiniteDistance == v2Dists[i]) ) continue;
 
-			distance_t distFromV1 = v1Dists[curNode->getIndex()];
-			distance_t distFromV2 = v2Dists[curNode->getIndex()];
+			distance_t distFromV1 = v1Dists[i];
+			distance_t distFromV2 = v2Dists[i];
 
 			if ( (distFromV1 <= distFromV2 && distFromV2 <= distFromV1 + 1) || (distFromV2 <= distFromV1 && distFromV1 <= distFromV2 + 1) )
 			{
@@ -53,50 +71,37 @@ namespace hyperbolicity
 						distV2V3 = distFromV2;
 						distV1V3 = distFromV1;
 
-						v3Candidates.clear();						
+						v3CandidateCount = 0;
 					}
-					v3Candidates.push_back(curNode);
+
+					//select one node from the v3 candidates (the k'th candidate replaces the selected one with probability 1/k)
+					if (0 == worker.random.nextIndex(++v3CandidateCount)) v3 = i;
 				}
 			}
 		}
-
-		//select one node from the v3 candidates
-		unsigned int index = rand() % v3Candidates.size();
-		node_ptr_t v3 = v3Candidates[index];
+		if (0 == v3CandidateCount) return;
 
 		//calculate distances for the newly selected v3
-		distance_dict_t v3Dists = NodeDistances(_graph, v3).getDistances();
-
-		node_ptr_t v4;
-		delta_t maxDelta = 0;
-		for (unsigned int i = 0; i < _graph->size(); ++i)
-		{
-			node_ptr_t curNode = _graph->getNode(i);
-			if ( (curNode == v1) || (curNode == v2) || (curNode == v3) ) continue;
-
-			distance_t distFromV1 = v1Dists[curNode->getIndex()];
-			distance_t distFromV2 = v2Dists[curNode->getIndex()];
-			distance_t distFromV3 = v3Dists[curNode->getIndex()];
-
-			distance_t d1 = distV1V2 + distFromV3;
-			distance_t d2 = distV1V3 + distFromV2;
-			distance_t d3 = distV2V3 + distFromV1;
-
-			delta_t curDelta = HyperbolicityAlgorithms::calculateDeltaFromDistances(d1, d2, d3);
-			if (curDelta > maxDelta)
-			{
-				maxDelta = curDelta;
-				v4 = curNode;
-			}
-		}
-
-		node_combination_t state(v1, v2, v3, v4);
-		return DeltaHyperbolicity(maxDelta, state);
+		distV1V3 = v1Dists[v3];
+		distV2V3 = v2Dists[v3];
+		worker.bfs.run(v3, v3Dists);
+
+		//scan all nodes for v4 (v1, v2 & v3 themselves yield 0, so they are only selected if no node does better - skip them in that case)
+		FourPointKernel::Result result = FourPointKernel::scanRows(distV1V2, v3Dists, distV1V3, v2Dists, distV2V3, v1Dists, size);
+		node_index_t v4 = result.index % size;
+		while ( (v4 == v1) || (v4 == v2) || (v4 == v3) ) v4 = (v4 + 1) % size;
+
+		sample.doubleDelta = result.doubleDelta;
+		sample.nodes[0] = v1;
+		sample.nodes[1] = v2;
+		sample.nodes[2] = v3;
+		sample.nodes[3] = v4;
 	}
 
 	void DSweep::initImpl(const node_combination_t&)
 	{
-		//empty
+		_compactGraph = compact_graph_ptr_t(new CompactGraph(_graph));
+		_sampler = parallel_sampler_ptr_t(new ParallelSampler(*_compactGraph, limitThreads(_threadCount), 3, _seed));
 	}
 
 	bool DSweep::isComplete() const
@@ -109,10 +114,7 @@ namespace hyperbolicity
 
 	IGraphAlg* CreateAlgorithm()
 	{
-		//initialize random seed (necessary before calling doubleSweep() ).
-		srand(static_cast<unsigned int>(time(nullptr)));
-
-		IGraphAlg* alg = new DSweep();
+		IGraphAlg* alg = new DSweep(thread::hardware_concurrency(), RandomStream::createSeed());
 		return alg;
 	}
 
@@ -120,4 +122,4 @@ namespace hyperbolicity
 	{
 		if (alg) delete alg;
 	}
-} // namespace hyperbolicity
\ No newline at end of file
+} // namespace hyperbolicity
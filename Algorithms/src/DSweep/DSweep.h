@@ -7,6 +7,8 @@
 
 #include "Algorithm\IGraphAlg.h"
 #include "Algorithm\DeltaHyperbolicity.h"
+#include "Graph\CompactGraph.h"
+#include "Algorithm\ParallelSampler.h"
 #include <string>
 
 namespace hyperbolicity
@@ -17,11 +19,16 @@ namespace hyperbolicity
 	 *			two nodes differ by at most 1 (e.g. distance from v1 is 5, from v2 is 6...). If there are many "furthest balanced" nodes,
 	 *			it chooses one randomly. Then, it simply goes over all nodes one more time, selecting the node that produces the maximal
 	 *			delta hyperbolicity value (at this point we already have all the distances from v1, v2, v3).
+	 *			Each step draws a double sweep on every thread in parallel (each thread with its own random stream), and returns the best.
 	 */
 	class DSweep : public IGraphAlg
 	{
 	public:
-		DSweep();
+		/*
+		 * @param	threadCount	Number of double sweeps drawn in parallel at each step.
+		 * @param	seed		The seed of the threads' random streams.
+		 */
+		explicit DSweep(unsigned int threadCount = 1, unsigned long long seed = 0);
 		virtual ~DSweep();
 
 	private:
@@ -32,8 +39,16 @@ namespace hyperbolicity
 		virtual void initImpl(const node_combination_t& initialState);
 		virtual bool isComplete() const;
 
-		//The maximal number of trials to get 4 different nodes out of separate double-sweeps
-		static const unsigned int MaxNumOfTrials = 50;
+		/*
+		 * @brief	Draws a single double sweep and completes it to a 4-tuple, using the rows of the given worker (those of v1, v2 & v3).
+		 */
+		static void sampleSweep(const CompactGraph& graph, ParallelSampler::Worker& worker, ParallelSampler::Sample& sample);
+
+		unsigned int _threadCount;
+		unsigned long long _seed;
+		//snapshot of the graph for calculating distance rows, and the threads drawing the double sweeps
+		compact_graph_ptr_t _compactGraph;
+		parallel_sampler_ptr_t _sampler;
 	};
 
 	extern "C" __declspec(dllexport) IGraphAlg* CreateAlgorithm();
@@ -0,0 +1,289 @@
+#include "GromovProduct.h"
+#include "Graph\defs.h"
+#include "Graph\Graph.h"
+#include "Algorithm\DeltaHyperbolicity.h"
+#include "Algorithm\State.h"
+#include "Graph\CompactGraph.h"
+#include <emmintrin.h>
+#include <time.h>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <climits>
+#include <thread>
+#include <exception>
+
+using namespace std;
+
+namespace hyperbolicity
+{
+	namespace
+	{
+		/*
+		 * @returns	The largest of the 16 bytes given.
+		 */
+		inline unsigned int horizontalMax(__m128i values)
+		{
+			values = _mm_max_epu8(values, _mm_srli_si128(values, 8));
+			values = _mm_max_epu8(values, _mm_srli_si128(values, 4));
+			values = _mm_max_epu8(values, _mm_srli_si128(values, 2));
+			values = _mm_max_epu8(values, _mm_srli_si128(values, 1));
+			return _mm_cvtsi128_si32(values) & 0xFF;
+		}
+	}
+
+	GromovProduct::GromovProduct(unsigned int threadCount /* = 1 */, unsigned int rootCount /* = DefaultRootCount */) : IGraphAlg(),
+		_threadCount(max(1u, threadCount)), _rootCount(max(1u, rootCount)), _processedCount(0), _doubleLowerBound(0), _doubleUpperBound(UINT_MAX)
+	{
+		//empty
+	}
+
+	GromovProduct::~GromovProduct()
+	{
+		//empty
+	}
+
+	bool GromovProduct::isComplete() const
+	{
+		//no root can improve on a lower bound that has reached the upper bound
+		const delta_t upperBound = currentUpperBound();
+		return ( (_processedCount >= _roots.size()) || ( (InfiniteDelta != upperBound) && (currentLowerBound() >= upperBound) ) );
+	}
+
+	string GromovProduct::getStatistics() const
+	{
+		stringstream statistics;
+		statistics << "roots processed: " << _processedCount << ", lower bound: " << _doubleLowerBound / 2.0 << ", upper bound: " << _doubleUpperBound / 2.0;
+		return statistics.str();
+	}
+
+	void GromovProduct::initImpl(const node_combination_t&)
+	{
+		_processedCount = 0;
+		_doubleLowerBound = 0;
+		_doubleUpperBound = UINT_MAX;
+		_roots.clear();
+		if (getProductsSize() > DistanceMatrixFactory::DefaultMemoryBudget)
+		{
+			throw std::exception("Graph is too large for the Gromov products of a root to fit in the memory budget");
+		}
+		_distances = DistanceMatrixFactory::create(_graph, DistanceMatrixFactory::DefaultMemoryBudget, [this](double progress) -> bool
+		{
+			reportProgress(progress);
+			return !isStopRequested();
+		});
+		if (nullptr == _distances.get()) return;
+
+		//a root's Gromov products fit in a byte only if it is close enough to every node - no node is if the diameter is more than twice
+		//that, and all are if the diameter itself is within it
+		const compact_distance_t diameter = _distances->getMaxDistance();
+		if (diameter > 2 * MaxRootDistance) throw std::exception("Graph diameter is too large for the Gromov products of any root to fit in a byte");
+
+		//random distinct roots, skipping those too far from some node
+		vector<node_index_t> candidates(_graph->size());
+		for (node_index_t u = 0; u < candidates.size(); ++u) candidates[u] = u;
+		random_shuffle(candidates.begin(), candidates.end());
+		vector<compact_distance_t> row(_graph->size());
+		for (auto it = candidates.cbegin(); (it != candidates.cend()) && (_roots.size() < _rootCount); ++it)
+		{
+			if (diameter > MaxRootDistance)
+			{
+				//the run is over - the roots selected so far are left as they are
+				if (isStopRequested()) return;
+				_distances->getRow(*it, row.data());
+				if (*max_element(row.cbegin(), row.cend()) > MaxRootDistance) continue;
+			}
+			_roots.push_back(*it);
+		}
+		if (_roots.empty()) throw std::exception("No node is close enough to every other node for its Gromov products to fit in a byte");
+	}
+
+	DeltaHyperbolicity GromovProduct::stepImpl()
+	{
+		//each root being processed holds its own matrix of Gromov products
+		//(initImpl() made sure at least one fits)
+		const size_t parallelRoots = static_cast<size_t>(min<unsigned long long>(limitThreads(_threadCount), DistanceMatrixFactory::DefaultMemoryBudget / getProductsSize()));
+		const size_t rootsBegin = _processedCount;
+		const size_t rootsEnd = min(_roots.size(), rootsBegin + parallelRoots);
+
+		vector<RootResult> results(rootsEnd - rootsBegin);
+		vector<exception_ptr> errors(results.size());
+		vector<thread> threads;
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			threads.push_back(thread([this, rootsBegin, i, &results, &errors]()
+			{
+				try
+				{
+					searchRoot(_roots[rootsBegin + i], results[i]);
+				}
+				catch (...)
+				{
+					errors[i] = current_exception();
+				}
+			}));
+		}
+		for (auto it = threads.begin(); it != threads.end(); ++it)
+		{
+			it->join();
+		}
+		for (auto it = errors.cbegin(); it != errors.cend(); ++it)
+		{
+			if (*it) rethrow_exception(*it);
+		}
+
+		//every root gives delta_r <= delta <= 2 * delta_r (a root whose search was stopped only gives the lower bound, and is not
+		//counted as processed)
+		const RootResult* best = nullptr;
+		bool isStopped = false;
+		for (auto it = results.cbegin(); it != results.cend(); ++it)
+		{
+			if ( it->hasNodes && ((nullptr == best) || (it->doubleDelta > best->doubleDelta)) ) best = &*it;
+			_doubleLowerBound = max(_doubleLowerBound, it->doubleDelta);
+			if (it->isComplete)
+			{
+				_doubleUpperBound = min(_doubleUpperBound, 2 * it->doubleDelta);
+			}
+			else
+			{
+				isStopped = true;
+			}
+		}
+		if (!isStopped) _processedCount = rootsEnd;
+		publishUpperBound(_doubleUpperBound / 2.0);
+
+		//only a step whose roots were all stopped before finding anything has no state
+		if (nullptr == best) return DeltaHyperbolicity();
+		node_combination_t state(_graph->getNode(best->nodes[0]), _graph->getNode(best->nodes[1]), _graph->getNode(best->nodes[2]), _graph->getNode(best->nodes[3]));
+		return DeltaHyperbolicity(best->doubleDelta / 2.0, state);
+	}
+
+	void GromovProduct::searchRoot(node_index_t root, RootResult& result) const
+	{
+		const size_t n = _graph->size();
+		//rows are padded to a multiple of 16 with zeros, which never affect the product
+		const size_t stride = (n + 15) / 16 * 16;
+
+		//twice the Gromov products - products[x * stride + y] = d(r, x) + d(r, y) - d(x, y)
+		vector<compact_distance_t> rootRow(n), row(n);
+		_distances->getRow(root, rootRow.data());
+		vector<unsigned char> products(n * stride, 0);
+		for (node_index_t x = 0; (x < n) && !isStopRequested(); ++x)
+		{
+			_distances->getRow(x, row.data());
+			unsigned char* fromX = &products[x * stride];
+			for (node_index_t y = 0; y < n; ++y)
+			{
+				fromX[y] = static_cast<unsigned char>(rootRow[x] + rootRow[y] - row[y]);
+			}
+		}
+
+		//for each tile, the (max, min) product over all middle nodes z, then its largest difference from the products themselves
+		//(the product is never below the products, as z = x gives min((x|x)_r, (x|y)_r) = (x|y)_r)
+		unsigned int bestDifference = 0;
+		node_index_t bestX = root, bestY = root;
+		vector<unsigned char> tile(RowsPerTile * ColumnsPerTile);
+		for (node_index_t xBegin = 0; (xBegin < n) && !isStopRequested(); xBegin += RowsPerTile)
+		{
+			const node_index_t xEnd = min(n, xBegin + RowsPerTile);
+			for (node_index_t yBegin = xBegin / ColumnsPerTile * ColumnsPerTile; yBegin < stride; yBegin += ColumnsPerTile)
+			{
+				const size_t width = min(stride, yBegin + ColumnsPerTile) - yBegin;
+				fill(tile.begin(), tile.end(), 0);
+				for (node_index_t zBegin = 0; zBegin < n; zBegin += DepthPerTile)
+				{
+					const node_index_t zEnd = min(n, zBegin + DepthPerTile);
+					for (node_index_t x = xBegin; x < xEnd; ++x)
+					{
+						const unsigned char* fromX = &products[x * stride];
+						__m128i* accumulated = reinterpret_cast<__m128i*>(&tile[(x - xBegin) * ColumnsPerTile]);
+						for (node_index_t z = zBegin; z < zEnd; ++z)
+						{
+							//min with 0 adds nothing
+							if (0 == fromX[z]) continue;
+							const __m128i fromXToZ = _mm_set1_epi8(static_cast<char>(fromX[z]));
+							const __m128i* fromZ = reinterpret_cast<const __m128i*>(&products[z * stride + yBegin]);
+							for (size_t c = 0; c < width / 16; ++c)
+							{
+								accumulated[c] = _mm_max_epu8(accumulated[c], _mm_min_epu8(fromXToZ, _mm_loadu_si128(fromZ + c)));
+							}
+						}
+					}
+				}
+
+				for (node_index_t x = xBegin; x < xEnd; ++x)
+				{
+					const __m128i* accumulated = reinterpret_cast<const __m128i*>(&tile[(x - xBegin) * ColumnsPerTile]);
+					const __m128i* fromX = reinterpret_cast<const __m128i*>(&products[x * stride + yBegin]);
+					__m128i differences = _mm_setzero_si128();
+					for (size_t c = 0; c < width / 16; ++c)
+					{
+						differences = _mm_max_epu8(differences, _mm_subs_epu8(accumulated[c], _mm_loadu_si128(fromX + c)));
+					}
+					if (horizontalMax(differences) <= bestDifference) continue;
+
+					//found a better pair - locate it
+					for (size_t c = 0; c < width; ++c)
+					{
+						unsigned int difference = tile[(x - xBegin) * ColumnsPerTile + c] - products[x * stride + yBegin + c];
+						if (difference <= bestDifference) continue;
+						bestDifference = difference;
+						bestX = x;
+						bestY = yBegin + c;
+					}
+				}
+			}
+		}
+
+		//the search is complete only if it was not stopped in the middle (a stop request is never withdrawn)
+		result.isComplete = !isStopRequested();
+		result.doubleDelta = bestDifference;
+		//nothing was found before the search was stopped
+		result.hasNodes = ( (0 != bestDifference) || result.isComplete );
+		if (!result.hasNodes) return;
+		if (0 == bestDifference)
+		{
+			//every 4-tuple holding the root has a delta of 0
+			result.nodes[0] = root;
+			for (node_index_t u = 0, i = 1; i < node_combination_t::size(); ++u)
+			{
+				if (u != root) result.nodes[i++] = u;
+			}
+			return;
+		}
+
+		//find the middle node of the best pair
+		const unsigned char* fromX = &products[bestX * stride];
+		node_index_t bestZ = 0;
+		for (node_index_t z = 0; z < n; ++z)
+		{
+			if (min(fromX[z], products[z * stride + bestY]) == products[bestX * stride + bestY] + bestDifference) bestZ = z;
+		}
+		result.nodes[0] = root;
+		result.nodes[1] = bestX;
+		result.nodes[2] = bestY;
+		result.nodes[3] = bestZ;
+	}
+
+	unsigned long long GromovProduct::getProductsSize() const
+	{
+		//rows are padded to a multiple of 16
+		return static_cast<unsigned long long>(_graph->size()) * ((_graph->size() + 15) / 16 * 16);
+	}
+
+
+
+	IGraphAlg* CreateAlgorithm()
+	{
+		//initialize random seed (roots are selected randomly)
+		srand(static_cast<unsigned int>(time(nullptr)));
+
+		IGraphAlg* alg = new GromovProduct(thread::hardware_concurrency());
+		return alg;
+	}
+
+	void ReleaseAlgorithm(IGraphAlg* alg)
+	{
+		if (alg) delete alg;
+	}
+} // namespace hyperbolicity
@@ -0,0 +1,99 @@
+/*
+ * Written by Eran Kravitz
+ * Email: kravitzer@gmail.com
+ */
+
+#pragma once
+
+#include "Algorithm\IGraphAlg.h"
+#include "Algorithm\DeltaHyperbolicity.h"
+#include "Graph\DistanceMatrix.h"
+#include <string>
+#include <vector>
+
+namespace hyperbolicity
+{
+	/*
+	 * @brief	Approximation based on a fixed root r: with the Gromov products (x|y)_r = (d(r, x) + d(r, y) - d(x, y)) / 2, delta_r is the
+	 *			largest min((x|z)_r, (z|y)_r) - (x|y)_r, i.e. the largest entry of the (max, min) product of the Gromov product matrix with
+	 *			itself, minus the matrix. delta_r is the largest delta of a 4-tuple holding r, and the graph's delta is between delta_r and
+	 *			2 * delta_r, so every root gives a lower bound (with the 4-tuple that produces it) and an upper bound.
+	 *			The doubled Gromov products of a root are kept in an n*n byte matrix, and the product is computed tile by tile with SSE2
+	 *			(16 entries at a time), only for the tiles on or above the diagonal (the product is symmetric). Each step processes several
+	 *			roots in parallel, one per thread, as many as the memory budget allows. Only nodes within MaxRootDistance of every other
+	 *			node are taken as roots.
+	 *			The upper bound is published to the other algorithms running on the graph, and the run stops once the lower bound meets it.
+	 *			Initialization stops early once asked to (see IGraphAlg::isStopRequested()) - while calculating the distances, and between
+	 *			the candidate roots. So does the search of a root, between rows of its products - its 4-tuple is still a lower bound, but
+	 *			it gives no upper bound.
+	 */
+	class GromovProduct : public IGraphAlg
+	{
+	public:
+		/*
+		 * @param	threadCount	Number of roots to process in parallel.
+		 * @param	rootCount	Number of roots to process in total.
+		 */
+		explicit GromovProduct(unsigned int threadCount = 1, unsigned int rootCount = DefaultRootCount);
+		virtual ~GromovProduct();
+		bool isComplete() const;
+
+		/*
+		 * @returns	The bounds on delta, given by the roots processed so far.
+		 */
+		virtual std::string getStatistics() const;
+
+	private:
+		/*
+		 * @brief	See documentation in IGraphAlg and in the class description above.
+		 */
+		virtual void initImpl(const node_combination_t&);
+		virtual DeltaHyperbolicity stepImpl();
+
+		/*
+		 * @brief	The result of a single root - twice delta_r, and the 4-tuple that produces it (if the search was stopped, the best
+		 *			4-tuple found before that, and isComplete is false - hasNodes is false if none was found).
+		 */
+		struct RootResult
+		{
+			unsigned int doubleDelta;
+			node_index_t nodes[4];
+			bool isComplete;
+			bool hasNodes;
+		};
+
+		/*
+		 * @brief	Computes delta_r of the given root, which must be within MaxRootDistance of every node.
+		 */
+		void searchRoot(node_index_t root, RootResult& result) const;
+
+		/*
+		 * @returns	The number of bytes of the Gromov products matrix of a single root.
+		 */
+		unsigned long long getProductsSize() const;
+
+		//default number of roots to process
+		static const unsigned int DefaultRootCount = 8;
+		//twice a Gromov product is at most twice the root's eccentricity, which must fit in a byte
+		static const compact_distance_t MaxRootDistance = 127;
+		//the product is computed in tiles of RowsPerTile x ColumnsPerTile entries, going over DepthPerTile middle nodes at a time
+		static const size_t RowsPerTile = 32;
+		static const size_t ColumnsPerTile = 1024;
+		static const size_t DepthPerTile = 128;
+
+		//number of roots to process in parallel, and in total
+		unsigned int _threadCount;
+		unsigned int _rootCount;
+		//the roots, in the order they are processed, and the number of roots processed so far
+		std::vector<node_index_t> _roots;
+		size_t _processedCount;
+		//twice the best bounds found so far
+		unsigned int _doubleLowerBound;
+		unsigned int _doubleUpperBound;
+		//distances between every pair of nodes
+		distance_matrix_ptr_t _distances;
+	};
+
+	extern "C" __declspec(dllexport) IGraphAlg* CreateAlgorithm();
+	extern "C" __declspec(dllexport) void ReleaseAlgorithm(IGraphAlg* alg);
+} // namespace hyperbolicity
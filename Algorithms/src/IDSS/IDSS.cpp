@@ -2,9 +2,9 @@
 #include "Graph\defs.h"
 #include "Algorithm\DeltaHyperbolicity.h"
 #include "Graph\GraphAlgorithms.h"
-#include "Graph\NodeDistances.h"
 #include "Algorithm\State.h"
 #include "Algorithm\HyperbolicityAlgorithms.h"
+#include "Algorithm\FourPointKernel.h"
 #include <time.h>
 #include <string>
 #include <unordered_map>
@@ -17,7 +17,7 @@ namespace hyperbolicity
 	const unsigned int DoubleSweepCacheSize = 500;
 	const float PercentageOfSweeps = 0.25;
 
-	IDSweepMinExt::IDSweepMinExt() : IGraphAlg(), _doubleSweeps(DoubleSweepCacheSize)
+	IDSweepMinExt::IDSweepMinExt() : IGraphAlg(), _doubleSweeps(DoubleSweepCacheSize), _random(RandomStream::createSeed(), 0)
 	{
 		//empty
 	}
@@ -33,29 +33,35 @@ namespace hyperbolicity
 		_doubleSweeps.clear();
 		_irremovableNodes.clear();
 		_nodeCountInSweeps.clear();
+		_distances = shared_ptr<DynamicDistances>(new DynamicDistances(_graph));
 	}
 
 	DeltaHyperbolicity IDSweepMinExt::stepImpl()
 	{
 		//first perform a double sweep
 		HyperbolicityAlgorithms::DoubleSweepResult ds = HyperbolicityAlgorithms::doubleSweep(_graph);
-		if (_doubleSweeps.size() + 1 > DoubleSweepCacheSize)
-		{
-			pair<node_index_t, node_index_t> earliestDs = _doubleSweeps.front();
-			--_nodeCountInSweeps[earliestDs.first];
-			--_nodeCountInSweeps[earliestDs.second];
-		}
+		bool isHistoryFull = (_doubleSweeps.size() + 1 > DoubleSweepCacheSize);
+		pair<node_index_t, node_index_t> earliestDs = (isHistoryFull ? _doubleSweeps.front() : pair<node_index_t, node_index_t>());
 		auto firstIt = _nodeCountInSweeps.find(ds.u->getIndex());
 		auto secondIt = _nodeCountInSweeps.find(ds.v->getIndex());
 		_nodeCountInSweeps[ds.u->getIndex()] = (firstIt == _nodeCountInSweeps.cend() ? 1 : firstIt->second + 1);
 		_nodeCountInSweeps[ds.v->getIndex()] = (secondIt == _nodeCountInSweeps.cend() ? 1 : secondIt->second + 1);
 		
 		_doubleSweeps.push_back(pair<node_index_t, node_index_t>(ds.u->getIndex(), ds.v->getIndex()));
+		if (isHistoryFull)
+		{
+			releaseSweepNode(earliestDs.first);
+			releaseSweepNode(earliestDs.second);
+		}
 
 		node_ptr_t& v1 = ds.u;
 		node_ptr_t& v2 = ds.v;
-		distance_dict_t& v1Dists = ds.uDistances;
-		distance_dict_t v2Dists = NodeDistances(_graph, v2).getDistances();
+
+		//get the distances from v1 & v2 (these are usually kept from previous sweeps, otherwise both are calculated in a single run)
+		node_index_t sweepNodes[] = {v1->getIndex(), v2->getIndex()};
+		_distances->loadRows(sweepNodes, 2);
+		const vector<compact_distance_t>& v1Dists = _distances->getRow(v1->getIndex());
+		const vector<compact_distance_t>& v2Dists = _distances->getRow(v2->getIndex());
 
 		distance_t distV1V2 = v1Dists[v2->getIndex()];
 		distance_t distV1V3 = MaxDistance;
@@ -68,45 +74,31 @@ namespace hyperbolicity
 			node_ptr_t curNode = _graph->getNode(i);
 			if ( (curNode == v1) || (curNode == v2) ) continue;
 
-			distance_t distFromV1 = v1Dists[curNode->getIndex()];
-			distance_t distFromV2 = v2Dists[curNode->getIndex()];
+			distance_t distFromV1 = (CompactInfiniteDistance == v1Dists[i] ? InfiniteDistance : v1Dists[i]);
+			distance_t distFromV2 = (CompactInfiniteDistance == v2Dists[i] ? InfiniteDistance : v2Dists[i]);
 
 			processV3Candidate(curNode, distFromV1, distFromV2);
 		}
 
 		//select one node from the v3 candidates
-		unsigned int index = rand() % _v3Candidates.size();
+		size_t index = _random.nextIndex(_v3Candidates.size());
 		node_ptr_t v3 = _v3Candidates[index];
 		distV1V3 = v1Dists[v3->getIndex()];
 		distV2V3 = v2Dists[v3->getIndex()];
 
 		//calculate distances for the newly selected v3
-		distance_dict_t v3Dists = NodeDistances(_graph, v3).getDistances();
+		const vector<compact_distance_t>& v3Dists = _distances->getRow(v3->getIndex());
 
-		node_ptr_t v4;
-		delta_t maxDelta = -1;
-		for (unsigned int i = 0; i < _graph->size(); ++i)
-		{
-			node_ptr_t curNode = _graph->getNode(i);
-			if ( (curNode == v1) || (curNode == v2) || (curNode == v3) ) continue;
+		//scan all nodes for v4 (nodes unreachable from v1, v2 or v3 are skipped by the kernel, and v1, v2 & v3 themselves yield 0,
+		//so they are only selected if no node does better - skip them in that case)
+		FourPointKernel::Result result = FourPointKernel::scanRows(distV1V2, v3Dists.data(), distV1V3, v2Dists.data(), distV2V3, v1Dists.data(), _graph->size());
+		node_index_t v4Index = result.index % _graph->size();
+		while ( (v4Index == v1->getIndex()) || (v4Index == v2->getIndex()) || (v4Index == v3->getIndex()) ) v4Index = (v4Index + 1) % _graph->size();
+		node_ptr_t v4 = _graph->getNode(v4Index);
+		delta_t maxDelta = result.doubleDelta / 2.0;
 
-			distance_t distFromV1 = v1Dists[curNode->getIndex()];
-			distance_t distFromV2 = v2Dists[curNode->getIndex()];
-			distance_t distFromV3 = v3Dists[curNode->getIndex()];
-
-            if ( (InfiniteDistance == distFromV1) || (InfiniteDistance == distFromV2) || (InfiniteDistance == distFromV3) ) continue;
-
-			distance_t d1 = distV1V2 + distFromV3;
-			distance_t d2 = distV1V3 + distFromV2;
-			distance_t d3 = distV2V3 + distFromV1;
-
-			delta_t curDelta = HyperbolicityAlgorithms::calculateDeltaFromDistances(d1, d2, d3);
-			if (curDelta > maxDelta)
-			{
-				maxDelta = curDelta;
-				v4 = curNode;
-			}
-		}
+		//keep v3's row only if it is also part of the double-sweep history
+		if (_nodeCountInSweeps.cend() == _nodeCountInSweeps.find(v3->getIndex())) _distances->removeRow(v3->getIndex());
 
 		//just before returning the results, see if we can remove cycles
 		node_ptr_t nodeFromCycle = _graph->getNode(0);
@@ -151,8 +143,8 @@ namespace hyperbolicity
 
 				if (isCycleRemoved)
 				{
-					_doubleSweeps.clear();
-					_nodeCountInSweeps.clear();
+					//removing a cycle never changes distances between the remaining nodes, so rows and history are only remapped
+					remapSweeps(_distances->synchronize(true));
 					//cycle found - break out of the loop as we do not wish to remove more than one cycle at once
 					break;
 				}
@@ -162,4 +154,37 @@ namespace hyperbolicity
 		node = bestNode;
 		return bestDelta;
 	}
+
+	void IDSweepMinExt::remapSweeps(const vector<node_index_t>& mapping)
+	{
+		boost::circular_buffer<pair<node_index_t, node_index_t>> remapped(DoubleSweepCacheSize);
+		_nodeCountInSweeps.clear();
+		for (auto it = _doubleSweeps.cbegin(); it != _doubleSweeps.cend(); ++it)
+		{
+			node_index_t first = mapping[it->first];
+			node_index_t second = mapping[it->second];
+			if ( (DynamicDistances::DeletedNode == first) || (DynamicDistances::DeletedNode == second) ) continue;
+
+			remapped.push_back(pair<node_index_t, node_index_t>(first, second));
+			++_nodeCountInSweeps[first];
+			++_nodeCountInSweeps[second];
+		}
+		_doubleSweeps.swap(remapped);
+
+		//a sweep node whose partner was removed may no longer appear in the history
+		for (node_index_t i = 0; i < _graph->size(); ++i)
+		{
+			if (_distances->hasRow(i) && _nodeCountInSweeps.cend() == _nodeCountInSweeps.find(i)) _distances->removeRow(i);
+		}
+	}
+
+	void IDSweepMinExt::releaseSweepNode(node_index_t node)
+	{
+		auto it = _nodeCountInSweeps.find(node);
+		if (0 == --it->second)
+		{
+			_nodeCountInSweeps.erase(it);
+			_distances->removeRow(node);
+		}
+	}
 } // namespace hyperbolicity
\ No newline at end of file
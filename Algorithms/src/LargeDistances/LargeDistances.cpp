@@ -1,13 +1,19 @@
 #include "LargeDistances.h"
 #include "Graph\defs.h"
+#include "Graph\Graph.h"
 #include "Algorithm\DeltaHyperbolicity.h"
 #include "Graph\GraphAlgorithms.h"
-#include "Graph\NodeDistances.h"
 #include "Graph\FurthestNode.h"
 #include "Algorithm\HyperbolicityAlgorithms.h"
+#include "Algorithm\FourPointKernel.h"
 #include <time.h>
 #include <string>
+#include <sstream>
 #include <vector>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <exception>
 #include <math.h>
 
 using namespace std;
@@ -16,9 +22,11 @@ const unsigned int MinDistanceDifferenceFromDistanceFound = 4;
 
 namespace hyperbolicity
 {
-	LargeDistances::LargeDistances() : IGraphAlg(), _minDistance(0), _isComplete(false), _minNumberOfPairs(0)
+	LargeDistances::LargeDistances(unsigned int threadCount /* = 1 */, unsigned long long memoryBudget /* = DistanceMatrixFactory::DefaultMemoryBudget */) :
+		IGraphAlg(), _threadCount(max(1u, threadCount)), _memoryBudget(memoryBudget), _maxPairs(0), _maxRows(0), _pairsCollected(0), _minDistance(0),
+		_evaluatedCount(0), _isComplete(false)
 	{
-		
+		//empty
 	}
 
 	LargeDistances::~LargeDistances()
@@ -26,122 +34,244 @@ namespace hyperbolicity
 		//empty
 	}
 
+	string LargeDistances::getStatistics() const
+	{
+		stringstream statistics;
+		statistics << "rows: " << _rows.size() << ", pairs: " << _pairsCollected << ", pairs of pairs evaluated: " << _evaluatedCount;
+		return statistics.str();
+	}
+
 	void LargeDistances::initImpl(const node_combination_t&)
 	{
 		node_index_t randNode = rand() % _graph->size();
 		FurthestNode fn(_graph, _graph->getNode(randNode));
 		node_ptr_collection_t furthestNodes = fn.getFurthestNodes();
 
-		_nodeSet.clear();
-		node_index_t originNode = furthestNodes[rand() % furthestNodes.size()]->getIndex();
-		_nodeSet.insert(originNode);
-		NodeDistances distanceCalc(_graph, _graph->getNode(originNode));
-		_dists[originNode] = distanceCalc.getDistances();
-		_minNumberOfPairs = static_cast<unsigned int>(_graph->size() * sqrt(_graph->size()));
+		//half of the budget goes to the rows, the other half to the pairs - each pair is kept in its bucket, and again (along with its
+		//distance) in the flattened arrays of the step
+		const size_t size = _graph->size();
+		const size_t pairSize = 2 * sizeof(pair<node_index_t, node_index_t>) + sizeof(compact_distance_t);
+		_maxRows = max<size_t>(2, static_cast<size_t>(_memoryBudget / 2 / (size * sizeof(compact_distance_t))));
+		_maxPairs = static_cast<size_t>(min<unsigned long long>(static_cast<unsigned long long>(size * sqrt(size)), _memoryBudget / 2 / pairSize));
+
+		_compactGraph = compact_graph_ptr_t(new CompactGraph(_graph));
+		_bfs = shared_ptr<MultiSourceBFS>(new MultiSourceBFS(*_compactGraph));
+		_rows.clear();
+		_rowIndices.assign(size, static_cast<unsigned int>(NoRow));
+		_isProcessed.assign(size, false);
+		_pairsByDistance.clear();
 		_pairsCollected = 0;
+		_minDistance = 0;
+		_evaluatedCount = 0;
+		_isComplete = false;
+
+		_nodeQueue.clear();
+		node_index_t originNode = furthestNodes[rand() % furthestNodes.size()]->getIndex();
+		calculateDistances(originNode);
+		_nodeQueue.push_back(originNode);
 	}
 
-	DeltaHyperbolicity LargeDistances::stepImpl()
-	{	
-		while ((_pairsCollected <= _minNumberOfPairs) && (_nodeSet.size() > 0))
+	bool LargeDistances::collectPairs()
+	{
+		while ((_pairsCollected <= _maxPairs) && (_nodeQueue.size() > 0))
 		{
-			auto nodeIt = _nodeSet.cbegin();
-			node_index_t nextNodeIndex = *nodeIt;
-			_nodeSet.erase(nodeIt);
-			_processedNodeSet.insert(nextNodeIndex);
+			if (isStopRequested()) return false;
 
-			if (_dists.cend() == _dists.find(nextNodeIndex)) throw exception("Distance vector doesn't exist for node");
-			auto& distances = _dists[nextNodeIndex];
+			node_index_t nextNodeIndex = _nodeQueue.front();
+			_nodeQueue.pop_front();
+			_isProcessed[nextNodeIndex] = true;
+			const compact_distance_t* distances = getRow(nextNodeIndex);
 
-			for (distance_dict_t::const_iterator it = _dists[nextNodeIndex].cbegin(); it != _dists[nextNodeIndex].cend(); ++it)
+			for (node_index_t curIndex = 0; curIndex < _compactGraph->size(); ++curIndex)
 			{
-				node_index_t curIndex = it->first;
+				//a processed node already collected its pair with this one
+				if ( (CompactInfiniteDistance == distances[curIndex]) || (0 == distances[curIndex]) || (_isProcessed[curIndex]) ) continue;
+				distance_t curDistance = distances[curIndex];
 
-				if (static_cast<unsigned int>(it->second) > _minDistance + MinDistanceDifferenceFromDistanceFound)
+				if (static_cast<unsigned int>(curDistance) > _minDistance + MinDistanceDifferenceFromDistanceFound)
 				{
-					//new maximal distance is found in graph! 
-				
-					//remove distances that are now outside the range
-					for (distance_t curDistance = _minDistance; static_cast<unsigned int>(curDistance) < it->second - MinDistanceDifferenceFromDistanceFound; ++curDistance)
+					//new maximal distance is found in graph! remove distances that are now outside the range, and store new minimal distance
+					const distance_t newMinDistance = curDistance - MinDistanceDifferenceFromDistanceFound;
+					for (distance_t removedDistance = _minDistance; (removedDistance < newMinDistance) && (static_cast<size_t>(removedDistance) < _pairsByDistance.size()); ++removedDistance)
 					{
-						_pairsByDistance.erase(curDistance);
+						_pairsCollected -= _pairsByDistance[removedDistance].size();
+						vector<pair<node_index_t, node_index_t>>().swap(_pairsByDistance[removedDistance]);
 					}
+					_minDistance = newMinDistance;
+				}
+				else if (curDistance < _minDistance)
+				{
+					//distance is out of range, keep iteration
+					continue;
+				}
+
+				//the distance is in range - keep the pair, as long as the other node has (or can get) a row, and add the new node to queue
+				//(getting a row is a BFS, so the stop request is checked before each one as well)
+				const bool isNew = (NoRow == _rowIndices[curIndex]);
+				if (isNew)
+				{
+					reportProgress(0.5 * min(1.0, static_cast<double>(_pairsCollected) / max<size_t>(1, _maxPairs)));
+					if (isStopRequested()) return false;
+				}
+				if (!calculateDistances(curIndex)) continue;
+				if (isNew) _nodeQueue.push_back(curIndex);
 
-					//store new minimal distance
-					_minDistance = it->second - MinDistanceDifferenceFromDistanceFound;
+				if (_pairsByDistance.size() <= static_cast<size_t>(curDistance)) _pairsByDistance.resize(curDistance + 1);
+				_pairsByDistance[curDistance].push_back(pair<node_index_t, node_index_t>(nextNodeIndex, curIndex));
+				++_pairsCollected;
+			}
+		}
+		return true;
+	}
 
-					//add pair to pair map
-					_pairsByDistance[it->second].push_back(std::pair<node_index_t, node_index_t>(nextNodeIndex, it->first));
-					++_pairsCollected;
-					//add new node to queue
-					if (0 == _processedNodeSet.count(it->first) && _dists.cend() == _dists.find(it->first))
-					{
-						_nodeSet.insert(it->first);
-						NodeDistances distanceCalc(_graph, _graph->getNode(it->first));
-						_dists[it->first] = distanceCalc.getDistances();
-					}
+	DeltaHyperbolicity LargeDistances::stepImpl()
+	{
+		//the pairs are collected in the first half of the step, and matched in the second - a step that was stopped leaves the
+		//algorithm incomplete, with the best 4-tuple found so far
+		if (!collectPairs()) return DeltaHyperbolicity();
+
+		//flatten the pairs by decreasing distance, keeping their distances, so pairs of pairs can be evaluated in batches
+		vector<pair<node_index_t, node_index_t>> pairs;
+		vector<compact_distance_t> pairDistances;
+		pairs.reserve(_pairsCollected);
+		pairDistances.reserve(_pairsCollected);
+		for (size_t distance = _pairsByDistance.size(); distance-- > static_cast<size_t>(_minDistance); )
+		{
+			const vector<pair<node_index_t, node_index_t>>& bucket = _pairsByDistance[distance];
+			pairs.insert(pairs.end(), bucket.cbegin(), bucket.cend());
+			pairDistances.insert(pairDistances.end(), bucket.size(), static_cast<compact_distance_t>(distance));
+		}
+
+		//the best delta is shared as twice its value, so that it can be compared & swapped as an integer (only 4-tuples that beat the
+		//lower bound matter)
+		atomic<size_t> nextPair(0);
+		atomic<distance_t> bestDoubleDelta(static_cast<distance_t>(2 * currentLowerBound()));
+		const unsigned int threadCount = limitThreads(_threadCount);
+		vector<SearchResult> results(threadCount);
+		vector<exception_ptr> errors(threadCount);
+		vector<thread> threads;
+		for (unsigned int i = 0; i < threadCount; ++i)
+		{
+			threads.push_back(thread([this, i, &pairs, &pairDistances, &nextPair, &bestDoubleDelta, &results, &errors]()
+			{
+				try
+				{
+					searchPairs(pairs, pairDistances, nextPair, bestDoubleDelta, results[i]);
 				}
-				else if (static_cast<unsigned int>(it->second) >= static_cast<unsigned int>(_minDistance) && static_cast<unsigned int>(it->second) <= static_cast<unsigned int>(_minDistance )+ MinDistanceDifferenceFromDistanceFound)
+				catch (...)
 				{
-					//distance is in range, keep the pair
-					_pairsByDistance[it->second].push_back(std::pair<node_index_t, node_index_t>(nextNodeIndex, it->first));
-					++_pairsCollected;
-					//add new node to queue
-					if (0 == _processedNodeSet.count(it->first) && _dists.cend() == _dists.find(it->first))
-					{
-						_nodeSet.insert(it->first);
-						NodeDistances distanceCalc(_graph, _graph->getNode(it->first));
-						_dists[it->first] = distanceCalc.getDistances();
-					}
+					//the other threads are stopped by taking the rest of the pairs
+					errors[i] = current_exception();
+					nextPair = pairs.size();
 				}
-				//else do nothing, keep iteration
-			}
+			}));
+		}
+		for (auto it = threads.begin(); it != threads.end(); ++it)
+		{
+			it->join();
+		}
+		for (auto it = errors.cbegin(); it != errors.cend(); ++it)
+		{
+			if (*it) rethrow_exception(*it);
 		}
 
+		const SearchResult* best = &results.front();
+		for (auto it = results.cbegin(); it != results.cend(); ++it)
+		{
+			_evaluatedCount += it->evaluatedCount;
+			if (it->doubleDelta > best->doubleDelta) best = &*it;
+		}
+
+		_isComplete = !isStopRequested();
+		reportProgress(_isComplete ? 1 : 0.5 + 0.5 * min(1.0, static_cast<double>(nextPair) / max<size_t>(1, pairs.size())));
+		//nothing beat the lower bound
+		if (best->doubleDelta < 0) return DeltaHyperbolicity();
+
+		return DeltaHyperbolicity(best->doubleDelta / 2.0, node_combination_t(_graph->getNode(best->nodes[0]), _graph->getNode(best->nodes[1]),
+																			  _graph->getNode(best->nodes[2]), _graph->getNode(best->nodes[3])));
+	}
 
-		delta_t bestDelta = 0;
-		node_combination_t bestState;
-		//iterate all pairs of pairs of nodes and calculate their delta
-		for (auto it1 = _pairsByDistance.cbegin(); it1 != _pairsByDistance.cend(); ++it1)
+	void LargeDistances::searchPairs(const vector<pair<node_index_t, node_index_t>>& pairs, const vector<compact_distance_t>& pairDistances,
+									 atomic<size_t>& nextPair, atomic<distance_t>& bestDoubleDelta, SearchResult& result) const
+	{
+		result.doubleDelta = -1;
+		result.evaluatedCount = 0;
+		vector<compact_distance_t> firstDistance(PairsPerBlock), d2First(PairsPerBlock), d2Second(PairsPerBlock), d3First(PairsPerBlock), d3Second(PairsPerBlock);
+
+		for (size_t begin = nextPair.fetch_add(PairsPerChunk); begin < pairs.size(); begin = nextPair.fetch_add(PairsPerChunk))
 		{
-			for (auto it2 = it1; it2 != _pairsByDistance.cend(); ++it2)
+			if (isStopRequested()) return;
+
+			for (size_t i1 = begin; i1 < min(pairs.size(), begin + PairsPerChunk); ++i1)
 			{
-				for (unsigned int i1 = 0; i1 < it1->second.size(); ++i1)
+				//only pairs farther than twice the best delta can be part of a better 4-tuple - they are the first ones
+				const distance_t h = bestDoubleDelta;
+				const size_t end = lower_bound(pairDistances.cbegin(), pairDistances.cend(), static_cast<compact_distance_t>(min<distance_t>(h, CompactInfiniteDistance)),
+											   greater<compact_distance_t>()) - pairDistances.cbegin();
+				//pairs are sorted, so no pair from here on has better ones to match
+				if (i1 + 1 >= end) return;
+
+				//gather the distances to the following pairs and evaluate them together, a block at a time
+				const compact_distance_t* fromFirst = getRow(pairs[i1].first);
+				const compact_distance_t* fromSecond = getRow(pairs[i1].second);
+				fill(firstDistance.begin(), firstDistance.end(), pairDistances[i1]);
+				size_t bestIndex = pairs.size();
+				for (size_t blockBegin = i1 + 1; blockBegin < end; blockBegin += PairsPerBlock)
 				{
-					unsigned int initialIndex = (it1 == it2 ? i1+1 : 0);
-					for (unsigned int i2 = initialIndex; i2 < it2->second.size(); ++i2)
+					const size_t count = min<size_t>(end - blockBegin, static_cast<size_t>(PairsPerBlock));
+					for (size_t c = 0; c < count; ++c)
 					{
-						if (0 == _dists.count(it1->second[i1].first) ||
-							0 == _dists.count(it1->second[i1].second) ||
-							0 == _dists.count(it2->second[i2].first) ||
-							0 == _dists.count(it2->second[i2].first)) throw exception("Distances do not exist for this node!");
-
-						//calculate d1, d2, d3 and then delta
-						unsigned int d1 = _dists[it1->second[i1].first][it1->second[i1].second] + _dists[it2->second[i2].first][it2->second[i2].second];
-						unsigned int d2 = _dists[it1->second[i1].first][it2->second[i2].first] + _dists[it1->second[i1].second][it2->second[i2].second];
-						unsigned int d3 = _dists[it1->second[i1].first][it2->second[i2].second] + _dists[it2->second[i2].first][it1->second[i1].second];
-						delta_t curDelta = HyperbolicityAlgorithms::calculateDeltaFromDistances(d1, d2, d3);
-
-						if (curDelta > bestDelta)
-						{
-							bestDelta = curDelta;
-							bestState.reset(_graph->getNode(it1->second[i1].first), _graph->getNode(it1->second[i1].second),
-											_graph->getNode(it2->second[i2].first), _graph->getNode(it2->second[i2].second));
-						}
+						const pair<node_index_t, node_index_t>& other = pairs[blockBegin + c];
+						d2First[c] = fromFirst[other.first];
+						d2Second[c] = fromSecond[other.second];
+						d3First[c] = fromFirst[other.second];
+						d3Second[c] = fromSecond[other.first];
 					}
+
+					FourPointKernel::Result kernelResult = FourPointKernel::scanPairs(firstDistance.data(), pairDistances.data() + blockBegin,
+						d2First.data(), d2Second.data(), d3First.data(), d3Second.data(), count);
+					result.evaluatedCount += count;
+					if ( (kernelResult.index >= count) || (kernelResult.doubleDelta <= max(h, result.doubleDelta)) ) continue;
+
+					result.doubleDelta = kernelResult.doubleDelta;
+					bestIndex = blockBegin + kernelResult.index;
 				}
+				if (pairs.size() == bestIndex) continue;
+
+				const pair<node_index_t, node_index_t>& other = pairs[bestIndex];
+				result.nodes[0] = pairs[i1].first;
+				result.nodes[1] = pairs[i1].second;
+				result.nodes[2] = other.first;
+				result.nodes[3] = other.second;
+
+				//publish it to the other threads, unless one of them has already found better
+				distance_t shared = bestDoubleDelta;
+				while ( (result.doubleDelta > shared) && !bestDoubleDelta.compare_exchange_weak(shared, result.doubleDelta) );
 			}
 		}
-
-		_isComplete = true;
-		return DeltaHyperbolicity(bestDelta, bestState);
 	}
-	
+
 	bool LargeDistances::isComplete() const
 	{
 		return _isComplete;
 	}
 
+	bool LargeDistances::calculateDistances(node_index_t node)
+	{
+		if (NoRow != _rowIndices[node]) return true;
+		if (_rows.size() >= _maxRows) return false;
+
+		_rowIndices[node] = static_cast<unsigned int>(_rows.size());
+		_rows.push_back(vector<compact_distance_t>(_compactGraph->size()));
+		_bfs->run(node, _rows.back().data());
+		return true;
+	}
+
+	const compact_distance_t* LargeDistances::getRow(node_index_t node) const
+	{
+		return _rows[_rowIndices[node]].data();
+	}
+
 
 
 	IGraphAlg* CreateAlgorithm()
@@ -149,7 +279,7 @@ namespace hyperbolicity
 		//initialize random seed (necessary before calling doubleSweep() )
 		srand(static_cast<unsigned int>(time(nullptr)));
 
-		IGraphAlg* alg = new LargeDistances();
+		IGraphAlg* alg = new LargeDistances(thread::hardware_concurrency());
 		return alg;
 	}
 
@@ -157,4 +287,4 @@ namespace hyperbolicity
 	{
 		if (alg) delete alg;
 	}
-} // namespace hyperbolicity
\ No newline at end of file
+} // namespace hyperbolicity
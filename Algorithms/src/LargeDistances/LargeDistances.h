@@ -8,8 +8,13 @@
 #include "Algorithm\IGraphAlg.h"
 #include "Algorithm\DeltaHyperbolicity.h"
 #include "Graph\GraphAlgorithms.h"
+#include "Graph\CompactGraph.h"
+#include "Graph\MultiSourceBFS.h"
+#include "Graph\DistanceMatrix.h"
 #include <string>
-#include <unordered_set>
+#include <vector>
+#include <deque>
+#include <atomic>
 
 namespace hyperbolicity
 {
@@ -18,13 +23,28 @@ namespace hyperbolicity
 	 *			distances of up to the max. distance - some constant. It adds all these nodes to a queue and then calculates distances from these nodes,
 	 *			keeping those distances as well and adding these vertices to the queue. It stops when it reaches some number of distances (parameter),
 	 *			and then calculates the delta on each of the pairs.
+	 *			The distance rows are kept in a store bounded by a memory budget (a node whose row does not fit is not added to the queue),
+	 *			and the pairs in buckets by distance. Pairs of pairs are evaluated in parallel, from the farthest pair down: a 4-tuple
+	 *			whose largest sum comes from two pairs has delta at most half the smaller pair's distance, so a pair is only matched with
+	 *			the pairs farther than twice the best delta found so far, and the search ends once no pair is.
+	 *			The single step stops early once asked to (see IGraphAlg::isStopRequested()) - between expanded nodes while collecting,
+	 *			and between chunks of pairs while matching.
 	 */
 	class LargeDistances : public IGraphAlg
 	{
 	public:
-		LargeDistances();
+		/*
+		 * @param	threadCount		Number of threads evaluating pairs of pairs.
+		 * @param	memoryBudget	Number of bytes for the distance rows and the pairs (collected & flattened).
+		 */
+		explicit LargeDistances(unsigned int threadCount = 1, unsigned long long memoryBudget = DistanceMatrixFactory::DefaultMemoryBudget);
 		virtual ~LargeDistances();
 
+		/*
+		 * @returns	The number of rows calculated, pairs collected and pairs of pairs evaluated.
+		 */
+		virtual std::string getStatistics() const;
+
 	private:
 		/*
 		 * @brief	See documentation in IGraphAlg and in the class description above.
@@ -33,21 +53,72 @@ namespace hyperbolicity
 		virtual void initImpl(const node_combination_t& initialState);
 		virtual bool isComplete() const;
 
-		//the minimal number of pairs to collect
-		unsigned int _minNumberOfPairs;
-		//pairs collected so far
-		std::unordered_map<distance_t, std::vector<std::pair<node_index_t, node_index_t> > > _pairsByDistance;
-		//number of pairs in pair map
-		unsigned int _pairsCollected;
+		/*
+		 * @brief	Calculates the distance row of the given node (if not calculated yet), if the budget allows.
+		 * @returns	True if the node has a row.
+		 */
+		bool calculateDistances(node_index_t node);
+
+		/*
+		 * @brief	Expands the nodes in the queue, collecting their pairs in the distance range, until there are enough pairs.
+		 * @returns	False if it was stopped before that.
+		 */
+		bool collectPairs();
+
+		/*
+		 * @brief	The best 4-tuple found by a single thread (doubleDelta is -1 if it found none better than the shared best), and the
+		 *			number of pairs of pairs it evaluated.
+		 */
+		struct SearchResult
+		{
+			distance_t doubleDelta;
+			node_index_t nodes[4];
+			unsigned long long evaluatedCount;
+		};
+
+		/*
+		 * @brief	Matches pairs taken from nextPair (in chunks) with the following pairs, until no pair can improve on the shared best.
+		 * @param	pairs			The pairs, by decreasing distance.
+		 * @param	pairDistances	The distance of each pair.
+		 */
+		void searchPairs(const std::vector<std::pair<node_index_t, node_index_t>>& pairs, const std::vector<compact_distance_t>& pairDistances,
+						 std::atomic<size_t>& nextPair, std::atomic<distance_t>& bestDoubleDelta, SearchResult& result) const;
+
+		/*
+		 * @returns	The row of the given node, which must have one.
+		 */
+		const compact_distance_t* getRow(node_index_t node) const;
+
+		//pairs of pairs are handed to the threads in chunks of this many first pairs
+		static const size_t PairsPerChunk = 16;
+		//number of following pairs a first pair is evaluated with at once (the size of every thread's scratch arrays)
+		static const size_t PairsPerBlock = 4096;
+		//no row
+		static const unsigned int NoRow = static_cast<unsigned int>(-1);
+
+		unsigned int _threadCount;
+		unsigned long long _memoryBudget;
+
+		//the maximal number of pairs to collect, and of rows to calculate
+		size_t _maxPairs;
+		size_t _maxRows;
+		//pairs collected so far, by distance (only distances from _minDistance up are kept), and their number
+		std::vector<std::vector<std::pair<node_index_t, node_index_t>>> _pairsByDistance;
+		size_t _pairsCollected;
 		//the minimal distance to start collecting pairs from
 		distance_t _minDistance;
-		//distances for each node whose distance vector was calculated
-		std::unordered_map<node_index_t, distance_dict_t> _dists;
-		//set of nodes to run on next
-		std::unordered_set<node_index_t> _nodeSet;
-		//set of nodes already processed
-		std::unordered_set<node_index_t> _processedNodeSet;
 
+		//the rows calculated so far, and the index of each node's row in them (NoRow if it has none)
+		std::vector<std::vector<compact_distance_t>> _rows;
+		std::vector<unsigned int> _rowIndices;
+		//snapshot of the graph for calculating distance rows
+		compact_graph_ptr_t _compactGraph;
+		std::shared_ptr<MultiSourceBFS> _bfs;
+		//nodes to run on next (all of which have rows), and whether each node was already processed
+		std::deque<node_index_t> _nodeQueue;
+		std::vector<bool> _isProcessed;
+
+		unsigned long long _evaluatedCount;
 		//this algorithm has no steps - it is either complete or not... when initialized, this boolean is false. After running it is set to true.
 		bool _isComplete;
 	};
@@ -1,18 +1,22 @@
 #include "MDS.h"
 #include "Graph\defs.h"
+#include "Graph\Graph.h"
 #include "Algorithm\DeltaHyperbolicity.h"
-#include "Graph\GraphAlgorithms.h"
-#include "Graph\NodeDistances.h"
-#include <time.h>
+#include "Algorithm\FourPointKernel.h"
 #include <string>
+#include <sstream>
 #include <vector>
-#include <math.h>
+#include <memory>
+#include <algorithm>
+#include <thread>
+#include <atomic>
 
 using namespace std;
 
 namespace hyperbolicity
 {
-	MDS::MDS() : IGraphAlg(), _isCompleted(false)
+	MDS::MDS(size_t maxSweeps /* = DefaultMaxSweeps */, unsigned long long seed /* = 0 */, unsigned int threadCount /* = 1 */) : IGraphAlg(),
+		_maxSweeps(max<size_t>(1, maxSweeps)), _seed(seed), _threadCount(max(1u, threadCount)), _failedTrials(0), _isCompleted(false)
 	{
 		//empty
 	}
@@ -22,84 +26,159 @@ namespace hyperbolicity
 		//empty
 	}
 
+	string MDS::getStatistics() const
+	{
+		stringstream statistics;
+		statistics << "sweeps drawn: " << _drawnSweeps.size() << ", retained: " << _sweepU.size();
+		return statistics.str();
+	}
+
 	DeltaHyperbolicity MDS::stepImpl()
-	{	
-		HyperbolicityAlgorithms::DoubleSweepResult curDS = _sweeps[_sweeps.size()-1];
-		delta_t maxDelta = 0;
-		node_combination_t maxState;
-		for (unsigned int i = 0; i < _sweeps.size()-1; ++i)
+	{
+		//the first sweeps drawn have nothing to be paired with
+		ParallelSampler::Sample best = drawSweeps();
+		while ( (best.doubleDelta < 0) && !_isCompleted && !isStopRequested() )
 		{
-			delta_t curDelta = 0;
-			//if pair has a node in common, or if sweeps are in different strongly connected components - the delta is considered to be 0
-			//therefore we only calculate delta if none of these conditions is not met
-			if ( (areSweepsUnique(_sweeps[i], curDS)) && (_sweeps[i].uDistances[curDS.u->getIndex()] != InfiniteDistance) )
-			{
-				//calculate delta by using the existing distances
-				distance_t d1 = _sweeps[i].dist + curDS.dist;
-				distance_t d2 = _sweeps[i].uDistances[curDS.u->getIndex()] + _vDists[i][curDS.v->getIndex()];
-				distance_t d3 = _sweeps[i].uDistances[curDS.v->getIndex()] + _vDists[i][curDS.u->getIndex()];
-				curDelta = HyperbolicityAlgorithms::calculateDeltaFromDistances(d1, d2, d3);
-			}
-				
-			//if we've reached a better delta value, keep it
-			if ( (curDelta > maxDelta) || (!maxState.isInitialized()) )
-			{
-				maxDelta = curDelta;
-				maxState.reset(_sweeps[i].u, _sweeps[i].v, curDS.u, curDS.v);
-			}
+			best = drawSweeps();
+		}
+		if (best.doubleDelta < 0)
+		{
+			node_combination_t state = HyperbolicityAlgorithms::getRandomState(_graph);
+			return DeltaHyperbolicity(HyperbolicityAlgorithms::calculateDelta(_graph, state), state);
 		}
 
-		prepareNextStep();
-		
-		return DeltaHyperbolicity(maxDelta, maxState);
+		node_combination_t maxState(_graph->getNode(best.nodes[0]), _graph->getNode(best.nodes[1]), _graph->getNode(best.nodes[2]), _graph->getNode(best.nodes[3]));
+		return DeltaHyperbolicity(best.doubleDelta / 2.0, maxState);
 	}
-	
-	void MDS::prepareNextStep()
+
+	ParallelSampler::Sample MDS::drawSweeps()
 	{
-		HyperbolicityAlgorithms::DoubleSweepResult curDS = HyperbolicityAlgorithms::doubleSweep(_graph);
-		unsigned int numOfTrials = 1;
-		for (; numOfTrials < MaxNumOfTrials && !isNewSweep(curDS); ++numOfTrials)
+		atomic<size_t> nextSlot(0);
+		ParallelSampler::Sample best = _sampler->run(_batch.size(), [this, &nextSlot](ParallelSampler::Worker& worker, ParallelSampler::Sample& sample)
 		{
-			//calculate another double-sweep
-			curDS = HyperbolicityAlgorithms::doubleSweep(_graph);
-		}
+			sampleSweep(nextSlot++, worker, sample);
+		});
 
-		//if couldn't find another double-sweep before exceeding maximal number of trials, we're done
-		if (!isNewSweep(curDS))
+		for (size_t s = 0; s < _batch.size(); ++s)
 		{
-			_isCompleted = true;
-			return;
+			//a sweep is also not new if an earlier one of the batch is the same
+			const HyperbolicityAlgorithms::CompactSweepResult& sweep = _batch[s];
+			if (!_isNew[s] || !_drawnSweeps.insert(getSweepKey(sweep.u, sweep.v)).second)
+			{
+				_isNew[s] = false;
+				if (++_failedTrials >= MaxNumOfTrials) _isCompleted = true;
+				continue;
+			}
+			_failedTrials = 0;
+
+			//pair it with the batch's earlier new sweeps - its rows hold all four distances
+			const compact_distance_t* uRow = _batchRows[2 * s].data();
+			const compact_distance_t* vRow = _batchRows[2 * s + 1].data();
+			for (size_t t = 0; t < s; ++t)
+			{
+				const HyperbolicityAlgorithms::CompactSweepResult& other = _batch[t];
+				if (!_isNew[t]) continue;
+				if ( (CompactInfiniteDistance == uRow[other.u]) || (CompactInfiniteDistance == vRow[other.v]) ||
+					 (CompactInfiniteDistance == uRow[other.v]) || (CompactInfiniteDistance == vRow[other.u]) )
+				{
+					continue;
+				}
+
+				distance_t doubleDelta = FourPointKernel::doubleDelta(sweep.dist + other.dist, uRow[other.u] + vRow[other.v], uRow[other.v] + vRow[other.u]);
+				if (doubleDelta <= best.doubleDelta) continue;
+				best.doubleDelta = doubleDelta;
+				best.nodes[0] = other.u;
+				best.nodes[1] = other.v;
+				best.nodes[2] = sweep.u;
+				best.nodes[3] = sweep.v;
+			}
+
+			retainSweep(sweep);
 		}
 
-		_sweeps.push_back(curDS);
-		//calculate all v-distances from previous-to-last double-sweep
-		_vDists.push_back( NodeDistances(_graph, _sweeps[_sweeps.size()-2].v).getDistances() );
+		return best;
 	}
 
-	bool MDS::areSweepsUnique(HyperbolicityAlgorithms::DoubleSweepResult& res1, HyperbolicityAlgorithms::DoubleSweepResult& res2)
+	void MDS::sampleSweep(size_t slot, ParallelSampler::Worker& worker, ParallelSampler::Sample& sample)
 	{
-		return ( (res1.u != res2.u) && (res1.v != res2.u) && (res1.u != res2.v) && (res1.v != res2.v) && (res1.u != res1.v) && (res2.u != res2.v) );
+		//the origin's distances are written to v's row, which is only needed once the sweep is found to be new
+		compact_distance_t* uRow = _batchRows[2 * slot].data();
+		compact_distance_t* vRow = _batchRows[2 * slot + 1].data();
+		const HyperbolicityAlgorithms::CompactSweepResult sweep = HyperbolicityAlgorithms::doubleSweep(*_compactGraph, worker.bfs, worker.random, uRow, vRow);
+		_batch[slot] = sweep;
+		_isNew[slot] = (0 == _drawnSweeps.count(getSweepKey(sweep.u, sweep.v)));
+		if (!_isNew[slot]) return;
+		worker.bfs.run(sweep.v, vRow);
+
+		const size_t count = _sweepU.size();
+		if (0 == count) return;
+
+		//gather the sums of every retained sweep with the new one into runs, one run per pair of distances:
+		//d(u_i, v_i) + d(u, v), d(u_i, u) + d(v_i, v) and d(v_i, u) + d(u_i, v)
+		vector<compact_distance_t> sums(5 * count);
+		compact_distance_t* currentLength = &sums[0];
+		compact_distance_t* uToU = &sums[count];
+		compact_distance_t* vToV = &sums[2 * count];
+		compact_distance_t* vToU = &sums[3 * count];
+		compact_distance_t* uToV = &sums[4 * count];
+		for (size_t i = 0; i < count; ++i)
+		{
+			currentLength[i] = static_cast<compact_distance_t>(sweep.dist);
+			uToU[i] = uRow[_sweepU[i]];
+			vToV[i] = vRow[_sweepV[i]];
+			vToU[i] = uRow[_sweepV[i]];
+			uToV[i] = vRow[_sweepU[i]];
+		}
+
+		//a pair of sweeps in different components is skipped by the kernel (infinite distance), and one with a node in common yields 0
+		FourPointKernel::Result result = FourPointKernel::scanPairs(&_sweepLength[0], currentLength, uToU, vToV, vToU, uToV, count);
+		if (result.index >= count) return;
+
+		sample.doubleDelta = result.doubleDelta;
+		sample.nodes[0] = _sweepU[result.index];
+		sample.nodes[1] = _sweepV[result.index];
+		sample.nodes[2] = sweep.u;
+		sample.nodes[3] = sweep.v;
 	}
 
-	bool MDS::isNewSweep(const HyperbolicityAlgorithms::DoubleSweepResult& ds) const
+	void MDS::retainSweep(const HyperbolicityAlgorithms::CompactSweepResult& sweep)
 	{
-		for (vector<HyperbolicityAlgorithms::DoubleSweepResult>::const_iterator it = _sweeps.cbegin(); it != _sweeps.cend(); ++it)
+		const compact_distance_t length = static_cast<compact_distance_t>(sweep.dist);
+		if (_sweepU.size() < _maxSweeps)
 		{
-			if ( (it->u == ds.u && it->v == ds.v) || (it->u == ds.v && it->v == ds.u) ) return false;
+			_sweepU.push_back(sweep.u);
+			_sweepV.push_back(sweep.v);
+			_sweepLength.push_back(length);
+			return;
 		}
 
-		return true;
+		//keep the longest sweeps - they are the likeliest to take part in a 4-tuple of a large delta
+		const size_t shortest = min_element(_sweepLength.cbegin(), _sweepLength.cend()) - _sweepLength.cbegin();
+		if (_sweepLength[shortest] >= length) return;
+		_sweepU[shortest] = sweep.u;
+		_sweepV[shortest] = sweep.v;
+		_sweepLength[shortest] = length;
+	}
+
+	unsigned long long MDS::getSweepKey(node_index_t u, node_index_t v)
+	{
+		return (static_cast<unsigned long long>(min(u, v)) << 32) | max(u, v);
 	}
 
 	void MDS::initImpl(const node_combination_t&)
 	{
 		_isCompleted = false;
-		_vDists.clear();
-		_sweeps.clear();
-
-		//we need at least one double-sweep before each step
-		_sweeps.push_back(HyperbolicityAlgorithms::doubleSweep(_graph));
-		prepareNextStep();
+		_failedTrials = 0;
+		_sweepU.clear();
+		_sweepV.clear();
+		_sweepLength.clear();
+		_drawnSweeps.clear();
+
+		_compactGraph = compact_graph_ptr_t(new CompactGraph(_graph));
+		_sampler = parallel_sampler_ptr_t(new ParallelSampler(*_compactGraph, limitThreads(_threadCount), 0, _seed));
+		_batch.resize(_threadCount);
+		_isNew.assign(_threadCount, false);
+		_batchRows.assign(2 * _threadCount, vector<compact_distance_t>(_compactGraph->size()));
 	}
 
 	bool MDS::isComplete() const
@@ -112,10 +191,7 @@ namespace hyperbolicity
 
 	IGraphAlg* CreateAlgorithm()
 	{
-		//initialize random seed (necessary before calling doubleSweep() )
-		srand(static_cast<unsigned int>(time(nullptr)));
-
-		IGraphAlg* alg = new MDS();
+		IGraphAlg* alg = new MDS(MDS::DefaultMaxSweeps, RandomStream::createSeed(), thread::hardware_concurrency());
 		return alg;
 	}
 
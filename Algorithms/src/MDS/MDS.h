@@ -7,9 +7,13 @@
 
 #include "Algorithm\IGraphAlg.h"
 #include "Algorithm\DeltaHyperbolicity.h"
-#include "Graph\GraphAlgorithms.h"
 #include "Algorithm\HyperbolicityAlgorithms.h"
+#include "Algorithm\RandomStream.h"
+#include "Algorithm\ParallelSampler.h"
+#include "Graph\CompactGraph.h"
 #include <string>
+#include <vector>
+#include <unordered_set>
 
 namespace hyperbolicity
 {
@@ -17,13 +21,32 @@ namespace hyperbolicity
 	 * @brief	Implementation for the multi-double-sweep algorithm. This algorithm runs multiple double-sweeps on the
 	 *			graph, and then calculates the delta hyperbolicity resulting from each pair of sweep results. It takes
 	 *			the best pair as the result.
+	 *			Only the rows of the newest sweeps' nodes are kept: the four distances between their nodes and those of an older sweep
+	 *			are all read from them, so older sweeps are kept as their two nodes and length only. Up to maxSweeps of them are
+	 *			retained (the longest ones), and a new sweep is evaluated against all of them at once with FourPointKernel.
+	 *			Every step draws a batch of new sweeps on a ParallelSampler, one per thread, each evaluated against the retained sweeps
+	 *			by the thread that drew it. The new sweeps are then paired with each other, and retained.
 	 */
 	class MDS : public IGraphAlg
 	{
 	public:
-		MDS();
+		/*
+		 * @param	maxSweeps	Maximal number of sweeps retained to be paired with new ones. Once reached, a new sweep replaces
+		 *						the shortest retained one, if it is longer.
+		 * @param	seed		The seed of the random streams the sweeps are drawn with.
+		 * @param	threadCount	Number of sweeps drawn in parallel in every step.
+		 */
+		explicit MDS(size_t maxSweeps = DefaultMaxSweeps, unsigned long long seed = 0, unsigned int threadCount = 1);
 		virtual ~MDS();
 
+		/*
+		 * @returns	The number of sweeps drawn and retained so far.
+		 */
+		virtual std::string getStatistics() const;
+
+		//default number of sweeps retained
+		static const size_t DefaultMaxSweeps = 4096;
+
 	private:
 		/*
 		 * @brief	See documentation in IGraphAlg and in the class description above.
@@ -33,29 +56,52 @@ namespace hyperbolicity
 		virtual bool isComplete() const;
 
 		/*
-		 * @brief	Finds a new, unique double-sweep result and adds it to the collection of results.
-		 *			Also calculates the distances from the previous double sweep's v node to the rest of the graph.
+		 * @brief	Draws a batch of new sweeps, pairs each with the retained sweeps and with the batch's other new sweeps, and retains
+		 *			them. Sets _isCompleted once MaxNumOfTrials sweeps in a row were not new.
+		 * @returns	The best pair found (doubleDelta is -1 if none was evaluated).
 		 */
-		void prepareNextStep();
+		ParallelSampler::Sample drawSweeps();
 
 		/*
-		 * @returns true iff the two double sweep results have no nodes in common.
+		 * @brief	Draws a single sweep into the given slot of the batch, and evaluates it against the retained sweeps if it is new.
 		 */
-		bool areSweepsUnique(HyperbolicityAlgorithms::DoubleSweepResult& res1, HyperbolicityAlgorithms::DoubleSweepResult& res2);
+		void sampleSweep(size_t slot, ParallelSampler::Worker& worker, ParallelSampler::Sample& sample);
 
 		/*
-		 * @returns	True if the given double-sweep is not already present in the _sweeps collection, false otherwise.
+		 * @brief	Adds the given sweep to the retained ones, according to the retention policy.
 		 */
-		bool isNewSweep(const HyperbolicityAlgorithms::DoubleSweepResult& ds) const;
+		void retainSweep(const HyperbolicityAlgorithms::CompactSweepResult& sweep);
+
+		/*
+		 * @returns	The key of the given sweep in _drawnSweeps (regardless of the order of its nodes).
+		 */
+		static unsigned long long getSweepKey(node_index_t u, node_index_t v);
 
 		//The maximal number of trials to get 4 different nodes out of separate double-sweeps
 		static const unsigned int MaxNumOfTrials = 500;
 
-		//sweeps collected so far
-		std::vector<HyperbolicityAlgorithms::DoubleSweepResult> _sweeps;
-		//the distances from the "other" vertex of the double sweep to the rest of the nodes
-		//i.e. _vDists[i] has the distances from _sweeps[i]'s second vertex to the rest of the graph
-		std::vector<distance_dict_t> _vDists;
+		size_t _maxSweeps;
+		unsigned long long _seed;
+		unsigned int _threadCount;
+
+		//snapshot of the graph for calculating distance rows, and the workers drawing the sweeps over it
+		compact_graph_ptr_t _compactGraph;
+		parallel_sampler_ptr_t _sampler;
+
+		//the sweeps of the current batch, whether each is new, and the distances from their two nodes (u's row, then v's, per sweep)
+		std::vector<HyperbolicityAlgorithms::CompactSweepResult> _batch;
+		std::vector<char> _isNew;
+		std::vector<std::vector<compact_distance_t>> _batchRows;
+
+		//the retained sweeps, one entry per sweep in each (kept apart, so that the rows' entries for them are gathered into runs)
+		std::vector<node_index_t> _sweepU;
+		std::vector<node_index_t> _sweepV;
+		std::vector<compact_distance_t> _sweepLength;
+
+		//every sweep drawn so far (including ones no longer retained), so that no sweep is paired twice
+		std::unordered_set<unsigned long long> _drawnSweeps;
+		//number of sweeps drawn in a row that were not new
+		unsigned int _failedTrials;
 		//we only decide that we're done if the maximal allowed number of trials to achieve a new unique double-sweep has been exceeded
 		bool _isCompleted;
 	};
@@ -2,6 +2,7 @@
 #include "SADefs.h"
 #include "SimulatedAnnealing.h"
 #include "Algorithm\IGraphAlg.h"
+#include "Algorithm\RandomStream.h"
 #include "Algorithm\HyperbolicityAlgorithms.h"
 #include "Graph\GraphAlgorithms.h"
 #include "boost\format.hpp"
@@ -17,70 +18,6 @@ const string DrawingExtension = "net";
 
 namespace hyperbolicity
 {
-	ExpProbability::ExpProbability()
-	{
-		reset();
-	}
-
-	ExpProbability::~ExpProbability()
-	{
-		//empty
-	}
-
-	sa_probability_t ExpProbability::ProbabilityToAcceptChange(delta_t curDelta, delta_t newDelta, sa_temp_t curTemp)
-	{
-		if (newDelta > curDelta) return 1.0;
-		return exp((newDelta-curDelta)/curTemp);
-	}
-
-	void ExpProbability::reset()
-	{
-		//empty
-	}
-
-	const sa_temp_t IntervalTemperature::InitialTemp = 100.0;
-	const sa_temp_t IntervalTemperature::TerminationThreshold = 0.05;
-
-	IntervalTemperature::IntervalTemperature()
-	{
-		reset();
-	}
-
-	IntervalTemperature::~IntervalTemperature()
-	{
-		//empty
-	}
-
-	sa_temp_t IntervalTemperature::TemperatureChange(sa_temp_t curTemp, delta_t curDelta, delta_t newDelta)
-	{
-		++_numOfIterations;
-		if ( (newDelta > curDelta) && (_numOfIterations - _lastChange > IterationInterval) )
-		{
-			_lastChange = _numOfIterations;
-			return curTemp/2;
-		}
-
-		if (curTemp < TerminationThreshold)
-		{
-			_lastChange = _numOfIterations;
-			return 0;
-		}
-
-		return curTemp;
-	}
-
-	sa_temp_t IntervalTemperature::GetInitialTemperature() const 
-	{
-		return InitialTemp;
-	}
-
-	void IntervalTemperature::reset()
-	{
-		_numOfIterations = 0;
-		_lastChange = 0;
-	}
-
-
 	DrawingCallback::DrawingCallback(const string& outputDir) : _runCount(-1), _outputDir(outputDir)
 	{
 		if ( (_outputDir.size() > 0) && (_outputDir[_outputDir.size()-1] != '\\') ) _outputDir += '\\';
@@ -135,7 +72,7 @@ namespace hyperbolicity
 		sa_prob_func_ptr probFunc(new ExpProbability);
 		sa_temp_func_ptr tempFunc(new IntervalTemperature);
 		sa_callback_func_ptr callbackFunc(new DrawingCallback("."));
-		IGraphAlg* alg = new SimulatedAnnealing(probFunc, tempFunc, callbackFunc);
+		IGraphAlg* alg = new SimulatedAnnealing(probFunc, tempFunc, callbackFunc, false, RandomStream::createSeed());
 		return alg;
 	}
 
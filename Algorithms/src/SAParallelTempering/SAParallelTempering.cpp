@@ -0,0 +1,30 @@
+#include "SAParallelTempering.h"
+#include "SADefs.h"
+#include "ParallelTempering.h"
+#include "SAFunctions.h"
+#include "Algorithm\IGraphAlg.h"
+#include "Algorithm\RandomStream.h"
+#include <thread>
+#include <algorithm>
+
+using namespace std;
+
+namespace hyperbolicity
+{
+	IGraphAlg* CreateAlgorithm()
+	{
+		//a chain per thread, and no fewer than MinChainCount chains so that the temperatures are spread even on few cores
+		const unsigned int MinChainCount = 4;
+		const unsigned int threadCount = max(1u, thread::hardware_concurrency());
+
+		sa_prob_func_factory_t probFactory = []() { return sa_prob_func_ptr(new ExpProbability); };
+		sa_temp_func_factory_t tempFactory = []() { return sa_temp_func_ptr(new IntervalTemperature); };
+		IGraphAlg* alg = new ParallelTempering(probFactory, tempFactory, sa_callback_func_ptr(), max(MinChainCount, threadCount), threadCount, RandomStream::createSeed());
+		return alg;
+	}
+
+	void ReleaseAlgorithm(IGraphAlg* alg)
+	{
+		if (alg) delete alg;
+	}
+} // namespace hyperbolicity
@@ -0,0 +1,17 @@
+/*
+ * Written by Eran Kravitz
+ * Email: kravitzer@gmail.com
+ */
+
+#pragma once
+
+#include "ParallelTempering.h"
+#include "SAFunctions.h"
+#include "SADefs.h"
+
+namespace hyperbolicity
+{
+	//parallel tempering with an exponential probability function and an interval temperature function per chain
+	extern "C" __declspec(dllexport) IGraphAlg* CreateAlgorithm();
+	extern "C" __declspec(dllexport) void ReleaseAlgorithm(IGraphAlg* alg);
+} // namespace hyperbolicity
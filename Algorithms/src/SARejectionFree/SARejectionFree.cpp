@@ -0,0 +1,28 @@
+#include "SARejectionFree.h"
+#include "SADefs.h"
+#include "SimulatedAnnealing.h"
+#include "SAFunctions.h"
+#include "Algorithm\IGraphAlg.h"
+#include "Algorithm\RandomStream.h"
+#include <time.h>
+
+using namespace std;
+
+namespace hyperbolicity
+{
+	IGraphAlg* CreateAlgorithm()
+	{
+		//initialize random seed (the initial state is selected randomly)
+		srand( static_cast<unsigned int>(time(nullptr)) );
+
+		sa_prob_func_ptr probFunc(new ExpProbability);
+		sa_temp_func_ptr tempFunc(new IntervalTemperature);
+		IGraphAlg* alg = new SimulatedAnnealing(probFunc, tempFunc, sa_callback_func_ptr(), true, RandomStream::createSeed());
+		return alg;
+	}
+
+	void ReleaseAlgorithm(IGraphAlg* alg)
+	{
+		if (alg) delete alg;
+	}
+} // namespace hyperbolicity
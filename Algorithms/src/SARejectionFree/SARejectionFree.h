@@ -0,0 +1,17 @@
+/*
+ * Written by Eran Kravitz
+ * Email: kravitzer@gmail.com
+ */
+
+#pragma once
+
+#include "SimulatedAnnealing.h"
+#include "SAFunctions.h"
+#include "SADefs.h"
+
+namespace hyperbolicity
+{
+	//simulated annealing in the rejection-free mode, with an exponential probability function and an interval temperature function
+	extern "C" __declspec(dllexport) IGraphAlg* CreateAlgorithm();
+	extern "C" __declspec(dllexport) void ReleaseAlgorithm(IGraphAlg* alg);
+} // namespace hyperbolicity
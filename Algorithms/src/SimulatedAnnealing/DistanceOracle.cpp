@@ -0,0 +1,88 @@
+#include "DistanceOracle.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace hyperbolicity
+{
+	DistanceOracle::DistanceOracle(const CompactGraph& graph, size_t maxCachedRows) :
+		_graph(graph), _maxCachedRows(max<size_t>(4, maxCachedRows)), _bfs(graph), _pairSearch(graph), _lookupCount(0)
+	{
+		//rows are handed out by pointer, so the cache must never reallocate
+		_rows.reserve(_maxCachedRows);
+	}
+
+	DistanceOracle::~DistanceOracle()
+	{
+		//empty
+	}
+
+	void DistanceOracle::getRows(const node_index_t* nodes, size_t count, const compact_distance_t** rows)
+	{
+		node_index_t sources[MultiSourceBFS::MaxSources];
+		compact_distance_t* sourceRows[MultiSourceBFS::MaxSources];
+		size_t sourceCount = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			rows[i] = findRow(nodes[i]);
+			if (nullptr != rows[i]) continue;
+			sources[sourceCount] = nodes[i];
+			sourceRows[sourceCount] = allocateRow(nodes[i]);
+			rows[i] = sourceRows[sourceCount++];
+		}
+		if (sourceCount > 0) _bfs.run(sources, sourceCount, sourceRows);
+	}
+
+	distance_t DistanceOracle::getNewDistance(node_index_t newNode, node_index_t node, distance_t oldDistance, unsigned int& searchCount)
+	{
+		//the new node is adjacent to the replaced one, so it is in the same component
+		if (InfiniteDistance == oldDistance) return InfiniteDistance;
+
+		const compact_distance_t* row = findRow(node);
+		if (nullptr != row) return row[newNode];
+		row = findRow(newNode);
+		if (nullptr != row) return row[node];
+
+		//a node that stays in the state is worth a full row, a passing one only a search around it
+		if (++searchCount > SearchesPerRow)
+		{
+			compact_distance_t* newRow = allocateRow(node);
+			_bfs.run(node, newRow);
+			return newRow[newNode];
+		}
+		return _pairSearch.run(newNode, node, static_cast<compact_distance_t>(oldDistance + 1));
+	}
+
+	const compact_distance_t* DistanceOracle::findRow(node_index_t node)
+	{
+		++_lookupCount;
+		for (vector<CachedRow>::iterator it = _rows.begin(); it != _rows.end(); ++it)
+		{
+			if (it->node != node) continue;
+			it->lastUse = _lookupCount;
+			return it->distances.data();
+		}
+
+		return nullptr;
+	}
+
+	compact_distance_t* DistanceOracle::allocateRow(node_index_t node)
+	{
+		++_lookupCount;
+		CachedRow* row = nullptr;
+		if (_rows.size() < _maxCachedRows)
+		{
+			_rows.push_back(CachedRow());
+			row = &_rows.back();
+			row->distances.resize(_graph.size());
+		}
+		else
+		{
+			row = &*min_element(_rows.begin(), _rows.end(), [](const CachedRow& r1, const CachedRow& r2) { return r1.lastUse < r2.lastUse; });
+		}
+
+		row->node = node;
+		row->lastUse = _lookupCount;
+		return row->distances.data();
+	}
+} // namespace hyperbolicity
@@ -0,0 +1,253 @@
+#include "ParallelTempering.h"
+#include "SADefs.h"
+#include "Graph\Graph.h"
+#include "Algorithm\HyperbolicityAlgorithms.h"
+#include <math.h>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+using namespace std;
+
+namespace hyperbolicity
+{
+
+	ParallelTempering::Chain::Chain(sa_prob_func_ptr probabilityFunction, sa_temp_func_ptr tempFunction, unsigned long long seed, unsigned long long stream,
+									const CompactGraph& graph) :
+		probFunc(probabilityFunction), tempFunc(tempFunction), temp(0), random(seed, stream), delta(0), oracle(new DistanceOracle(graph, RowsPerChain)), bestDelta(0)
+	{
+		//empty
+	}
+
+	ParallelTempering::ParallelTempering(sa_prob_func_factory_t probabilityFactory, sa_temp_func_factory_t tempFactory, sa_callback_func_ptr callbackFunction,
+										 unsigned int chainCount, unsigned int threadCount, unsigned long long seed) : IGraphAlg(),
+										_probFactory(probabilityFactory),
+										_tempFactory(tempFactory),
+										_callbackFunc(callbackFunction),
+										_chainCount(max(2u, chainCount)),
+										_threadCount(max(1u, threadCount)),
+										_seed(seed),
+										_random(seed, max(2u, chainCount)),
+										_exchangeCount(0)
+	{
+		//empty
+	}
+
+	ParallelTempering::~ParallelTempering()
+	{
+		//empty
+	}
+
+	bool ParallelTempering::isComplete() const
+	{
+		for (vector<Chain>::const_iterator it = _chains.cbegin(); it != _chains.cend(); ++it)
+		{
+			if (it->temp > 0) return false;
+		}
+		return true;
+	}
+
+	string ParallelTempering::getStatistics() const
+	{
+		stringstream statistics;
+		statistics << "exchanges: " << _exchangeCount << ", chains (temperature/delta):";
+		for (vector<Chain>::const_iterator it = _chains.cbegin(); it != _chains.cend(); ++it)
+		{
+			statistics << " " << it->temp << "/" << it->delta;
+		}
+		return statistics.str();
+	}
+
+	void ParallelTempering::initImpl(const node_combination_t& initialState)
+	{
+		_compactGraph = compact_graph_ptr_t(new CompactGraph(_graph));
+		if (nullptr != _callbackFunc.get()) _callbackFunc->reset();
+		_exchangeCount = 0;
+		const unsigned int threadCount = limitThreads(min(_threadCount, _chainCount));
+		if ( (nullptr == _pool.get()) || (_pool->threadCount() != threadCount) ) _pool = shared_ptr<WorkerPool>(new WorkerPool(threadCount));
+
+		_chains.clear();
+		for (unsigned int i = 0; i < _chainCount; ++i)
+		{
+			_chains.push_back(Chain(_probFactory(), _tempFactory(), _seed, i, *_compactGraph));
+			Chain& chain = _chains.back();
+			chain.probFunc->reset();
+			chain.tempFunc->reset();
+
+			//temperatures from the initial one down to the final one, at a constant ratio (the last chain starts at exactly the final one,
+			//so that rounding does not take it below)
+			const sa_temp_t initialTemp = chain.tempFunc->GetInitialTemperature();
+			const sa_temp_t finalTemp = chain.tempFunc->GetFinalTemperature();
+			chain.temp = ( (i + 1 == _chainCount) ? finalTemp : initialTemp * pow(finalTemp / initialTemp, static_cast<double>(i) / (_chainCount - 1)) );
+
+			//the first chain starts from the state given (if any), the rest start from random states
+			node_index_t nodes[4];
+			for (unsigned int j = 0; j < node_combination_t::size(); ++j)
+			{
+				if ( (0 == i) && (initialState.isInitialized()) )
+				{
+					nodes[j] = initialState[j]->getIndex();
+					continue;
+				}
+
+				//select a random node that is not already in the state
+				do
+				{
+					nodes[j] = static_cast<node_index_t>(chain.random.nextIndex(_compactGraph->size()));
+				} while (find(nodes, nodes + j, nodes[j]) != nodes + j);
+			}
+			setState(chain, nodes);
+		}
+	}
+
+	DeltaHyperbolicity ParallelTempering::stepImpl()
+	{
+		//call callback method with the coldest chain's state, if exists
+		if (nullptr != _callbackFunc.get())
+		{
+			const Chain& coldest = _chains.back();
+			node_combination_t state(_graph->getNode(coldest.nodes[0]), _graph->getNode(coldest.nodes[1]), _graph->getNode(coldest.nodes[2]), _graph->getNode(coldest.nodes[3]));
+			_callbackFunc->callback(_graph, state, coldest.delta, coldest.temp, false);
+		}
+
+		//run the chains, each thread taking the next chain not yet run
+		atomic<size_t> nextChain(0);
+		_pool->run([this, &nextChain](unsigned int)
+		{
+			try
+			{
+				for (size_t c = nextChain++; c < _chains.size(); c = nextChain++)
+				{
+					runChain(_chains[c], MovesPerStep);
+				}
+			}
+			catch (...)
+			{
+				//the other threads are stopped by taking the rest of the chains
+				nextChain = _chains.size();
+				throw;
+			}
+		});
+
+		//the result is the best state any chain saw during this step
+		const Chain* best = &_chains.front();
+		for (vector<Chain>::const_iterator it = _chains.cbegin(); it != _chains.cend(); ++it)
+		{
+			if (it->bestDelta > best->bestDelta) best = &*it;
+		}
+		node_combination_t bestState(_graph->getNode(best->bestNodes[0]), _graph->getNode(best->bestNodes[1]), _graph->getNode(best->bestNodes[2]), _graph->getNode(best->bestNodes[3]));
+		DeltaHyperbolicity result(best->bestDelta, bestState);
+
+		exchangeStates();
+		return result;
+	}
+
+	void ParallelTempering::runChain(Chain& chain, unsigned int moveCount) const
+	{
+		copy(chain.nodes, chain.nodes + 4, chain.bestNodes);
+		chain.bestDelta = chain.delta;
+
+		//indices of the distances from each node of the state to the other three (see Chain::distances)
+		static const unsigned int DistanceIndices[4][3] = { { 0, 1, 2 }, { 0, 3, 4 }, { 1, 3, 5 }, { 2, 4, 5 } };
+
+		for (unsigned int move = 0; (move < moveCount) && (chain.temp > 0); ++move)
+		{
+			//select a random node to replace, and a random neighbor of it that is not already in the state
+			unsigned int replaced = 0;
+			node_index_t newNode = 0;
+			bool isUniqueNeighborFound = false;
+			for (unsigned int trial = 0; (trial < MaxNeighborTrials) && (!isUniqueNeighborFound); ++trial)
+			{
+				replaced = static_cast<unsigned int>(chain.random.nextIndex(node_combination_t::size()));
+				const node_index_t node = chain.nodes[replaced];
+				const size_t degree = _compactGraph->degree(node);
+				if (0 == degree) continue;
+				newNode = _compactGraph->neighborsBegin(node)[chain.random.nextIndex(degree)];
+				isUniqueNeighborFound = (find(chain.nodes, chain.nodes + 4, newNode) == chain.nodes + 4);
+			}
+			if (!isUniqueNeighborFound) continue;
+
+			//only the distances from the new node change
+			distance_t newDistances[6];
+			copy(chain.distances, chain.distances + 6, newDistances);
+			for (unsigned int i = 0, j = 0; i < node_combination_t::size(); ++i)
+			{
+				if (i == replaced) continue;
+				const unsigned int index = DistanceIndices[replaced][j++];
+				newDistances[index] = chain.oracle->getNewDistance(newNode, chain.nodes[i], chain.distances[index], chain.searchCounts[i]);
+			}
+			delta_t newDelta = calculateDelta(newDistances);
+
+			//run the probability method to see if we accept the new state, and update the temperature
+			sa_probability_t prob = chain.probFunc->ProbabilityToAcceptChange(chain.delta, newDelta, chain.temp);
+			bool accept = (chain.random.nextUnit() < prob);
+			chain.temp = chain.tempFunc->TemperatureChange(chain.temp, chain.delta, newDelta);
+			if (!accept) continue;
+
+			chain.nodes[replaced] = newNode;
+			copy(newDistances, newDistances + 6, chain.distances);
+			chain.delta = newDelta;
+			chain.searchCounts[replaced] = 0;
+			if (chain.delta > chain.bestDelta)
+			{
+				copy(chain.nodes, chain.nodes + 4, chain.bestNodes);
+				chain.bestDelta = chain.delta;
+			}
+		}
+	}
+
+	void ParallelTempering::exchangeStates()
+	{
+		//chains that are done (temperature 0) no longer take part
+		vector<Chain*> active;
+		for (vector<Chain>::iterator it = _chains.begin(); it != _chains.end(); ++it)
+		{
+			if (it->temp > 0) active.push_back(&*it);
+		}
+		sort(active.begin(), active.end(), [](const Chain* c1, const Chain* c2) { return c1->temp > c2->temp; });
+
+		for (size_t i = 0; i + 1 < active.size(); ++i)
+		{
+			Chain& hot = *active[i];
+			Chain& cold = *active[i + 1];
+			sa_probability_t prob = exp( (hot.delta - cold.delta) * (1 / cold.temp - 1 / hot.temp) );
+			if ( (prob < 1) && (_random.nextUnit() >= prob) ) continue;
+
+			//the states move along with the distances known for them, the temperatures (and the functions keeping them) stay
+			swap_ranges(hot.nodes, hot.nodes + 4, cold.nodes);
+			swap_ranges(hot.distances, hot.distances + 6, cold.distances);
+			swap_ranges(hot.searchCounts, hot.searchCounts + 4, cold.searchCounts);
+			swap(hot.delta, cold.delta);
+			swap(hot.oracle, cold.oracle);
+			++_exchangeCount;
+		}
+	}
+
+	void ParallelTempering::setState(Chain& chain, const node_index_t* nodes)
+	{
+		copy(nodes, nodes + 4, chain.nodes);
+		const compact_distance_t* rows[4];
+		chain.oracle->getRows(chain.nodes, node_combination_t::size(), rows);
+		chain.distances[0] = rows[0][nodes[1]];
+		chain.distances[1] = rows[0][nodes[2]];
+		chain.distances[2] = rows[0][nodes[3]];
+		chain.distances[3] = rows[1][nodes[2]];
+		chain.distances[4] = rows[1][nodes[3]];
+		chain.distances[5] = rows[2][nodes[3]];
+		fill(chain.searchCounts, chain.searchCounts + 4, 0);
+		chain.delta = calculateDelta(chain.distances);
+		copy(chain.nodes, chain.nodes + 4, chain.bestNodes);
+		chain.bestDelta = chain.delta;
+	}
+
+	delta_t ParallelTempering::calculateDelta(const distance_t* distances)
+	{
+		distance_t d1 = distances[0] + distances[5];
+		distance_t d2 = distances[1] + distances[4];
+		distance_t d3 = distances[2] + distances[3];
+		return HyperbolicityAlgorithms::calculateDeltaFromDistances(d1, d2, d3);
+	}
+
+} // namespace hyperbolicity
@@ -0,0 +1,74 @@
+#include "SAFunctions.h"
+#include "SADefs.h"
+#include <math.h>
+
+namespace hyperbolicity
+{
+	ExpProbability::ExpProbability()
+	{
+		reset();
+	}
+
+	ExpProbability::~ExpProbability()
+	{
+		//empty
+	}
+
+	sa_probability_t ExpProbability::ProbabilityToAcceptChange(delta_t curDelta, delta_t newDelta, sa_temp_t curTemp)
+	{
+		if (newDelta > curDelta) return 1.0;
+		return exp((newDelta-curDelta)/curTemp);
+	}
+
+	void ExpProbability::reset()
+	{
+		//empty
+	}
+
+	const sa_temp_t IntervalTemperature::InitialTemp = 100.0;
+	const sa_temp_t IntervalTemperature::TerminationThreshold = 0.05;
+
+	IntervalTemperature::IntervalTemperature()
+	{
+		reset();
+	}
+
+	IntervalTemperature::~IntervalTemperature()
+	{
+		//empty
+	}
+
+	sa_temp_t IntervalTemperature::TemperatureChange(sa_temp_t curTemp, delta_t curDelta, delta_t newDelta)
+	{
+		++_numOfIterations;
+		if ( (newDelta > curDelta) && (_numOfIterations - _lastChange > IterationInterval) )
+		{
+			_lastChange = _numOfIterations;
+			return curTemp/2;
+		}
+
+		if (curTemp < TerminationThreshold)
+		{
+			_lastChange = _numOfIterations;
+			return 0;
+		}
+
+		return curTemp;
+	}
+
+	sa_temp_t IntervalTemperature::GetInitialTemperature() const 
+	{
+		return InitialTemp;
+	}
+
+	sa_temp_t IntervalTemperature::GetFinalTemperature() const
+	{
+		return TerminationThreshold;
+	}
+
+	void IntervalTemperature::reset()
+	{
+		_numOfIterations = 0;
+		_lastChange = 0;
+	}
+} // namespace hyperbolicity
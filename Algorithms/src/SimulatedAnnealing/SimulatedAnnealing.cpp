@@ -2,23 +2,50 @@
 #include "SADefs.h"
 #include "Graph\Graph.h"
 #include "Graph\GraphAlgorithms.h"
-#include "Graph\NodeDistances.h"
 #include "Algorithm\HyperbolicityAlgorithms.h"
-#include <random>
 #include <string>
+#include <algorithm>
 
 using namespace std;
 
 namespace hyperbolicity
 {
 
-	SimulatedAnnealing::SimulatedAnnealing(sa_prob_func_ptr probabilityFunction, sa_temp_func_ptr tempFunction, sa_callback_func_ptr callback) : IGraphAlg(),
+	namespace
+	{
+		/*
+		 * @returns	The given compact distance as a distance.
+		 */
+		inline distance_t toDistance(compact_distance_t distance)
+		{
+			return (CompactInfiniteDistance == distance ? InfiniteDistance : distance);
+		}
+
+		//index of the distance between the state's i'th & j'th nodes in the array of the 6 distances
+		const unsigned int PairIndex[4][4] = { { 0, 0, 1, 2 }, { 0, 0, 3, 4 }, { 1, 3, 0, 5 }, { 2, 4, 5, 0 } };
+
+		/*
+		 * @returns	The delta of the given 6 distances (v1->v2, v1->v3, v1->v4, v2->v3, v2->v4, v3->v4, in that order).
+		 */
+		delta_t calculateDeltaFromPairs(const distance_t* distances)
+		{
+			distance_t d1 = distances[0] + distances[5];
+			distance_t d2 = distances[1] + distances[4];
+			distance_t d3 = distances[2] + distances[3];
+			return HyperbolicityAlgorithms::calculateDeltaFromDistances(d1, d2, d3);
+		}
+	}
+
+	SimulatedAnnealing::SimulatedAnnealing(sa_prob_func_ptr probabilityFunction, sa_temp_func_ptr tempFunction, sa_callback_func_ptr callback,
+										   bool isRejectionFree /* = false */, unsigned long long seed /* = 0 */) : IGraphAlg(),
 										_temp(0), 
 										_probFunc(probabilityFunction), 
 										_tempFunc(tempFunction), 
 										_callbackFunc(callback),
 										_curState(),
-										_curDelta(0)
+										_curDelta(0),
+										_isRejectionFree(isRejectionFree),
+										_random(seed, 0)
 	{
 		//empty
 	}
@@ -38,41 +65,42 @@ namespace hyperbolicity
 		//reset SA parameters
 		_probFunc->reset();
 		_tempFunc->reset();
-		_callbackFunc->reset();
+		if (nullptr != _callbackFunc.get()) _callbackFunc->reset();
 		_temp = _tempFunc->GetInitialTemperature();
 		_isFirstStep = true;
 
+		//distances are calculated over a snapshot of the graph, the rows of a previous run are of no use
+		_compactGraph = compact_graph_ptr_t(new CompactGraph(_graph));
+		_distances = distance_oracle_ptr_t(new DistanceOracle(*_compactGraph, MaxCachedRows));
+		fill(_searchCount, _searchCount + 4, 0);
+
 		//set current state to state given, or a random state if no state is given
 		_curState = ( initialState.isInitialized() ? initialState : HyperbolicityAlgorithms::getRandomState(_graph) );
 	}
 
+	void SimulatedAnnealing::getStateRows(const compact_distance_t* rows[4])
+	{
+		node_index_t nodes[4];
+		for (unsigned int i = 0; i < node_combination_t::size(); ++i)
+		{
+			nodes[i] = _curState[i]->getIndex();
+		}
+		_distances->getRows(nodes, node_combination_t::size(), rows);
+	}
+
 	delta_t SimulatedAnnealing::calculateCurrentDelta()
 	{
-		//calculate node distances for current state
-		NodeDistances NDFrom0(_graph, _curState[0]);
-		NodeDistances NDFrom1(_graph, _curState[1]);
-		NodeDistances NDFrom2(_graph, _curState[2]);
-		//calculate d_0X (d_01, d_02, d_3)
-		_destinationNodes.clear();
-		_destinationNodes.push_back(_curState[1]);
-		_destinationNodes.push_back(_curState[2]);
-		_destinationNodes.push_back(_curState[3]);
-		distance_dict_t distances = NDFrom0.getDistances(_destinationNodes);
-		_nodeDistances[0] = distances[_curState[1]->getIndex()];
-		_nodeDistances[1] = distances[_curState[2]->getIndex()];
-		_nodeDistances[2] = distances[_curState[3]->getIndex()];
-		//calculate d_1X (d1_2, d_13)
-		_destinationNodes.clear();
-		_destinationNodes.push_back(_curState[2]);
-		_destinationNodes.push_back(_curState[3]);
-		distances = NDFrom1.getDistances(_destinationNodes);
-		_nodeDistances[3] = distances[_curState[2]->getIndex()];
-		_nodeDistances[4] = distances[_curState[3]->getIndex()];
-		//calculate d_2X (d_23)
-		_destinationNodes.clear();
-		_destinationNodes.push_back(_curState[3]);
-		distances = NDFrom2.getDistances(_destinationNodes);
-		_nodeDistances[5] = distances[_curState[3]->getIndex()];
+		const compact_distance_t* rows[4];
+		getStateRows(rows);
+
+		//calculate d_0X (d_01, d_02, d_03), d_1X (d_12, d_13) and d_2X (d_23)
+		for (unsigned int i = 0, k = 0; i < node_combination_t::size(); ++i)
+		{
+			for (unsigned int j = i + 1; j < node_combination_t::size(); ++j, ++k)
+			{
+				_nodeDistances[k] = toDistance(rows[i][_curState[j]->getIndex()]);
+			}
+		}
 
 		//calculate current delta
         distance_t d1 = _nodeDistances[0] + _nodeDistances[5];
@@ -81,6 +109,11 @@ namespace hyperbolicity
 		return HyperbolicityAlgorithms::calculateDeltaFromDistances(d1, d2, d3);
 	}
 
+	distance_t SimulatedAnnealing::getNewDistance(node_index_t newNode, unsigned int stateIndex, distance_t oldDistance)
+	{
+		return _distances->getNewDistance(newNode, _curState[stateIndex]->getIndex(), oldDistance, _searchCount[stateIndex]);
+	}
+
 	DeltaHyperbolicity SimulatedAnnealing::stepImpl()
 	{
 		//for first step, simply calculate its delta and return the state
@@ -93,48 +126,40 @@ namespace hyperbolicity
 
 		//call callback method if exists
 		if (nullptr != _callbackFunc.get()) _callbackFunc->callback(_graph, _curState, _curDelta, _temp, false);
+		if (_isRejectionFree) return stepRejectionFree();
 
 		//perform a single step
 		node_combination_t newState;
 		unsigned int replacedNodeIndexInState = getNeighbor(_graph, _curState, &newState);
 
-        //need to calculate distances from new node to other 3
-        _destinationNodes.clear();
-        for (int i = 0; i < 4; ++i)
-        {
-            if (replacedNodeIndexInState != i) _destinationNodes.push_back(newState[i]);
-        }
-		NodeDistances NDFromReplacedNode(_graph, newState[replacedNodeIndexInState]);
-		distance_dict_t distances = NDFromReplacedNode.getDistances(_destinationNodes);
-
-        //reset new distances to a side array
+        //calculate distances from new node to other 3 (starting from current array, replacing distances that have changed)
+        const node_index_t newNode = newState[replacedNodeIndexInState]->getIndex();
         distance_t newNodeDistances[6];
         copy(_nodeDistances, _nodeDistances+6, newNodeDistances);
-        //start from current array, replace distances that have changed
         switch (replacedNodeIndexInState)
         {
         case 0:
-            newNodeDistances[0] = distances[newState[1]->getIndex()];
-            newNodeDistances[1] = distances[newState[2]->getIndex()];
-            newNodeDistances[2] = distances[newState[3]->getIndex()];
+            newNodeDistances[0] = getNewDistance(newNode, 1, _nodeDistances[0]);
+            newNodeDistances[1] = getNewDistance(newNode, 2, _nodeDistances[1]);
+            newNodeDistances[2] = getNewDistance(newNode, 3, _nodeDistances[2]);
             break;
 
         case 1:
-            newNodeDistances[0] = distances[newState[0]->getIndex()];
-            newNodeDistances[3] = distances[newState[2]->getIndex()];
-            newNodeDistances[4] = distances[newState[3]->getIndex()];
+            newNodeDistances[0] = getNewDistance(newNode, 0, _nodeDistances[0]);
+            newNodeDistances[3] = getNewDistance(newNode, 2, _nodeDistances[3]);
+            newNodeDistances[4] = getNewDistance(newNode, 3, _nodeDistances[4]);
             break;
 
         case 2:
-            newNodeDistances[1] = distances[newState[0]->getIndex()];
-            newNodeDistances[3] = distances[newState[1]->getIndex()];
-            newNodeDistances[5] = distances[newState[3]->getIndex()];
+            newNodeDistances[1] = getNewDistance(newNode, 0, _nodeDistances[1]);
+            newNodeDistances[3] = getNewDistance(newNode, 1, _nodeDistances[3]);
+            newNodeDistances[5] = getNewDistance(newNode, 3, _nodeDistances[5]);
             break;
 
         case 3:
-            newNodeDistances[2] = distances[newState[0]->getIndex()];
-            newNodeDistances[4] = distances[newState[1]->getIndex()];
-            newNodeDistances[5] = distances[newState[2]->getIndex()];
+            newNodeDistances[2] = getNewDistance(newNode, 0, _nodeDistances[2]);
+            newNodeDistances[4] = getNewDistance(newNode, 1, _nodeDistances[4]);
+            newNodeDistances[5] = getNewDistance(newNode, 2, _nodeDistances[5]);
             break;
 
         default:
@@ -151,7 +176,7 @@ namespace hyperbolicity
 
 		//run the probability method to see if we accept the new state
 		sa_probability_t prob = _probFunc->ProbabilityToAcceptChange(_curDelta, newDelta, _temp);
-		bool accept = ( (static_cast<double>(rand()) / static_cast<double>(RAND_MAX)) <= prob );
+		bool accept = (_random.nextUnit() < prob);
 
 		//update the temperature
 		_temp = _tempFunc->TemperatureChange(_temp, _curDelta, newDelta);
@@ -162,12 +187,78 @@ namespace hyperbolicity
 			_curState = newState;
 			_curDelta = newDelta;
             copy(newNodeDistances, newNodeDistances+6, _nodeDistances);
+			_searchCount[replacedNodeIndexInState] = 0;
+		}
+
+		return DeltaHyperbolicity(_curDelta, _curState);
+	}
+
+	DeltaHyperbolicity SimulatedAnnealing::stepRejectionFree()
+	{
+		const compact_distance_t* rows[4];
+		getStateRows(rows);
+
+		//the regular process proposes replacing the i'th node (probability 1/4) with a given neighbor of it (1/degree), and then accepts
+		//it with the probability function's probability - each move's rate is the product of the three
+		_moves.clear();
+		double totalRate = 0;
+		for (unsigned int i = 0; i < node_combination_t::size(); ++i)
+		{
+			const node_index_t replaced = _curState[i]->getIndex();
+			if (0 == _compactGraph->degree(replaced)) continue;
+			const double proposalRate = 1.0 / (node_combination_t::size() * _compactGraph->degree(replaced));
+			for (const unsigned int* w = _compactGraph->neighborsBegin(replaced); w != _compactGraph->neighborsEnd(replaced); ++w)
+			{
+				bool isUnique = true;
+				for (unsigned int j = 0; (j < node_combination_t::size()) && isUnique; ++j)
+				{
+					if (_curState[j]->getIndex() == *w) isUnique = false;
+				}
+				if (!isUnique) continue;
+
+				distance_t newNodeDistances[6];
+				copy(_nodeDistances, _nodeDistances+6, newNodeDistances);
+				for (unsigned int j = 0; j < node_combination_t::size(); ++j)
+				{
+					if (j != i) newNodeDistances[PairIndex[i][j]] = toDistance(rows[j][*w]);
+				}
+
+				Move move;
+				move.stateIndex = i;
+				move.node = *w;
+				move.delta = calculateDeltaFromPairs(newNodeDistances);
+				totalRate += proposalRate * _probFunc->ProbabilityToAcceptChange(_curDelta, move.delta, _temp);
+				move.cumulativeRate = totalRate;
+				_moves.push_back(move);
+			}
+		}
+
+		//no move can be made (every neighbor is already in the state, or no move is ever accepted at this temperature)
+		if (totalRate <= 0)
+		{
+			_temp = 0;
+			return DeltaHyperbolicity(_curDelta, _curState);
+		}
+
+		//select a move in proportion to its rate
+		const double selected = _random.nextUnit() * totalRate;
+		vector<Move>::const_iterator move = lower_bound(_moves.cbegin(), _moves.cend(), selected, [](const Move& m, double rate) { return m.cumulativeRate <= rate; });
+		if (move == _moves.cend()) --move;
+
+		//update the temperature & the current state
+		_temp = _tempFunc->TemperatureChange(_temp, _curDelta, move->delta);
+		for (unsigned int j = 0; j < node_combination_t::size(); ++j)
+		{
+			if (j != move->stateIndex) _nodeDistances[PairIndex[move->stateIndex][j]] = toDistance(rows[j][move->node]);
 		}
+		_curState[move->stateIndex] = _graph->getNode(move->node);
+		_curDelta = move->delta;
+		_searchCount[move->stateIndex] = 0;
 
 		return DeltaHyperbolicity(_curDelta, _curState);
 	}
 
-	unsigned int SimulatedAnnealing::getNeighbor(const graph_ptr_t graph, const node_combination_t& curState, node_combination_t* newState) const
+	unsigned int SimulatedAnnealing::getNeighbor(const graph_ptr_t graph, const node_combination_t& curState, node_combination_t* newState)
 	{
 		bool isUniqueNeighborFound = false;
 		unsigned int replacedNodeIndexInState = 0;
@@ -180,12 +271,12 @@ namespace hyperbolicity
 		while (!isUniqueNeighborFound)
 		{
 			//select a random node to replace
-			replacedNodeIndexInState = rand() % node_combination_t::size();
+			replacedNodeIndexInState = static_cast<unsigned int>(_random.nextIndex(node_combination_t::size()));
 			node_ptr_t nodeReplaced = curState[replacedNodeIndexInState];
             
 			//select a neighbor node randomly
 			const node_weak_ptr_collection_t& neighbors = nodeReplaced->getEdges();
-			unsigned int neighborIndex = rand() % neighbors.size();
+			size_t neighborIndex = _random.nextIndex(neighbors.size());
 			newNode = neighbors[neighborIndex].lock();
 
 			//assume new node is unique (i.e. not already in current state) and go through current state
@@ -0,0 +1,79 @@
+/*
+ * Written by Eran Kravitz
+ * Email: kravitzer@gmail.com
+ */
+
+#pragma once
+
+#include "defs.h"
+#include <atomic>
+#include <memory>
+
+namespace hyperbolicity
+{
+	/*
+	 * @brief	Bounds on the delta hyperbolicity of a graph, shared by the runner and the algorithms running on the graph (from any number
+	 *			of threads). The bounds only ever improve - the lower bound rises and the upper bound falls.
+	 *			Deltas are multiples of 0.5, so they are kept doubled, as integers.
+	 *			The channel also carries a cancellation flag, so that whoever decides a search is over can stop all the algorithms at once.
+	 */
+	class BoundChannel
+	{
+	public:
+		/*
+		 * @brief	Starts with a lower bound of 0 and no upper bound.
+		 */
+		BoundChannel();
+		~BoundChannel();
+
+		/*
+		 * @brief	Raises the lower bound to the given delta (i.e. the delta of some 4-tuple), if it is higher.
+		 */
+		void publishLowerBound(delta_t delta);
+
+		/*
+		 * @brief	Lowers the upper bound to the given one, if it is lower (rounded down to a multiple of 0.5).
+		 */
+		void publishUpperBound(delta_t delta);
+
+		/*
+		 * @returns	The highest lower bound published so far (0 if none was).
+		 */
+		delta_t currentLowerBound() const;
+
+		/*
+		 * @returns	The lowest upper bound published so far, InfiniteDelta if none was.
+		 */
+		delta_t currentUpperBound() const;
+
+		/*
+		 * @returns	True if the lower bound has reached the upper bound, i.e. no 4-tuple can improve on it.
+		 */
+		bool isSettled() const;
+
+		/*
+		 * @brief	Asks everyone running on the graph to stop (e.g. when a race between algorithms is decided by other means, or one of
+		 *			them failed).
+		 */
+		void cancel();
+
+		/*
+		 * @returns	True if cancel() was called, or the bounds are settled - i.e. there is no point in searching any further.
+		 */
+		bool isCancelled() const;
+
+	private:
+		//do *not* allow copy ctor / assignment operator
+		BoundChannel(const BoundChannel&);
+		BoundChannel& operator=(const BoundChannel&);
+
+		//twice the bounds (NoUpperBound if there is no upper bound)
+		std::atomic<unsigned int> _doubleLowerBound;
+		std::atomic<unsigned int> _doubleUpperBound;
+		std::atomic<bool> _isCancelled;
+		static const unsigned int NoUpperBound = static_cast<unsigned int>(-1);
+	};
+
+	typedef std::shared_ptr<BoundChannel> bound_channel_ptr_t;
+
+} // namespace hyperbolicity
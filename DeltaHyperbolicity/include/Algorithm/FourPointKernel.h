@@ -0,0 +1,58 @@
+/*
+ * Written by Eran Kravitz
+ * Email: kravitzer@gmail.com
+ */
+
+#pragma once
+
+#include "Graph\defs.h"
+#include "defs.h"
+
+namespace hyperbolicity
+{
+	/*
+	 * @brief	Batched evaluation of the four-point condition: given three pair-sum sources per candidate, finds the candidate whose
+	 *			largest sum exceeds the middle one by the most. The sums are sorted with min/max only (no branches) and evaluated on
+	 *			8 candidates per SSE2 instruction, so a scan over a distance row is bound by memory rather than by the comparisons.
+	 *			Blocks holding a distance too large for 16-bit lanes (e.g. CompactInfiniteDistance) fall back to a scalar loop that
+	 *			skips candidates with an infinite distance.
+	 */
+	class FourPointKernel
+	{
+	public:
+		/*
+		 * @brief	The result of a scan.
+		 *			doubleDelta is twice the best delta (i.e. largest sum minus middle sum), and index is the first candidate
+		 *			achieving it (relative to the beginning of the scanned range). If no candidate was evaluated, index equals count.
+		 */
+		struct Result
+		{
+			distance_t doubleDelta;
+			size_t index;
+		};
+
+		/*
+		 * @brief	Scans candidates c in [0, count) whose sums are k1 + r1[c], k2 + r2[c] and k3 + r3[c].
+		 *			This is the form of a v4 scan: for fixed v1, v2, v3 with k1 = d(v1,v2), k2 = d(v1,v3), k3 = d(v2,v3),
+		 *			the rows are r1 = d(v3,.), r2 = d(v2,.) and r3 = d(v1,.).
+		 * @note	A candidate equal to one of the fixed nodes always evaluates to 0.
+		 */
+		static Result scanRows(distance_t k1, const compact_distance_t* r1, distance_t k2, const compact_distance_t* r2,
+							   distance_t k3, const compact_distance_t* r3, size_t count);
+
+		/*
+		 * @brief	Scans candidates c in [0, count) whose sums were gathered in advance: a1[c] + b1[c], a2[c] + b2[c] and a3[c] + b3[c].
+		 */
+		static Result scanPairs(const compact_distance_t* a1, const compact_distance_t* b1, const compact_distance_t* a2, const compact_distance_t* b2,
+								const compact_distance_t* a3, const compact_distance_t* b3, size_t count);
+
+		/*
+		 * @returns	Twice the delta of the given sums (the scalar version of the kernel, equivalent to 2 * calculateDeltaFromDistances()).
+		 */
+		static distance_t doubleDelta(distance_t s1, distance_t s2, distance_t s3);
+
+	private:
+		//all static
+		FourPointKernel();
+	};
+} // namespace hyperbolicity
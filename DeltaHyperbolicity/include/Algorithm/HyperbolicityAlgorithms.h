@@ -7,7 +7,11 @@
  
  #include "DeltaHyperbolicity.h"
  #include "Graph\defs.h"
+#include "Graph\CompactGraph.h"
+#include "Graph\MultiSourceBFS.h"
+#include "RandomStream.h"
 #include <unordered_set>
+#include <vector>
 
 namespace hyperbolicity
 {
@@ -17,6 +21,21 @@ namespace hyperbolicity
 	class HyperbolicityAlgorithms
 	{
 	public:
+		/*
+		 * @brief	Structural classes of graphs whose delta is known, or bounded, without searching (see classify()).
+		 */
+		enum GraphClass
+		{
+			//nothing is known
+			GeneralGraph,
+			//delta is 0
+			CompleteGraph,
+			//every block is an edge or a cycle (trees and cycles included) - delta is the largest delta of its cycles
+			CactusGraph,
+			//no induced cycle longer than 3 - delta is at most 1, and at least 0.5 if the graph is 2-connected and not complete
+			ChordalGraph
+		};
+
 		struct DoubleSweepResult
 		{
 			node_ptr_t u;
@@ -24,6 +43,31 @@ namespace hyperbolicity
 			distance_t dist;
 			distance_dict_t uDistances;
 		};
+
+		/*
+		 * @brief	The result of a double sweep over a compact graph - the distances from u are written to a row given by the caller.
+		 */
+		struct CompactSweepResult
+		{
+			node_index_t u;
+			node_index_t v;
+			distance_t dist;
+		};
+
+		/*
+		 * @brief	The weighted core of a graph, as built by getChainCore().
+		 */
+		struct WeightedCore
+		{
+			//the core nodes, as a graph of their own (with their labels in the original graph) which has an edge wherever the core does
+			graph_ptr_t graph;
+			//the core's weighted edges, by the index of the core graph's nodes
+			compact_graph_ptr_t weights;
+			//the node of the original graph of every core node
+			std::vector<node_index_t> nodes;
+			//the largest distance from a chain node to the nearest core node (half the longest chain, rounded down - 0 without chains)
+			distance_t chainReach;
+		};
 		
 		/*
 		 * @brief	Calculates the delta value of the given state nodes.
@@ -53,6 +97,23 @@ namespace hyperbolicity
 		 */
 		static DoubleSweepResult doubleSweep(const graph_ptr_t graph, const node_ptr_t origin = node_ptr_t(nullptr));
 
+		/*
+		 * @brief	Runs a double-sweep from a random node of the given compact graph. Unlike the overload above, it touches no state of the
+		 *			graph (the BFS buffers and the random stream are the caller's), so several may run on the same graph concurrently.
+		 * @param	graph		The graph to run on.
+		 * @param	bfs			BFS buffers over the graph.
+		 * @param	random		The random stream to select the origin, and the furthest nodes among equally far ones, with.
+		 * @param	uRow		Will be set to the distances from u (graph.size() entries).
+		 * @param	scratchRow	Distances from the origin are written here (graph.size() entries).
+		 * @returns	The double-sweep's nodes, and the distance between them.
+		 */
+		static CompactSweepResult doubleSweep(const CompactGraph& graph, MultiSourceBFS& bfs, RandomStream& random, compact_distance_t* uRow, compact_distance_t* scratchRow);
+
+		/*
+		 * @returns	A random node among the ones furthest from the row's source (skipping unreachable nodes).
+		 */
+		static node_index_t selectFurthest(const compact_distance_t* row, size_t size, RandomStream& random);
+
 		/*
 		 * @returns	A random state from the graph given.
 		 */
@@ -89,37 +150,86 @@ namespace hyperbolicity
 		 *								may keep them in order to avoid running on them in the future).
 		 *								In case a cycle was removed, the labels of the nodes revmoed.
 		 * @returns	Whether a cycle was removed from the graph or not.
+		 * @note	A removed chain is never a shortest path between s & t, so distances between the remaining nodes are unchanged - callers
+		 *			keeping distance rows may synchronize them without recomputation (see DynamicDistances::synchronize()).
 		 */
 		static bool removeCycle(graph_ptr_t graph, node_ptr_t origin, delta_t& delta, std::unordered_set<std::string>& processedNodes);
 
 		/*
  		 * @brief	Prunes trees from the graph. I.e. removes all nodes with degree 0 or 1 (and those that become of this degree as a result
-		 *			of these deletions, recursively).
-		 * @param	graph	The graph to run on.
+		 *			of these deletions, repeatedly) - leaving the 2-core, found by GraphAlgorithms::getTwoCore().
+		 * @param	graph		The graph to run on.
+		 * @note	Pendant trees are never on a shortest path between remaining nodes, so distances between the remaining nodes are unchanged
+		 *			(see DynamicDistances::synchronize()).
 		 */
 		static void pruneTrees(graph_ptr_t graph);
 
-private:
 		/*
-		 * @param node	The node for which to perform the count.
-		 * @returns The number of outgoing edges from the given node, pointing to unmarked nodes.
+		 * @brief	Contracts every maximal chain of degree-2 nodes into a weighted edge (see ChainCore), and evaluates the shortest cycle
+		 *			through each chain - the chain closed by a shortest path between its ends that avoids it. Such a cycle is isometric, so
+		 *			its delta is known exactly and is a lower bound on the graph's delta.
+		 *			The graph itself is left as it is (see getChainCore() for searching the core in its place).
+		 * @param	graph		The graph to run on.
+		 * @param	chainCount	Will be set to the number of chains.
+		 * @returns	The largest delta of the chains' cycles, and a quad of that cycle attaining it (0 without nodes, if none has a positive delta).
+		 */
+		static DeltaHyperbolicity getChainCycleDelta(const graph_ptr_t graph, size_t& chainCount);
+
+		/*
+		 * @brief	Builds the weighted core of the graph (see ChainCore), for the algorithms that support weighted graphs to search in place
+		 *			of the graph (see IGraphAlg::setWeightedGraph()). The distances between core nodes are the same as on the graph, so the
+		 *			core's delta is a lower bound on the graph's delta. Every node of a 4-tuple is at most chainReach away from a core node,
+		 *			and moving a node by r changes the delta by at most r, so the graph's delta is at most the core's plus 4 * chainReach.
+		 * @param	graph	The graph to run on.
+		 * @returns	The core.
+		 */
+		static WeightedCore getChainCore(const graph_ptr_t graph);
+
+		/*
+		 * @brief	Contracts every class of false twins (nodes with identical neighborhoods, hence non-adjacent) to a single node - the one
+		 *			with the lowest index, so the remaining nodes keep their original labels. Classes are found by hashing the sorted
+		 *			adjacency lists.
+		 *			Distances between the remaining nodes are unchanged, so every quad without two twins of the same class keeps its delta.
+		 *			A quad holding two such twins has delta at most 1 - exactly 1 if their neighborhood is not a clique, 0.5 if it is a
+		 *			clique of 2 nodes or more, and 0 otherwise. The graph's delta is therefore the larger of the reduced graph's delta and
+		 *			the one returned.
+		 * @param	graph	The graph to run on.
+		 * @returns	The largest delta of a quad holding two twins of the same class, and that quad (in the original graph). If there is
+		 *			no such quad with a positive delta, 0 is returned, without nodes.
 		 */
-		static unsigned int countUnmarkedNeighbors(node_ptr_t node);
+		static DeltaHyperbolicity reduceFalseTwins(graph_ptr_t graph);
 
 		/*
-		 * @brief	Marks the given current leaf node and recursively calls itself on its neighbor (if exists).
-		 * @param	curNode			The current node to mark for deletion. Must have degree 0 or 1.
-		 * @returns The number of nodes marked for deletion.
-		 * @throws	std::exception	If the current node's degree is greater than 1.
+		 * @brief	Decomposes the graph by its splits - bipartitions (A, B) of 2 nodes or more on each side, where the edges between the sides
+		 *			are exactly all the edges between A' (the nodes of A with a neighbor in B) and B'. The split components, A with a node of
+		 *			B' and B with a node of A', are isometric subgraphs, and the graph's delta is the largest of their deltas and the delta of
+		 *			the quads crossing the split (two nodes on each side), which is max(0, (g(A') + g(B')) / 2 - 1), where g of a frontier
+		 *			is 2 if it is not a clique, 1 if it is a clique of 2 nodes or more, and 0 if it is a single node.
+		 *			Components are split further until none of them has a split.
+		 *			This is not the linear-time split decomposition: finding a split of a component tries (minimal degree + 1) * n closures,
+		 *			each taking O(m) time, so the search is bounded by its cost rather than by the size of the component.
+		 * @param	graph		The graph to decompose (should be connected).
+		 * @param	maxCost		Components whose split search would cost more than this (n * m * (minimal degree + 1)) are not split, and
+		 *						are returned as they are.
+		 * @param	splitDelta	Will be set to the largest delta of quads crossing the splits, and such a quad (0 without nodes, if they are all 0).
+		 * @returns	The split components.
 		 */
-		static unsigned int pruneTreesRecursion(node_ptr_t curNode);
+		static graph_ptr_collection_t getSplitComponents(const graph_ptr_t graph, unsigned long long maxCost, DeltaHyperbolicity& splitDelta);
 
 		/*
-		 * @returns The first unmarked neighbor of the node given.
-		 * @throws  std::exception if there is none.
+		 * @brief	Classifies the graph in linear time - complete graphs by their edge count, cacti by a DFS in which no tree edge may be
+		 *			covered by two back edges, and chordal graphs by checking that the reverse of a LexBFS order is a perfect elimination
+		 *			order. Complete graphs and cacti have an exact delta, so no search is needed for them at all, and chordal graphs have
+		 *			a delta of at most 1 (Brinkmann, Koolen and Moulton).
+		 * @param	graph		The graph to classify (should be connected).
+		 * @param	lowerBound	Will be set to the delta of a quad of the graph, as large as could be found - the exact delta for complete
+		 *						graphs and cacti (0 without nodes, if no quad with a positive delta was found).
+		 * @param	upperBound	Will be set to an upper bound on the delta, InfiniteDelta for a general graph.
+		 * @returns	The class of the graph.
 		 */
-		static node_ptr_t getUnmarkedNeighbor(const node_ptr_t node);
+		static GraphClass classify(const graph_ptr_t graph, DeltaHyperbolicity& lowerBound, delta_t& upperBound);
 
+private:
 		/*
 		 * @returns	The delta value of a cycle-graph whose length is given.
 		 */
@@ -141,5 +251,37 @@ private:
 		 * @returns	True if node is to be marked, false otherwise.
 		 */
 		static bool isNodeToBeMarked(node_ptr_t node, const node_combination_t* nodesToMark);
+
+		/*
+		 * @brief	Finds a split of the graph, using closures: given a set of nodes on one side and a node of B' (the anchor), every node
+		 *			of the set that is not the anchor's neighbor has all of its neighbors on its side, and every other node whose neighbors in
+		 *			the set are not exactly the anchor's must join it. The closure of 2 nodes of A and any node of B' is a side of a split.
+		 *			All such closures are tried from a node x of minimal degree - either x is in A', so B' is within x's neighbors, or x's
+		 *			neighbors are all in A.
+		 * @param	graph	The graph to run on.
+		 * @param	side	Will be set to the nodes of the side found.
+		 * @returns	Whether the graph has a split.
+		 */
+		static bool findSplit(const CompactGraph& graph, std::vector<node_index_t>& side);
+
+		/*
+		 * @brief	Picks 2 nodes of the given frontier of a split, non-adjacent if possible.
+		 * @returns	2 if the nodes are non-adjacent, 1 if they are adjacent, and 0 if the frontier is a single node (set as both).
+		 */
+		static unsigned int pickFrontierPair(const CompactGraph& graph, const std::vector<node_index_t>& frontier, node_index_t& u, node_index_t& v);
+
+		/*
+		 * @brief	Checks whether the graph is a connected cactus, using a DFS - each back edge closes a cycle with the tree path it
+		 *			spans, and the graph is a cactus iff no tree edge is on two such paths.
+		 * @param	deltaCycle	Will be set to the nodes of the cycle of largest delta, in order (empty if there is none longer than 3).
+		 * @returns	Whether the graph is a connected cactus.
+		 */
+		static bool findCactusCycle(const CompactGraph& graph, std::vector<node_index_t>& deltaCycle);
+
+		/*
+		 * @returns	Whether the graph is chordal, i.e. whether the reverse of its LexBFS order (found by partition refinement) is a perfect
+		 *			elimination order.
+		 */
+		static bool isChordal(const CompactGraph& graph);
 	};
 } // namespace hyperbolicity
\ No newline at end of file
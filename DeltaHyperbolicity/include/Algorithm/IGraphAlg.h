@@ -6,14 +6,21 @@
 #pragma once
 
 #include "Graph\defs.h"
+#include "Graph\CompactGraph.h"
 #include "Algorithm\DeltaHyperbolicity.h"
+#include "Algorithm\BoundChannel.h"
 #include <string>
+#include <atomic>
+#include <time.h>
 
 namespace hyperbolicity
 {
 	/*
 	 * @brief	This is the general interface for a graph algorithm. When implementing a new algorithm logic,
 	 *			one should inherit from this interface and implement its pure virtual methods.
+	 *			Initialization and steps are cooperative: an implementation whose initImpl() or stepImpl() may run long does its work in
+	 *			chunks, checking isStopRequested() and reporting its progress between them, and returns early once a stop is requested
+	 *			(whatever it found by then is still a valid result). A stop request is never withdrawn, so the run is over at that point.
 	 */
 	class IGraphAlg
 	{
@@ -33,13 +40,21 @@ namespace hyperbolicity
 		 * @param	graph			The graph to run on.
 		 * @param	initialState	A state to start from. May be irrelevant for some algorithms, in which case it is ignored.
 		 *							This parameter is optional.
+		 * @param	bounds			Bounds on the graph's delta, shared with the runner and with any other algorithm running on the graph.
+		 *							The algorithm publishes every delta it finds as a lower bound, and may skip whatever cannot beat the current
+		 *							lower bound (which may have come from elsewhere). This parameter is optional - if null, the algorithm uses
+		 *							bounds of its own.
+		 *							An exact algorithm that is already complete once initialized publishes the lower bound as the upper bound.
 		 */
-		void initialize(const graph_ptr_t graph, const node_combination_t& initialState = node_combination_t());
+		void initialize(const graph_ptr_t graph, const node_combination_t& initialState = node_combination_t(), const bound_channel_ptr_t& bounds = bound_channel_ptr_t());
 
 		/*
 		 * @brief	Runs a single step of the implementation for the algorithm.
-		 * @throws	std::exception	Upon an error.
+		 * @throws	std::exception		Upon an error.
+		 * @throws	std::logic_error	If the run is complete, or was asked to stop.
 		 * @returns	The delta & state found in this step (not necessarily the best ones found so far - it is the based class' responsibility to keep the best one).
+		 *			The delta is also published as a lower bound, and once an exact algorithm completes, the lower bound is published as the
+		 *			upper bound as well (settling the bounds, so whoever else is running on the graph may stop).
 		 * @see		stepImpl
 		 */
 		DeltaHyperbolicity step();
@@ -50,6 +65,62 @@ namespace hyperbolicity
 		 */
 		virtual bool isComplete() const = 0;
 
+		/*
+		 * @returns	True if the algorithm evaluates every 4-tuple that could beat the lower bound by the time it completes, i.e. the best
+		 *			delta known once it completes is the graph's delta. False by default.
+		 */
+		virtual bool isExact() const;
+
+		/*
+		 * @returns	Implementation specific counters of the run so far, for display (e.g. how much of the search was pruned).
+		 *			Empty by default.
+		 */
+		virtual std::string getStatistics() const;
+
+		/*
+		 * @brief	Sets the time (in clock() ticks) by which the run must stop, NoDeadline (the default) for none. Should be set before
+		 *			initialize(), as the initialization may run long as well.
+		 */
+		void setDeadline(clock_t deadline);
+
+		/*
+		 * @returns	True once the run should stop - the deadline has passed, or the bounds were cancelled (see BoundChannel::isCancelled()).
+		 *			Safe to call from any thread.
+		 */
+		bool isStopRequested() const;
+
+		/*
+		 * @returns	The fraction (0 to 1) of the last initialization or step done, as reported by the implementation - 0 if it reports
+		 *			none. Mostly of interest when the run was stopped in the middle.
+		 */
+		double getProgress() const;
+
+		/*
+		 * @brief	Sets the most threads the run may use at once (e.g. when it shares the machine with other algorithms), NoThreadLimit (the
+		 *			default) for none beyond the implementation's own. Should be set before initialize(), where the implementation sizes its
+		 *			threads.
+		 */
+		void setThreadLimit(unsigned int threadLimit);
+
+		/*
+		 * @brief	Sets weights for the edges of the graph given to initialize() - a weighted compact graph of the same nodes, by index (e.g.
+		 *			the core of ChainCore, whose edges stand for chains), on which the distances are measured instead. Null (the default)
+		 *			to run on the graph as it is. Should be set before initialize().
+		 * @see		supportsWeightedGraph
+		 */
+		void setWeightedGraph(const compact_graph_ptr_t& weightedGraph);
+
+		/*
+		 * @returns	True if the algorithm measures its distances on the weighted graph, when one is set (see setWeightedGraph()). False by
+		 *			default - initialize() rejects a weighted graph then.
+		 */
+		virtual bool supportsWeightedGraph() const;
+
+		//no deadline was set
+		static const clock_t NoDeadline = static_cast<clock_t>(-1);
+		//no thread limit was set
+		static const unsigned int NoThreadLimit = 0;
+
 	protected:
 		/*
 		 * @brief	Derived implementation should perform initialization steps here.
@@ -62,14 +133,53 @@ namespace hyperbolicity
 		 */
 		virtual DeltaHyperbolicity stepImpl() = 0;
 
+		/*
+		 * @brief	Publishes bounds found by the implementation (a lower bound must be the delta of some 4-tuple).
+		 */
+		void publishLowerBound(delta_t delta);
+		void publishUpperBound(delta_t delta);
+
+		/*
+		 * @returns	The best bounds known so far, by any source. The upper bound is InfiniteDelta if none is known.
+		 *			A 4-tuple whose delta is not above the lower bound cannot improve the result, and once the lower bound reaches the upper
+		 *			bound nothing can.
+		 */
+		delta_t currentLowerBound() const;
+		delta_t currentUpperBound() const;
+
+		/*
+		 * @brief	Reports the fraction (0 to 1) of the current initialization or step done so far. Safe to call from any thread.
+		 */
+		void reportProgress(double progress);
+
+		/*
+		 * @returns	The number of threads to run with, given the number the implementation would use - at most the limit set by
+		 *			setThreadLimit(), and at least 1.
+		 */
+		unsigned int limitThreads(unsigned int threadCount) const;
+
+		/*
+		 * @returns	The graph to run on in compact form - the weighted graph if one was set (see setWeightedGraph()), a snapshot of the
+		 *			graph otherwise.
+		 */
+		compact_graph_ptr_t getCompactGraph() const;
+
 		//the graph to run on
 		graph_ptr_t _graph;
 
 	private:
 		/*
-		 * @throws	std::exception	If given graph parameter is null or contains less than a quad of vertices.
+		 * @throws	std::exception	If given graph parameter is null or contains less than a quad of vertices, or if a weighted graph
+		 *							was set that does not match it or is not supported.
 		 */
 		void validateGraphInput(const graph_ptr_t graph) const;
+
+		//bounds on the graph's delta, which also carry the cancellation of the run
+		bound_channel_ptr_t _bounds;
+		clock_t _deadline;
+		unsigned int _threadLimit;
+		compact_graph_ptr_t _weightedGraph;
+		std::atomic<double> _progress;
 	};
 
 } // namespace hyperbolicity
@@ -0,0 +1,85 @@
+/*
+ * Written by Eran Kravitz
+ * Email: kravitzer@gmail.com
+ */
+
+#pragma once
+
+#include "Graph\defs.h"
+#include "Graph\CompactGraph.h"
+#include "Graph\MultiSourceBFS.h"
+#include "RandomStream.h"
+#include "WorkerPool.h"
+#include <vector>
+#include <memory>
+#include <functional>
+
+namespace hyperbolicity
+{
+	/*
+	 * @brief	Draws independent samples (e.g. double sweeps) on several threads at once. Each worker has its own BFS buffers, distance
+	 *			rows and stream of random numbers, so the workers share nothing but the graph snapshot. The workers take samples until
+	 *			the requested number was drawn, and the best one is reduced without locks. The workers' threads are kept for the
+	 *			lifetime of the sampler, so that runs of a few samples each (e.g. one per step) do not create threads every time.
+	 */
+	class ParallelSampler
+	{
+	public:
+		/*
+		 * @brief	A sampled 4-tuple, and twice its delta (-1 if the sample did not produce one).
+		 */
+		struct Sample
+		{
+			distance_t doubleDelta;
+			node_index_t nodes[4];
+		};
+
+		/*
+		 * @brief	The state of a single worker, only ever used by one thread at a time.
+		 */
+		struct Worker
+		{
+			Worker(const CompactGraph& graph, unsigned long long seed, unsigned long long stream, size_t rowCount);
+
+			MultiSourceBFS bfs;
+			RandomStream random;
+			//rows of graph.size() distances each, for the sample method's use
+			std::vector<std::vector<compact_distance_t>> rows;
+		};
+
+		//draws a single sample, using the given worker's state
+		typedef std::function<void (Worker& worker, Sample& sample)> sample_method_t;
+
+		/*
+		 * @param	graph			The graph to sample from. Must outlive this instance.
+		 * @param	threadCount		Number of workers (at least 1).
+		 * @param	rowsPerWorker	Number of distance rows each worker holds.
+		 * @param	seed			The seed of the workers' random streams (worker i uses stream i).
+		 */
+		ParallelSampler(const CompactGraph& graph, unsigned int threadCount, size_t rowsPerWorker, unsigned long long seed);
+		~ParallelSampler();
+
+		/*
+		 * @brief	Draws the given number of samples, spread over the workers.
+		 * @returns	The sample of the largest delta (doubleDelta is -1 if none produced one).
+		 * @throws	Whatever the sample method throws (the other workers stop once their current sample is done).
+		 */
+		Sample run(size_t sampleCount, const sample_method_t& sampleOnce);
+
+		/*
+		 * @returns	The number of workers.
+		 */
+		unsigned int threadCount() const;
+
+	private:
+		//do *not* allow copy ctor / assignment operator
+		ParallelSampler(const ParallelSampler&);
+		ParallelSampler& operator=(const ParallelSampler&);
+
+		std::vector<std::shared_ptr<Worker>> _workers;
+		WorkerPool _pool;
+	};
+
+	typedef std::shared_ptr<ParallelSampler> parallel_sampler_ptr_t;
+
+} // namespace hyperbolicity
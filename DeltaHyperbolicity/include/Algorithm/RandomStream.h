@@ -0,0 +1,58 @@
+/*
+ * Written by Eran Kravitz
+ * Email: kravitzer@gmail.com
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+namespace hyperbolicity
+{
+	/*
+	 * @brief	Counter-based random number generator: the i'th number of a stream is a hash of (seed, stream, i), so streams with the
+	 *			same seed and different ids are independent, and each thread may own one without any shared state.
+	 *			Numbers are 64 bits wide, unlike rand() (which is only 15 bits wide on MSVC).
+	 */
+	class RandomStream
+	{
+	public:
+		/*
+		 * @param	seed	The seed shared by all streams of a run.
+		 * @param	stream	The id of this stream.
+		 */
+		RandomStream(unsigned long long seed, unsigned long long stream);
+		~RandomStream();
+
+		/*
+		 * @returns	The next 64 random bits.
+		 */
+		unsigned long long next();
+
+		/*
+		 * @returns	A random number in [0, bound), bound must be positive.
+		 */
+		size_t nextIndex(size_t bound);
+
+		/*
+		 * @returns	A random number in [0, 1).
+		 */
+		double nextUnit();
+
+		/*
+		 * @returns	A seed that differs between runs (based on the time and the clock).
+		 */
+		static unsigned long long createSeed();
+
+	private:
+		/*
+		 * @returns	The SplitMix64 finalizer of the given value - a bijection that mixes every bit into every other.
+		 */
+		static unsigned long long mix(unsigned long long value);
+
+		//the stream's key (mixed from the seed and the stream id), and the number of values drawn so far
+		unsigned long long _key;
+		unsigned long long _counter;
+	};
+
+} // namespace hyperbolicity
@@ -0,0 +1,68 @@
+/*
+ * Written by Eran Kravitz
+ * Email: kravitzer@gmail.com
+ */
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+namespace hyperbolicity
+{
+	/*
+	 * @brief	A fixed set of threads that live as long as the pool, for work that is handed out in many short rounds (e.g. a round per
+	 *			step of an algorithm), so that threads are not created & joined every round.
+	 */
+	class WorkerPool
+	{
+	public:
+		//a round's work, given the index of the worker running it
+		typedef std::function<void (unsigned int worker)> task_t;
+
+		/*
+		 * @param	threadCount	Number of workers (at least 1).
+		 */
+		explicit WorkerPool(unsigned int threadCount);
+		~WorkerPool();
+
+		/*
+		 * @brief	Runs the task once on every worker, and waits for all of them to finish. Must not be called by more than one thread
+		 *			at a time.
+		 * @throws	The exception thrown by the task on the first worker (by index) that threw one, once all of them are done.
+		 */
+		void run(const task_t& task);
+
+		/*
+		 * @returns	The number of workers.
+		 */
+		unsigned int threadCount() const;
+
+	private:
+		//do *not* allow copy ctor / assignment operator
+		WorkerPool(const WorkerPool&);
+		WorkerPool& operator=(const WorkerPool&);
+
+		/*
+		 * @brief	The loop of a single worker: waits for a round, runs it and reports it done, until the pool is destroyed.
+		 */
+		void work(unsigned int index);
+
+		std::vector<std::thread> _threads;
+		std::mutex _mutex;
+		std::condition_variable _roundStarted;
+		std::condition_variable _roundDone;
+
+		//the current round's task, the round's number (so that every worker runs it once), and the number of workers still running it
+		const task_t* _task;
+		unsigned long long _round;
+		unsigned int _runningCount;
+		std::vector<std::exception_ptr> _errors;
+		bool _isStopping;
+	};
+
+} // namespace hyperbolicity
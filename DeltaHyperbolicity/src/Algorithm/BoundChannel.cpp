@@ -0,0 +1,61 @@
+#include "BoundChannel.h"
+#include <math.h>
+
+using namespace std;
+
+namespace hyperbolicity
+{
+
+	BoundChannel::BoundChannel() : _doubleLowerBound(0), _doubleUpperBound(NoUpperBound), _isCancelled(false)
+	{
+		//empty
+	}
+
+	BoundChannel::~BoundChannel()
+	{
+		//empty on purpose
+	}
+
+	void BoundChannel::publishLowerBound(delta_t delta)
+	{
+		if (delta <= 0) return;
+		const unsigned int doubleDelta = static_cast<unsigned int>(delta * 2);
+		unsigned int current = _doubleLowerBound;
+		while ( (doubleDelta > current) && !_doubleLowerBound.compare_exchange_weak(current, doubleDelta) );
+	}
+
+	void BoundChannel::publishUpperBound(delta_t delta)
+	{
+		if (delta < 0) return;
+		const unsigned int doubleDelta = static_cast<unsigned int>(floor(delta * 2));
+		unsigned int current = _doubleUpperBound;
+		while ( (doubleDelta < current) && !_doubleUpperBound.compare_exchange_weak(current, doubleDelta) );
+	}
+
+	delta_t BoundChannel::currentLowerBound() const
+	{
+		return _doubleLowerBound / 2.0;
+	}
+
+	delta_t BoundChannel::currentUpperBound() const
+	{
+		const unsigned int doubleUpperBound = _doubleUpperBound;
+		return (NoUpperBound == doubleUpperBound ? InfiniteDelta : doubleUpperBound / 2.0);
+	}
+
+	bool BoundChannel::isSettled() const
+	{
+		return (_doubleLowerBound >= _doubleUpperBound);
+	}
+
+	void BoundChannel::cancel()
+	{
+		_isCancelled = true;
+	}
+
+	bool BoundChannel::isCancelled() const
+	{
+		return (_isCancelled || isSettled());
+	}
+
+} // namespace hyperbolicity
@@ -0,0 +1,215 @@
+#include "FourPointKernel.h"
+#include <emmintrin.h>
+#include <algorithm>
+
+using namespace std;
+
+namespace hyperbolicity
+{
+	namespace
+	{
+		//candidates are processed in blocks - the lane range is verified per block, and the argmax is found by rescanning the best block
+		const size_t BlockSize = 512;
+
+		//distances (and constants) below this fit in 16-bit lanes without overflowing a sum
+		const compact_distance_t LaneLimit = 16384;
+
+		/*
+		 * @brief	Source of the three sums for the row form (a constant plus a row entry).
+		 */
+		struct RowSums
+		{
+			distance_t k1, k2, k3;
+			const compact_distance_t *r1, *r2, *r3;
+
+			bool fitsLanes() const
+			{
+				return (k1 >= 0 && k1 < LaneLimit && k2 >= 0 && k2 < LaneLimit && k3 >= 0 && k3 < LaneLimit);
+			}
+
+			bool isInfinite(size_t c) const
+			{
+				return (CompactInfiniteDistance == r1[c] || CompactInfiniteDistance == r2[c] || CompactInfiniteDistance == r3[c]);
+			}
+
+			void scalar(size_t c, distance_t& s1, distance_t& s2, distance_t& s3) const
+			{
+				s1 = k1 + r1[c];
+				s2 = k2 + r2[c];
+				s3 = k3 + r3[c];
+			}
+
+			__m128i combinedEntries(size_t c) const
+			{
+				__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r1 + c));
+				__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r2 + c));
+				__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r3 + c));
+				return _mm_or_si128(_mm_or_si128(a, b), d);
+			}
+
+			void vector(size_t c, __m128i& s1, __m128i& s2, __m128i& s3) const
+			{
+				s1 = _mm_add_epi16(_mm_set1_epi16(static_cast<short>(k1)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(r1 + c)));
+				s2 = _mm_add_epi16(_mm_set1_epi16(static_cast<short>(k2)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(r2 + c)));
+				s3 = _mm_add_epi16(_mm_set1_epi16(static_cast<short>(k3)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(r3 + c)));
+			}
+		};
+
+		/*
+		 * @brief	Source of the three sums for the gathered form (a sum of two gathered entries).
+		 */
+		struct PairSums
+		{
+			const compact_distance_t *a1, *b1, *a2, *b2, *a3, *b3;
+
+			bool fitsLanes() const
+			{
+				return true;
+			}
+
+			bool isInfinite(size_t c) const
+			{
+				return (CompactInfiniteDistance == a1[c] || CompactInfiniteDistance == b1[c] || CompactInfiniteDistance == a2[c] ||
+						CompactInfiniteDistance == b2[c] || CompactInfiniteDistance == a3[c] || CompactInfiniteDistance == b3[c]);
+			}
+
+			void scalar(size_t c, distance_t& s1, distance_t& s2, distance_t& s3) const
+			{
+				s1 = a1[c] + b1[c];
+				s2 = a2[c] + b2[c];
+				s3 = a3[c] + b3[c];
+			}
+
+			__m128i combinedEntries(size_t c) const
+			{
+				__m128i x = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a1 + c)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(b1 + c)));
+				__m128i y = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a2 + c)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(b2 + c)));
+				__m128i z = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a3 + c)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(b3 + c)));
+				return _mm_or_si128(_mm_or_si128(x, y), z);
+			}
+
+			void vector(size_t c, __m128i& s1, __m128i& s2, __m128i& s3) const
+			{
+				s1 = _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a1 + c)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(b1 + c)));
+				s2 = _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a2 + c)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(b2 + c)));
+				s3 = _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a3 + c)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(b3 + c)));
+			}
+		};
+
+		/*
+		 * @returns	The maximal signed 16-bit lane of v.
+		 */
+		short horizontalMax(__m128i v)
+		{
+			v = _mm_max_epi16(v, _mm_srli_si128(v, 8));
+			v = _mm_max_epi16(v, _mm_srli_si128(v, 4));
+			v = _mm_max_epi16(v, _mm_srli_si128(v, 2));
+			return static_cast<short>(_mm_cvtsi128_si32(v));
+		}
+
+		/*
+		 * @returns	The best double delta in [begin, end), evaluated one candidate at a time (candidates with an infinite distance are skipped).
+		 *			If index is not null, it is set to the first candidate achieving it (or to end if none was evaluated).
+		 */
+		template <typename Sums>
+		distance_t scanScalar(const Sums& sums, size_t begin, size_t end, size_t* index)
+		{
+			distance_t best = -1;
+			if (index) *index = end;
+			for (size_t c = begin; c < end; ++c)
+			{
+				if (sums.isInfinite(c)) continue;
+
+				distance_t s1, s2, s3;
+				sums.scalar(c, s1, s2, s3);
+				distance_t cur = FourPointKernel::doubleDelta(s1, s2, s3);
+				if (cur > best)
+				{
+					best = cur;
+					if (index) *index = c;
+				}
+			}
+			return best;
+		}
+
+		template <typename Sums>
+		FourPointKernel::Result scan(const Sums& sums, size_t count)
+		{
+			FourPointKernel::Result result = {-1, count};
+			size_t bestBlock = count;
+			const bool canVectorize = sums.fitsLanes();
+			const __m128i laneLimit = _mm_set1_epi16(static_cast<short>(LaneLimit - 1));
+
+			for (size_t begin = 0; begin < count; begin += BlockSize)
+			{
+				const size_t end = min(count, begin + BlockSize);
+				const size_t vectorEnd = begin + (end - begin) / 8 * 8;
+
+				//verify every entry of the block fits the lanes - if not, do it the slow way
+				bool isScalar = !canVectorize;
+				if (!isScalar)
+				{
+					//the lane limit is a power of 2, so the bitwise-or of the entries is below it iff all of them are
+					__m128i overflow = _mm_setzero_si128();
+					for (size_t c = begin; c < vectorEnd; c += 8)
+					{
+						overflow = _mm_or_si128(overflow, _mm_subs_epu16(sums.combinedEntries(c), laneLimit));
+					}
+					isScalar = (0xFFFF != _mm_movemask_epi8(_mm_cmpeq_epi16(overflow, _mm_setzero_si128())));
+				}
+
+				distance_t blockBest = -1;
+				if (isScalar)
+				{
+					blockBest = scanScalar(sums, begin, end, nullptr);
+				}
+				else
+				{
+					__m128i best = _mm_set1_epi16(-1);
+					for (size_t c = begin; c < vectorEnd; c += 8)
+					{
+						__m128i s1, s2, s3;
+						sums.vector(c, s1, s2, s3);
+						//largest minus median - median(a, b, c) = max(min(a, b), min(max(a, b), c))
+						__m128i high = _mm_max_epi16(_mm_max_epi16(s1, s2), s3);
+						__m128i median = _mm_max_epi16(_mm_min_epi16(s1, s2), _mm_min_epi16(_mm_max_epi16(s1, s2), s3));
+						best = _mm_max_epi16(best, _mm_sub_epi16(high, median));
+					}
+					blockBest = max<distance_t>(horizontalMax(best), scanScalar(sums, vectorEnd, end, nullptr));
+				}
+
+				if (blockBest > result.doubleDelta)
+				{
+					result.doubleDelta = blockBest;
+					bestBlock = begin;
+				}
+			}
+
+			//find the first candidate achieving the best value in its block
+			if (bestBlock < count) scanScalar(sums, bestBlock, min(count, bestBlock + BlockSize), &result.index);
+			if (result.doubleDelta < 0) result.doubleDelta = 0;
+			return result;
+		}
+	}
+
+	FourPointKernel::Result FourPointKernel::scanRows(distance_t k1, const compact_distance_t* r1, distance_t k2, const compact_distance_t* r2,
+													 distance_t k3, const compact_distance_t* r3, size_t count)
+	{
+		RowSums sums = {k1, k2, k3, r1, r2, r3};
+		return scan(sums, count);
+	}
+
+	FourPointKernel::Result FourPointKernel::scanPairs(const compact_distance_t* a1, const compact_distance_t* b1, const compact_distance_t* a2, const compact_distance_t* b2,
+													  const compact_distance_t* a3, const compact_distance_t* b3, size_t count)
+	{
+		PairSums sums = {a1, b1, a2, b2, a3, b3};
+		return scan(sums, count);
+	}
+
+	distance_t FourPointKernel::doubleDelta(distance_t s1, distance_t s2, distance_t s3)
+	{
+		distance_t high = max(max(s1, s2), s3);
+		distance_t median = max(min(s1, s2), min(max(s1, s2), s3));
+		return high - median;
+	}
+} // namespace hyperbolicity
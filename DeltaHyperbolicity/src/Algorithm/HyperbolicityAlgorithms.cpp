@@ -4,12 +4,157 @@
 #include "Graph/Node.h"
 #include "Graph/NodeDistances.h"
 #include "Graph/FurthestNode.h"
+#include "Graph/GraphAlgorithms.h"
+#include "Graph/ChainCore.h"
 #include "boost/format.hpp"
+#include <algorithm>
+#include <unordered_map>
 
 using namespace std;
 
 namespace hyperbolicity
 {
+	namespace
+	{
+		/*
+		 * @brief	Computes closures of node sets with respect to an anchor node (see HyperbolicityAlgorithms::findSplit()), reusing its
+		 *			buffers between runs.
+		 */
+		class SplitClosure
+		{
+		public:
+			SplitClosure(const CompactGraph& graph) : _graph(graph), _state(graph.size(), Outside), _count(graph.size(), 0),
+				_isAnchorNeighbor(graph.size(), false), _frontierSize(0)
+			{
+				//empty
+			}
+
+			/*
+			 * @param	initial	The nodes to start from (must not include the anchor).
+			 * @param	anchor	The node that must stay out.
+			 * @param	side	Will be set to the closure, if it is a side of a split.
+			 * @returns	Whether the closure is a side of a split, i.e. whether it leaves out at least 2 nodes.
+			 */
+			bool run(const vector<node_index_t>& initial, node_index_t anchor, vector<node_index_t>& side)
+			{
+				for (const unsigned int* w = _graph.neighborsBegin(anchor); w != _graph.neighborsEnd(anchor); ++w) _isAnchorNeighbor[*w] = true;
+				for (vector<node_index_t>::const_iterator it = initial.cbegin(); it != initial.cend(); ++it) enqueue(*it);
+
+				bool isSplit = true;
+				for (size_t next = 0; next < _pending.size(); ++next)
+				{
+					if (_side.size() + 2 >= _graph.size())
+					{
+						isSplit = false;
+						break;
+					}
+					add(_pending[next]);
+				}
+				if (isSplit) side = _side;
+
+				//reset everything touched, for the next run
+				for (const unsigned int* w = _graph.neighborsBegin(anchor); w != _graph.neighborsEnd(anchor); ++w) _isAnchorNeighbor[*w] = false;
+				for (vector<node_index_t>::const_iterator it = _pending.cbegin(); it != _pending.cend(); ++it) _state[*it] = Outside;
+				for (vector<node_index_t>::const_iterator it = _outside.cbegin(); it != _outside.cend(); ++it) _count[*it] = 0;
+				_pending.clear();
+				_side.clear();
+				_outside.clear();
+				_frontierSize = 0;
+				return isSplit;
+			}
+
+		private:
+			//do *not* allow copy ctor / assignment operator
+			SplitClosure(const SplitClosure&);
+			SplitClosure& operator=(const SplitClosure&);
+
+			enum NodeState { Outside, Pending, Inside };
+
+			void enqueue(node_index_t u)
+			{
+				if (Outside != _state[u]) return;
+				_state[u] = Pending;
+				_pending.push_back(u);
+			}
+
+			void add(node_index_t u)
+			{
+				_state[u] = Inside;
+				_side.push_back(u);
+
+				//a node that is not the anchor's neighbor is not a frontier node, so all of its neighbors are on its side
+				if (!_isAnchorNeighbor[u])
+				{
+					for (const unsigned int* w = _graph.neighborsBegin(u); w != _graph.neighborsEnd(u); ++w) enqueue(*w);
+					return;
+				}
+
+				//otherwise, the nodes left out must see either all of the frontier, like the anchor, or none of it (the nodes left out
+				//are only ever adjacent to frontier nodes, so counting their neighbors in it is enough)
+				++_frontierSize;
+				for (const unsigned int* w = _graph.neighborsBegin(u); w != _graph.neighborsEnd(u); ++w)
+				{
+					if (Outside != _state[*w]) continue;
+					if (0 == _count[*w]++) _outside.push_back(*w);
+					if (_count[*w] != _frontierSize) enqueue(*w);
+				}
+				for (vector<node_index_t>::const_iterator it = _outside.cbegin(); it != _outside.cend(); ++it)
+				{
+					if (Outside == _state[*it] && _count[*it] != _frontierSize) enqueue(*it);
+				}
+			}
+
+			const CompactGraph& _graph;
+			vector<NodeState> _state;
+			//number of frontier neighbors of each node left out, for the nodes in _outside (the nodes left out that have been counted)
+			vector<unsigned int> _count;
+			vector<node_index_t> _outside;
+			vector<bool> _isAnchorNeighbor;
+			size_t _frontierSize;
+			//nodes that must join, in the order they were found (the first ones are already in _side)
+			vector<node_index_t> _pending;
+			vector<node_index_t> _side;
+		};
+
+		/*
+		 * @returns	A random number in [0, bound). rand() may only give 15 bits (RAND_MAX is 32767 on MSVC), so calls are combined for
+		 *			large bounds.
+		 */
+		size_t randomIndex(size_t bound)
+		{
+			unsigned long long value = rand();
+			for (unsigned long long range = RAND_MAX; range < bound; range = range * (RAND_MAX + 1ULL) + RAND_MAX)
+			{
+				value = value * (RAND_MAX + 1ULL) + rand();
+			}
+			return static_cast<size_t>(value % bound);
+		}
+
+		//marks a node that was not reached, or has no parent
+		const node_index_t NoNode = static_cast<node_index_t>(-1);
+
+		/*
+		 * @brief	Runs a BFS from the source, without passing through the excluded node (NoNode to exclude none).
+		 * @param	parent	Will be set to the BFS parent of every node reached (the source is its own parent), NoNode for the others.
+		 */
+		void bfsParents(const CompactGraph& graph, node_index_t source, node_index_t excluded, vector<node_index_t>& parent)
+		{
+			parent.assign(graph.size(), NoNode);
+			parent[source] = source;
+			vector<node_index_t> queue(1, source);
+			for (size_t next = 0; next < queue.size(); ++next)
+			{
+				const node_index_t u = queue[next];
+				for (const unsigned int* w = graph.neighborsBegin(u); w != graph.neighborsEnd(u); ++w)
+				{
+					if ( (NoNode != parent[*w]) || (*w == excluded) ) continue;
+					parent[*w] = u;
+					queue.push_back(*w);
+				}
+			}
+		}
+	}
+
 	delta_t HyperbolicityAlgorithms::calculateDelta(const graph_ptr_t graph, const node_combination_t& state)
 	{
 		node_ptr_collection_t nodeCollection;
@@ -74,7 +219,7 @@ namespace hyperbolicity
 		if (nullptr == startNode.get())
 		{
 			//randomly select start node
-			startNode = graph->getNode(rand() % graph->size());
+			startNode = graph->getNode(randomIndex(graph->size()));
 		}
 
 		//perform the double sweep
@@ -94,6 +239,38 @@ namespace hyperbolicity
 		return res;
 	}
 
+	HyperbolicityAlgorithms::CompactSweepResult HyperbolicityAlgorithms::doubleSweep(const CompactGraph& graph, MultiSourceBFS& bfs, RandomStream& random,
+		compact_distance_t* uRow, compact_distance_t* scratchRow)
+	{
+		bfs.run(static_cast<node_index_t>(random.nextIndex(graph.size())), scratchRow);
+		CompactSweepResult res;
+		res.u = selectFurthest(scratchRow, graph.size(), random);
+		bfs.run(res.u, uRow);
+		res.v = selectFurthest(uRow, graph.size(), random);
+		res.dist = uRow[res.v];
+		return res;
+	}
+
+	node_index_t HyperbolicityAlgorithms::selectFurthest(const compact_distance_t* row, size_t size, RandomStream& random)
+	{
+		//reservoir sampling - the k'th node found at the largest distance replaces the selected one with probability 1/k
+		node_index_t selected = 0;
+		compact_distance_t furthest = 0;
+		size_t count = 0;
+		for (node_index_t i = 0; i < size; ++i)
+		{
+			if ( (CompactInfiniteDistance == row[i]) || (row[i] < furthest) ) continue;
+			if (row[i] > furthest)
+			{
+				furthest = row[i];
+				count = 0;
+			}
+			if (0 == random.nextIndex(++count)) selected = i;
+		}
+
+		return selected;
+	}
+
 	node_combination_t HyperbolicityAlgorithms::getRandomState(const graph_ptr_t graph)
 	{
 		//choose initial state at random
@@ -107,7 +284,7 @@ namespace hyperbolicity
 			do
 			{
                 //select a random node
-				node_index_t index = rand() % graph->size();
+				node_index_t index = randomIndex(graph->size());
 				randomState[i] = graph->getNode(index);
 
                 //assume unique until proven otherwise
@@ -267,74 +444,280 @@ namespace hyperbolicity
 	}
 
 	void HyperbolicityAlgorithms::pruneTrees(graph_ptr_t graph)
-    {
-        //unmark all nodes
-        graph->unmarkNodes();
+	{
+		vector<node_index_t> core = GraphAlgorithms::getTwoCore(CompactGraph(graph));
 
-        unsigned int removed = 0;
+		//mark the nodes outside the 2-core, and delete them all at once (deletion one node at a time is VERY expensive!)
+		graph->unmarkNodes();
+		for (node_index_t i = 0, next = 0; i < graph->size(); ++i)
+		{
+			if ( (next < core.size()) && (core[next] == i) )
+			{
+				++next;
+				continue;
+			}
+			graph->getNode(i)->setMarked(true);
+		}
 
-        //run on all nodes, mark the ones that need to be removed
-        for (unsigned int i = 0; i < graph->size(); ++i)
-        {
-			node_ptr_t curNode = graph->getNode(i);
-            //check if current node needs to be pruned & not already pruned
-            if ( (countUnmarkedNeighbors(curNode) <= 1) && (!curNode->isMarked()) )
-            {
-                //prune node recursively
-                removed += pruneTreesRecursion(curNode);
-            }
-        }
-
-        //instead of deleting a ton of unnecessary nodes (deletion is VERY expensive!), we create
-        //a new collection and copy only the necessary nodes into it, while setting their index appropriately
-        //tests: using deletion, pruning of a large graph (1M+ nodes) took ~310 seconds. with this method - 0.238 seconds!!!
-
-        graph->deleteMarkedNodes();
-    }
-
-    unsigned int HyperbolicityAlgorithms::countUnmarkedNeighbors(const node_ptr_t node)
-    {
-        unsigned int unmarkedNodes = 0;
-        const node_weak_ptr_collection_t& neighbors = node->getEdges();
-        for (node_weak_ptr_collection_t::const_iterator it = neighbors.cbegin(); it != neighbors.cend(); ++it)
-        {
-            if (!it->lock()->isMarked()) ++unmarkedNodes;
-        }
-
-        return unmarkedNodes;
-    }
-
-	unsigned int HyperbolicityAlgorithms::pruneTreesRecursion(node_ptr_t curNode)
-    {
-        unsigned int edgesLen = countUnmarkedNeighbors(curNode);
-        
-        //assert degree is <= 1
-        if (edgesLen > 1) throw std::exception("Pruned node degree is > 1");
-
-        //if node has a neighbor (can have only 1, if any), remember it before we remove the edge
-        node_ptr_t neighbor(nullptr);
-        if (1 == edgesLen) neighbor = getUnmarkedNeighbor(curNode);
-
-        //mark node for pruning
-        curNode->setMarked(true);
-        unsigned int marked = 1;
-
-        //if the pruned node had a neighbor, and it has now become a leaf, prune it recursively
-        if ( (nullptr != neighbor.get()) && (countUnmarkedNeighbors(neighbor)) <= 1) marked += pruneTreesRecursion(neighbor);
-
-        return marked;
-    }
-
-    node_ptr_t HyperbolicityAlgorithms::getUnmarkedNeighbor(const node_ptr_t node)
-    {
-        const node_weak_ptr_collection_t& neighbors = node->getEdges();
-        for (node_weak_ptr_collection_t::const_iterator it = neighbors.cbegin(); it != neighbors.cend(); ++it)
-        {
-            if (!it->lock()->isMarked()) return it->lock();
-        }
-
-        throw std::exception("No unmarked neighbor found!");
-    }
+		graph->deleteMarkedNodes();
+	}
+
+	DeltaHyperbolicity HyperbolicityAlgorithms::getChainCycleDelta(const graph_ptr_t graph, size_t& chainCount)
+	{
+		CompactGraph compactGraph(graph);
+		ChainCore core(compactGraph);
+		chainCount = core.chainCount();
+
+		//cycleDelta() is not monotone in the length, so every chain's cycle is checked
+		size_t bestChain = 0;
+		delta_t bestDelta = 0;
+		for (size_t i = 0; i < core.chainCount(); ++i)
+		{
+			const delta_t curDelta = cycleDelta(core.getChain(i).cycleLength);
+			if (curDelta <= bestDelta) continue;
+			bestDelta = curDelta;
+			bestChain = i;
+		}
+		if (0 == bestDelta) return DeltaHyperbolicity();
+
+		//the nodes a quarter of the cycle apart attain its delta
+		const vector<node_index_t> cycle = core.getCycle(bestChain);
+		const size_t length = cycle.size();
+		return DeltaHyperbolicity(bestDelta, node_combination_t(graph->getNode(cycle[0]), graph->getNode(cycle[length / 4]),
+			graph->getNode(cycle[length / 2]), graph->getNode(cycle[3 * length / 4])));
+	}
+
+	HyperbolicityAlgorithms::WeightedCore HyperbolicityAlgorithms::getChainCore(const graph_ptr_t graph)
+	{
+		CompactGraph compactGraph(graph);
+		ChainCore core(compactGraph);
+		WeightedCore result;
+		result.weights = core.createCoreGraph();
+
+		result.chainReach = 0;
+		for (size_t i = 0; i < core.chainCount(); ++i)
+		{
+			result.chainReach = max(result.chainReach, static_cast<distance_t>(core.getChain(i).length / 2));
+		}
+
+		//the core nodes keep their core indices, and every chain becomes an edge between its ends
+		for (unsigned int i = 0; i < core.size(); ++i)
+		{
+			result.nodes.push_back(core.getNode(i));
+		}
+		result.graph = GraphAlgorithms::getInducedSubgraph(graph, result.nodes, (boost::format("%1%_core") % graph->getTitle()).str());
+		for (node_index_t u = 0; u < result.weights->size(); ++u)
+		{
+			for (const unsigned int* v = result.weights->neighborsBegin(u); v != result.weights->neighborsEnd(u); ++v)
+			{
+				if ( (u < *v) && !result.graph->getNode(u)->hasEdge(result.graph->getNode(*v)) )
+				{
+					result.graph->getNode(u)->insertBidirectionalEdgeTo(result.graph->getNode(*v));
+				}
+			}
+		}
+		return result;
+	}
+
+	DeltaHyperbolicity HyperbolicityAlgorithms::reduceFalseTwins(graph_ptr_t graph)
+	{
+		//sorted neighborhood of every node, grouped by its hash
+		vector<vector<node_index_t>> neighbors(graph->size());
+		unordered_map<size_t, vector<node_index_t>> nodesByHash;
+		for (node_index_t i = 0; i < graph->size(); ++i)
+		{
+			const node_weak_ptr_collection_t& edges = graph->getNode(i)->getEdges();
+			for (node_weak_ptr_collection_t::const_iterator it = edges.cbegin(); it != edges.cend(); ++it)
+			{
+				neighbors[i].push_back(it->lock()->getIndex());
+			}
+			sort(neighbors[i].begin(), neighbors[i].end());
+
+			size_t hash = neighbors[i].size();
+			for (vector<node_index_t>::const_iterator it = neighbors[i].cbegin(); it != neighbors[i].cend(); ++it)
+			{
+				hash ^= *it + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+			}
+			nodesByHash[hash].push_back(i);
+		}
+
+		//within each bucket, the first node of every class is kept and the rest of it is marked (and its first twin remembered)
+		graph->unmarkNodes();
+		unordered_map<node_index_t, node_index_t> twinOf;
+		for (unordered_map<size_t, vector<node_index_t>>::const_iterator bucketIt = nodesByHash.cbegin(); bucketIt != nodesByHash.cend(); ++bucketIt)
+		{
+			const vector<node_index_t>& bucket = bucketIt->second;
+			vector<node_index_t> representatives;
+			for (vector<node_index_t>::const_iterator it = bucket.cbegin(); it != bucket.cend(); ++it)
+			{
+				vector<node_index_t>::const_iterator repIt = representatives.cbegin();
+				while ( (repIt != representatives.cend()) && (neighbors[*repIt] != neighbors[*it]) ) ++repIt;
+				if (repIt == representatives.cend())
+				{
+					representatives.push_back(*it);
+				}
+				else
+				{
+					graph->getNode(*it)->setMarked(true);
+					if (0 == twinOf.count(*repIt)) twinOf[*repIt] = *it;
+				}
+			}
+		}
+
+		if (twinOf.empty()) return DeltaHyperbolicity();
+
+		//find the quad of largest delta holding two twins - two of their neighbors, non-adjacent if possible
+		delta_t bestDelta = 0;
+		node_combination_t bestState;
+		for (unordered_map<node_index_t, node_index_t>::const_iterator it = twinOf.cbegin(); (it != twinOf.cend()) && (bestDelta < 1); ++it)
+		{
+			const vector<node_index_t>& common = neighbors[it->first];
+			for (size_t i = 0; (i < common.size()) && (bestDelta < 1); ++i)
+			{
+				const vector<node_index_t>& fromI = neighbors[common[i]];
+				for (size_t j = i + 1; (j < common.size()) && (bestDelta < 1); ++j)
+				{
+					delta_t curDelta = (binary_search(fromI.cbegin(), fromI.cend(), common[j]) ? 0.5 : 1);
+					if (curDelta <= bestDelta) continue;
+
+					bestDelta = curDelta;
+					bestState.reset(graph->getNode(it->first), graph->getNode(it->second), graph->getNode(common[i]), graph->getNode(common[j]));
+				}
+			}
+		}
+
+		graph->deleteMarkedNodes();
+
+		if (0 == bestDelta) return DeltaHyperbolicity();
+		return DeltaHyperbolicity(bestDelta, bestState);
+	}
+
+	graph_ptr_collection_t HyperbolicityAlgorithms::getSplitComponents(const graph_ptr_t graph, unsigned long long maxCost, DeltaHyperbolicity& splitDelta)
+	{
+		graph_ptr_collection_t components;
+		graph_ptr_collection_t pending(1, graph);
+		delta_t bestDelta = 0;
+		node_combination_t bestState;
+		unsigned int splitCount = 0;
+		vector<node_index_t> side;
+		while (!pending.empty())
+		{
+			graph_ptr_t curGraph = pending.back();
+			pending.pop_back();
+
+			//findSplit() tries (minimal degree + 1) * n closures, each going over the edges
+			CompactGraph compactGraph(curGraph);
+			size_t minDegree = compactGraph.degree(0);
+			for (node_index_t u = 1; u < curGraph->size(); ++u) minDegree = min(minDegree, compactGraph.degree(u));
+			const unsigned long long cost = (minDegree + 1ULL) * curGraph->size() * (compactGraph.edgeCount() / 2);
+			if ( (cost > maxCost) || !findSplit(compactGraph, side) )
+			{
+				components.push_back(curGraph);
+				continue;
+			}
+
+			//find the other side, and the frontier of both
+			vector<bool> isInSide(curGraph->size(), false);
+			for (vector<node_index_t>::const_iterator it = side.cbegin(); it != side.cend(); ++it) isInSide[*it] = true;
+			vector<node_index_t> other, sideFrontier, otherFrontier;
+			for (node_index_t u = 0; u < curGraph->size(); ++u)
+			{
+				if (!isInSide[u]) other.push_back(u);
+				for (const unsigned int* w = compactGraph.neighborsBegin(u); w != compactGraph.neighborsEnd(u); ++w)
+				{
+					if (isInSide[u] == isInSide[*w]) continue;
+					(isInSide[u] ? sideFrontier : otherFrontier).push_back(u);
+					break;
+				}
+			}
+
+			//quads crossing the split - each pair on the same side is at distance 1 or 2, and each of the pairs across it at distance 1
+			node_index_t a1, a2, b1, b2;
+			unsigned int sideValue = pickFrontierPair(compactGraph, sideFrontier, a1, a2);
+			unsigned int otherValue = pickFrontierPair(compactGraph, otherFrontier, b1, b2);
+			delta_t curDelta = (static_cast<delta_t>(sideValue + otherValue) - 2) / 2;
+			if (curDelta > bestDelta)
+			{
+				bestDelta = curDelta;
+				bestState.reset(curGraph->getNode(a1), curGraph->getNode(a2), curGraph->getNode(b1), curGraph->getNode(b2));
+			}
+
+			//each component is its side, with a frontier node of the other side in place of the rest of it
+			side.push_back(otherFrontier.front());
+			other.push_back(sideFrontier.front());
+			pending.push_back(GraphAlgorithms::getInducedSubgraph(curGraph, side, (boost::format("%1%_%2%") % graph->getTitle() % ++splitCount).str()));
+			pending.push_back(GraphAlgorithms::getInducedSubgraph(curGraph, other, (boost::format("%1%_%2%") % graph->getTitle() % ++splitCount).str()));
+		}
+
+		splitDelta = (0 == bestDelta ? DeltaHyperbolicity() : DeltaHyperbolicity(bestDelta, bestState));
+		return components;
+	}
+
+	HyperbolicityAlgorithms::GraphClass HyperbolicityAlgorithms::classify(const graph_ptr_t graph, DeltaHyperbolicity& lowerBound, delta_t& upperBound)
+	{
+		lowerBound = DeltaHyperbolicity();
+		upperBound = InfiniteDelta;
+		const size_t n = graph->size();
+		if (n < node_combination_t::size()) return GeneralGraph;
+
+		CompactGraph compactGraph(graph);
+		const size_t edgeCount = compactGraph.edgeCount() / 2;
+		//every quad of a complete graph, or of a cactus without a cycle longer than 3, has delta 0
+		const node_combination_t anyState(graph->getNode(0), graph->getNode(1), graph->getNode(2), graph->getNode(3));
+
+		if (edgeCount == n * (n - 1) / 2)
+		{
+			lowerBound = DeltaHyperbolicity(0, anyState);
+			upperBound = 0;
+			return CompleteGraph;
+		}
+
+		//a cactus has at most 3 edges for every 2 nodes beyond the first
+		vector<node_index_t> cycle;
+		if ( (2 * edgeCount <= 3 * (n - 1)) && findCactusCycle(compactGraph, cycle) )
+		{
+			//the cycles of a cactus are isometric, and the nodes a quarter of the cycle apart attain its delta
+			upperBound = cycleDelta(cycle.size());
+			if (0 == upperBound)
+			{
+				lowerBound = DeltaHyperbolicity(0, anyState);
+			}
+			else
+			{
+				const size_t length = cycle.size();
+				lowerBound = DeltaHyperbolicity(upperBound, node_combination_t(graph->getNode(cycle[0]), graph->getNode(cycle[length / 4]),
+					graph->getNode(cycle[length / 2]), graph->getNode(cycle[3 * length / 4])));
+			}
+			return CactusGraph;
+		}
+
+		if (!isChordal(compactGraph)) return GeneralGraph;
+		upperBound = 1;
+
+		//a node y at distance 2 from a node x, through z, gives the induced path x - z - y. In a 2-connected chordal graph, every node of
+		//the shortest path from x to y that avoids z is adjacent to z (the cycle they close has no other chords), so for the first nodes of
+		//that path, x - p1 - p2, the quad x, z, p1, p2 has delta 0.5 (its delta is calculated anyway, as the graph may not be 2-connected)
+		node_index_t x = 0;
+		while (compactGraph.degree(x) == n - 1) ++x;
+		vector<node_index_t> parent;
+		bfsParents(compactGraph, x, NoNode, parent);
+		node_index_t y = 0;
+		while ( (y < n) && ( (NoNode == parent[y]) || (y == x) || (parent[y] == x) || (parent[parent[y]] != x) ) ) ++y;
+		//x's component is a clique
+		if (y == n) return ChordalGraph;
+
+		const node_index_t z = parent[y];
+		bfsParents(compactGraph, x, z, parent);
+		//z is a cut node
+		if (NoNode == parent[y]) return ChordalGraph;
+
+		node_index_t p2 = y;
+		while (parent[parent[p2]] != x) p2 = parent[p2];
+		const node_combination_t state(graph->getNode(x), graph->getNode(z), graph->getNode(parent[p2]), graph->getNode(p2));
+		const delta_t delta = calculateDelta(graph, state);
+		if (delta > 0) lowerBound = DeltaHyperbolicity(delta, state);
+		return ChordalGraph;
+	}
 
     delta_t HyperbolicityAlgorithms::cycleDelta(size_t length)
 	{
@@ -368,7 +751,7 @@ namespace hyperbolicity
 		}
 
 		//randomly select node out of the furthest nodes
-		unsigned int selectedNodeIndex = rand() % furthestNodes.size();
+		size_t selectedNodeIndex = randomIndex(furthestNodes.size());
 		if (dist) *dist = maxDistance;
 		return furthestNodes[selectedNodeIndex];
 	}
@@ -385,4 +768,193 @@ namespace hyperbolicity
 		return false;
 	}
 
+	bool HyperbolicityAlgorithms::findSplit(const CompactGraph& graph, vector<node_index_t>& side)
+	{
+		const size_t n = graph.size();
+		if (n < 4) return false;
+
+		node_index_t x = 0;
+		for (node_index_t u = 1; u < n; ++u)
+		{
+			if (graph.degree(u) < graph.degree(x)) x = u;
+		}
+
+		SplitClosure closure(graph);
+		vector<node_index_t> initial(2, x);
+
+		//x is in A' - then B' is within its neighbors, and A has another node
+		for (const unsigned int* anchor = graph.neighborsBegin(x); anchor != graph.neighborsEnd(x); ++anchor)
+		{
+			for (node_index_t y = 0; y < n; ++y)
+			{
+				if (x == y || *anchor == y) continue;
+				initial[1] = y;
+				if (closure.run(initial, *anchor, side)) return true;
+			}
+		}
+
+		//x is not in A' - then all of its neighbors are in A, and B' may hold any other node
+		initial.assign(graph.neighborsBegin(x), graph.neighborsEnd(x));
+		initial.push_back(x);
+		if (initial.size() + 2 > n) return false;
+		vector<bool> isInitial(n, false);
+		for (vector<node_index_t>::const_iterator it = initial.cbegin(); it != initial.cend(); ++it) isInitial[*it] = true;
+		for (node_index_t anchor = 0; anchor < n; ++anchor)
+		{
+			if (!isInitial[anchor] && closure.run(initial, anchor, side)) return true;
+		}
+
+		return false;
+	}
+
+	unsigned int HyperbolicityAlgorithms::pickFrontierPair(const CompactGraph& graph, const vector<node_index_t>& frontier, node_index_t& u, node_index_t& v)
+	{
+		u = v = frontier.front();
+		if (frontier.size() < 2) return 0;
+
+		vector<bool> isNeighbor(graph.size(), false);
+		for (vector<node_index_t>::const_iterator it = frontier.cbegin(); it != frontier.cend(); ++it)
+		{
+			for (const unsigned int* w = graph.neighborsBegin(*it); w != graph.neighborsEnd(*it); ++w) isNeighbor[*w] = true;
+			for (vector<node_index_t>::const_iterator other = frontier.cbegin(); other != frontier.cend(); ++other)
+			{
+				if (*other == *it || isNeighbor[*other]) continue;
+				u = *it;
+				v = *other;
+				return 2;
+			}
+			for (const unsigned int* w = graph.neighborsBegin(*it); w != graph.neighborsEnd(*it); ++w) isNeighbor[*w] = false;
+		}
+
+		//the frontier is a clique
+		v = frontier[1];
+		return 1;
+	}
+
+	bool HyperbolicityAlgorithms::findCactusCycle(const CompactGraph& graph, vector<node_index_t>& deltaCycle)
+	{
+		const size_t n = graph.size();
+		deltaCycle.clear();
+		vector<node_index_t> parent(n, NoNode);
+		vector<size_t> depth(n, 0);
+		//whether the tree edge from each node to its parent is on a cycle already
+		vector<bool> isOnCycle(n, false);
+
+		//the DFS path, and the next neighbor to go over of each node on it
+		vector<node_index_t> path(1, 0);
+		vector<const unsigned int*> next(1, graph.neighborsBegin(0));
+		parent[0] = 0;
+		size_t visitedCount = 1;
+		while (!path.empty())
+		{
+			const node_index_t u = path.back();
+			if (next.back() == graph.neighborsEnd(u))
+			{
+				path.pop_back();
+				next.pop_back();
+				continue;
+			}
+
+			const node_index_t w = *next.back()++;
+			if (NoNode == parent[w])
+			{
+				parent[w] = u;
+				depth[w] = depth[u] + 1;
+				++visitedCount;
+				path.push_back(w);
+				next.push_back(graph.neighborsBegin(w));
+				continue;
+			}
+
+			//a back edge is seen from both of its nodes - it is handled from the lower one, where it goes up to an ancestor
+			if ( (w == parent[u]) || (depth[w] > depth[u]) ) continue;
+
+			for (node_index_t cur = u; cur != w; cur = parent[cur])
+			{
+				if (isOnCycle[cur]) return false;
+				isOnCycle[cur] = true;
+			}
+			if (cycleDelta(depth[u] - depth[w] + 1) > cycleDelta(deltaCycle.size()))
+			{
+				deltaCycle.clear();
+				for (node_index_t cur = u; cur != w; cur = parent[cur]) deltaCycle.push_back(cur);
+				deltaCycle.push_back(w);
+			}
+		}
+
+		return (visitedCount == n);
+	}
+
+	bool HyperbolicityAlgorithms::isChordal(const CompactGraph& graph)
+	{
+		const size_t n = graph.size();
+
+		//LexBFS by partition refinement - the nodes not visited yet are kept in order, in cells of equal labels, largest label first.
+		//visiting a node moves each of its unvisited neighbors to the front of its cell, into a new cell placed right before it
+		vector<node_index_t> order(n), position(n);
+		for (node_index_t u = 0; u < n; ++u) order[u] = position[u] = u;
+		vector<size_t> cellOf(n, 0);
+		vector<size_t> cellBegin(1, 0), cellEnd(1, n);
+		//the cell split off from each cell by the current visit, and the visit that split it
+		vector<size_t> splitInto(1, 0), splitBy(1, n);
+		for (size_t i = 0; i < n; ++i)
+		{
+			const node_index_t v = order[i];
+			++cellBegin[cellOf[v]];
+			for (const unsigned int* w = graph.neighborsBegin(v); w != graph.neighborsEnd(v); ++w)
+			{
+				if (position[*w] <= i) continue;
+
+				const size_t cell = cellOf[*w];
+				if (splitBy[cell] != i)
+				{
+					splitBy[cell] = i;
+					splitInto[cell] = cellBegin.size();
+					cellBegin.push_back(cellBegin[cell]);
+					cellEnd.push_back(cellBegin[cell]);
+					splitInto.push_back(0);
+					splitBy.push_back(n);
+				}
+
+				const size_t newCell = splitInto[cell];
+				const node_index_t first = order[cellBegin[cell]];
+				swap(order[position[*w]], order[cellBegin[cell]]);
+				swap(position[*w], position[first]);
+				++cellBegin[cell];
+				++cellEnd[newCell];
+				cellOf[*w] = newCell;
+			}
+		}
+
+		//the reverse order is a perfect elimination order iff the neighbors of every node visited before it, other than the last one
+		//visited, are all neighbors of that last one
+		vector<vector<node_index_t>> required(n);
+		for (node_index_t v = 0; v < n; ++v)
+		{
+			node_index_t last = NoNode;
+			for (const unsigned int* w = graph.neighborsBegin(v); w != graph.neighborsEnd(v); ++w)
+			{
+				if ( (position[*w] < position[v]) && ( (NoNode == last) || (position[*w] > position[last]) ) ) last = *w;
+			}
+			if (NoNode == last) continue;
+
+			for (const unsigned int* w = graph.neighborsBegin(v); w != graph.neighborsEnd(v); ++w)
+			{
+				if ( (position[*w] < position[v]) && (*w != last) ) required[last].push_back(*w);
+			}
+		}
+
+		vector<node_index_t> neighborOf(n, NoNode);
+		for (node_index_t u = 0; u < n; ++u)
+		{
+			for (const unsigned int* w = graph.neighborsBegin(u); w != graph.neighborsEnd(u); ++w) neighborOf[*w] = u;
+			for (vector<node_index_t>::const_iterator it = required[u].cbegin(); it != required[u].cend(); ++it)
+			{
+				if (neighborOf[*it] != u) return false;
+			}
+		}
+
+		return true;
+	}
+
 } // namespace hyperbolicity
\ No newline at end of file
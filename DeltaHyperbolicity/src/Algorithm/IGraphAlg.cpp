@@ -3,13 +3,15 @@
 #include "Graph\Graph.h"
 #include "Graph\GraphAlgorithms.h"
 #include <string>
+#include <memory>
+#include <algorithm>
 
 using namespace std;
 
 namespace hyperbolicity
 {
 
-	IGraphAlg::IGraphAlg()
+	IGraphAlg::IGraphAlg() : _deadline(NoDeadline), _threadLimit(NoThreadLimit), _progress(0)
 	{
 		//empty
 	}
@@ -19,27 +21,116 @@ namespace hyperbolicity
 		//empty
 	}
 
-	void IGraphAlg::initialize(const graph_ptr_t graph, const node_combination_t& initialState /* = node_combination_t() */)
+	void IGraphAlg::initialize(const graph_ptr_t graph, const node_combination_t& initialState /* = node_combination_t() */,
+		const bound_channel_ptr_t& bounds /* = bound_channel_ptr_t() */)
 	{
 		validateGraphInput(graph);
 		_graph = graph;
+		_bounds = (nullptr == bounds.get() ? make_shared<BoundChannel>() : bounds);
+		_progress = 0;
 
-		//run derived class initialization
+		//run derived class initialization - an exact algorithm may already be complete (e.g. if nothing can beat the lower bound given)
 		initImpl(initialState);
+		if (isExact() && isComplete()) publishUpperBound(currentLowerBound());
 	}
 
 	DeltaHyperbolicity IGraphAlg::step()
 	{
 		if (isComplete()) throw std::logic_error("Algorithm has already completed its run, cannot perform another step");
+		if (isStopRequested()) throw std::logic_error("Algorithm was asked to stop, cannot perform another step");
+		_progress = 0;
 
 		//run a single step
-		return stepImpl();
+		DeltaHyperbolicity result = stepImpl();
+		publishLowerBound(result.getDelta());
+		if (isExact() && isComplete()) publishUpperBound(currentLowerBound());
+		return result;
+	}
+
+	bool IGraphAlg::isExact() const
+	{
+		return false;
+	}
+
+	std::string IGraphAlg::getStatistics() const
+	{
+		return string();
+	}
+
+	void IGraphAlg::setDeadline(clock_t deadline)
+	{
+		_deadline = deadline;
+	}
+
+	void IGraphAlg::setThreadLimit(unsigned int threadLimit)
+	{
+		_threadLimit = threadLimit;
+	}
+
+	void IGraphAlg::setWeightedGraph(const compact_graph_ptr_t& weightedGraph)
+	{
+		_weightedGraph = weightedGraph;
+	}
+
+	bool IGraphAlg::supportsWeightedGraph() const
+	{
+		return false;
+	}
+
+	bool IGraphAlg::isStopRequested() const
+	{
+		if ( (nullptr != _bounds.get()) && (_bounds->isCancelled()) ) return true;
+		return ( (NoDeadline != _deadline) && (clock() >= _deadline) );
+	}
+
+	double IGraphAlg::getProgress() const
+	{
+		return _progress;
+	}
+
+	void IGraphAlg::reportProgress(double progress)
+	{
+		_progress = progress;
+	}
+
+	unsigned int IGraphAlg::limitThreads(unsigned int threadCount) const
+	{
+		if (NoThreadLimit != _threadLimit) threadCount = min(threadCount, _threadLimit);
+		return max(1u, threadCount);
+	}
+
+	compact_graph_ptr_t IGraphAlg::getCompactGraph() const
+	{
+		return (nullptr == _weightedGraph.get() ? make_shared<CompactGraph>(_graph) : _weightedGraph);
+	}
+
+	void IGraphAlg::publishLowerBound(delta_t delta)
+	{
+		_bounds->publishLowerBound(delta);
+	}
+
+	void IGraphAlg::publishUpperBound(delta_t delta)
+	{
+		_bounds->publishUpperBound(delta);
+	}
+
+	delta_t IGraphAlg::currentLowerBound() const
+	{
+		return _bounds->currentLowerBound();
+	}
+
+	delta_t IGraphAlg::currentUpperBound() const
+	{
+		return _bounds->currentUpperBound();
 	}
 
 	void IGraphAlg::validateGraphInput(const graph_ptr_t graph) const
 	{
 		if (nullptr == graph.get()) throw std::exception("Graph pointer is invalid");
 		if (graph->size() < node_combination_t::size()) throw std::exception("Graph does not contain enough nodes");
+		if (nullptr == _weightedGraph.get()) return;
+		if (!supportsWeightedGraph()) throw std::exception("Algorithm does not support weighted graphs");
+		if (_weightedGraph->size() != graph->size()) throw std::exception("Weighted graph does not match the graph");
 	}
 
 } // namespace hyperbolicity
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include "ParallelSampler.h"
+#include <atomic>
+#include <exception>
+#include <algorithm>
+
+using namespace std;
+
+namespace hyperbolicity
+{
+
+	ParallelSampler::Worker::Worker(const CompactGraph& graph, unsigned long long seed, unsigned long long stream, size_t rowCount) :
+		bfs(graph), random(seed, stream), rows(rowCount, vector<compact_distance_t>(graph.size()))
+	{
+		//empty
+	}
+
+	ParallelSampler::ParallelSampler(const CompactGraph& graph, unsigned int threadCount, size_t rowsPerWorker, unsigned long long seed) :
+		_pool(threadCount)
+	{
+		for (unsigned int i = 0; i < max(1u, threadCount); ++i)
+		{
+			_workers.push_back(shared_ptr<Worker>(new Worker(graph, seed, i, rowsPerWorker)));
+		}
+	}
+
+	ParallelSampler::~ParallelSampler()
+	{
+		//empty on purpose
+	}
+
+	ParallelSampler::Sample ParallelSampler::run(size_t sampleCount, const sample_method_t& sampleOnce)
+	{
+		//each worker keeps its own best sample, and the best delta is shared (doubled, so that it is compared & swapped as an integer)
+		atomic<size_t> nextSample(0);
+		atomic<distance_t> bestDoubleDelta(-1);
+		vector<Sample> results(_workers.size());
+		_pool.run([this, sampleCount, &sampleOnce, &nextSample, &bestDoubleDelta, &results](unsigned int i)
+		{
+			try
+			{
+				results[i].doubleDelta = -1;
+				Sample sample;
+				while (nextSample++ < sampleCount)
+				{
+					sample.doubleDelta = -1;
+					sampleOnce(*_workers[i], sample);
+
+					//only a sample better than every other worker's so far is kept
+					distance_t shared = bestDoubleDelta;
+					while ( (sample.doubleDelta > shared) && !bestDoubleDelta.compare_exchange_weak(shared, sample.doubleDelta) );
+					if (sample.doubleDelta > shared) results[i] = sample;
+				}
+			}
+			catch (...)
+			{
+				//the other workers are stopped by taking the rest of the samples
+				nextSample = sampleCount;
+				throw;
+			}
+		});
+
+		const Sample* best = &results.front();
+		for (auto it = results.cbegin(); it != results.cend(); ++it)
+		{
+			if (it->doubleDelta > best->doubleDelta) best = &*it;
+		}
+		return *best;
+	}
+
+	unsigned int ParallelSampler::threadCount() const
+	{
+		return static_cast<unsigned int>(_workers.size());
+	}
+
+} // namespace hyperbolicity
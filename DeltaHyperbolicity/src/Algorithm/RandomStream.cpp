@@ -0,0 +1,50 @@
+#include "RandomStream.h"
+#include <time.h>
+
+namespace hyperbolicity
+{
+	namespace
+	{
+		//the golden ratio in 64 bits - consecutive counters are spread by it before mixing
+		const unsigned long long GoldenGamma = 0x9E3779B97F4A7C15ULL;
+	}
+
+	RandomStream::RandomStream(unsigned long long seed, unsigned long long stream) : _key(mix(mix(seed) + stream * GoldenGamma)), _counter(0)
+	{
+		//empty
+	}
+
+	RandomStream::~RandomStream()
+	{
+		//empty on purpose
+	}
+
+	unsigned long long RandomStream::next()
+	{
+		return mix(_key + (++_counter) * GoldenGamma);
+	}
+
+	size_t RandomStream::nextIndex(size_t bound)
+	{
+		return static_cast<size_t>(next() % bound);
+	}
+
+	double RandomStream::nextUnit()
+	{
+		//the top 53 bits, as a fraction
+		return (next() >> 11) * (1.0 / 9007199254740992.0);
+	}
+
+	unsigned long long RandomStream::createSeed()
+	{
+		return mix(static_cast<unsigned long long>(time(nullptr))) ^ static_cast<unsigned long long>(clock());
+	}
+
+	unsigned long long RandomStream::mix(unsigned long long value)
+	{
+		value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+		return value ^ (value >> 31);
+	}
+
+} // namespace hyperbolicity
@@ -0,0 +1,91 @@
+#include "WorkerPool.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace hyperbolicity
+{
+
+	WorkerPool::WorkerPool(unsigned int threadCount) : _task(nullptr), _round(0), _runningCount(0), _isStopping(false)
+	{
+		threadCount = max(1u, threadCount);
+		_errors.resize(threadCount);
+		for (unsigned int i = 0; i < threadCount; ++i)
+		{
+			_threads.push_back(thread([this, i]()
+			{
+				work(i);
+			}));
+		}
+	}
+
+	WorkerPool::~WorkerPool()
+	{
+		{
+			lock_guard<mutex> lock(_mutex);
+			_isStopping = true;
+		}
+		_roundStarted.notify_all();
+		for (auto it = _threads.begin(); it != _threads.end(); ++it)
+		{
+			it->join();
+		}
+	}
+
+	void WorkerPool::run(const task_t& task)
+	{
+		{
+			lock_guard<mutex> lock(_mutex);
+			_task = &task;
+			fill(_errors.begin(), _errors.end(), exception_ptr());
+			_runningCount = static_cast<unsigned int>(_threads.size());
+			++_round;
+		}
+		_roundStarted.notify_all();
+
+		{
+			unique_lock<mutex> lock(_mutex);
+			_roundDone.wait(lock, [this]() { return (0 == _runningCount); });
+			_task = nullptr;
+		}
+
+		for (auto it = _errors.cbegin(); it != _errors.cend(); ++it)
+		{
+			if (*it) rethrow_exception(*it);
+		}
+	}
+
+	unsigned int WorkerPool::threadCount() const
+	{
+		return static_cast<unsigned int>(_threads.size());
+	}
+
+	void WorkerPool::work(unsigned int index)
+	{
+		unsigned long long lastRound = 0;
+		for (;;)
+		{
+			const task_t* task = nullptr;
+			{
+				unique_lock<mutex> lock(_mutex);
+				_roundStarted.wait(lock, [this, lastRound]() { return (_isStopping || (_round != lastRound)); });
+				if (_isStopping) return;
+				lastRound = _round;
+				task = _task;
+			}
+
+			try
+			{
+				(*task)(index);
+			}
+			catch (...)
+			{
+				_errors[index] = current_exception();
+			}
+
+			lock_guard<mutex> lock(_mutex);
+			if (0 == --_runningCount) _roundDone.notify_one();
+		}
+	}
+
+} // namespace hyperbolicity
@@ -54,9 +54,45 @@ bool AlgRunner::isComplete() const
 	return _algorithm->isComplete();
 }
 
-void AlgRunner::initialize(const graph_ptr_t graph, const node_combination_t& initialState /* = hyperbolicity::node_combination_t() */)
+string AlgRunner::getStatistics() const
 {
-	_algorithm->initialize(graph, initialState);
+	return _algorithm->getStatistics();
+}
+
+void AlgRunner::setDeadline(clock_t deadline)
+{
+	_algorithm->setDeadline(deadline);
+}
+
+bool AlgRunner::isStopRequested() const
+{
+	return _algorithm->isStopRequested();
+}
+
+double AlgRunner::getProgress() const
+{
+	return _algorithm->getProgress();
+}
+
+void AlgRunner::setThreadLimit(unsigned int threadLimit)
+{
+	_algorithm->setThreadLimit(threadLimit);
+}
+
+void AlgRunner::setWeightedGraph(const compact_graph_ptr_t& weightedGraph)
+{
+	_algorithm->setWeightedGraph(weightedGraph);
+}
+
+bool AlgRunner::supportsWeightedGraph() const
+{
+	return _algorithm->supportsWeightedGraph();
+}
+
+void AlgRunner::initialize(const graph_ptr_t graph, const node_combination_t& initialState /* = hyperbolicity::node_combination_t() */,
+	const bound_channel_ptr_t& bounds /* = hyperbolicity::bound_channel_ptr_t() */)
+{
+	_algorithm->initialize(graph, initialState, bounds);
 }
 
 string AlgRunner::getName() const
@@ -34,8 +34,10 @@ public:
 	 * @param	graph			The graph to run on.
 	 * @param	initialState	The initial state for the algorithm to start running from (relevant only to some algortihms, others will ignore this parameter).
 	 *							May be left unspecified.
+	 * @param	bounds			Bounds on the graph's delta, shared with the other algorithms running on the graph. May be left unspecified.
 	 */
-	void initialize(const hyperbolicity::graph_ptr_t graph, const hyperbolicity::node_combination_t& initialState = hyperbolicity::node_combination_t());
+	void initialize(const hyperbolicity::graph_ptr_t graph, const hyperbolicity::node_combination_t& initialState = hyperbolicity::node_combination_t(),
+		const hyperbolicity::bound_channel_ptr_t& bounds = hyperbolicity::bound_channel_ptr_t());
 
 	/*
 	 * @brief	Wrapper for running a single step of the algorithm. See IGraphAlg documentation for details.
@@ -47,6 +49,29 @@ public:
 	 */
 	bool isComplete() const;
 
+	/*
+	 * @returns	The algorithm's statistics of the run so far. See IGraphAlg documentation for details.
+	 */
+	std::string getStatistics() const;
+
+	/*
+	 * @brief	Wrappers for the algorithm's cooperative stopping. See IGraphAlg documentation for details.
+	 */
+	void setDeadline(clock_t deadline);
+	bool isStopRequested() const;
+	double getProgress() const;
+
+	/*
+	 * @brief	Wrapper for limiting the algorithm's threads. See IGraphAlg documentation for details.
+	 */
+	void setThreadLimit(unsigned int threadLimit);
+
+	/*
+	 * @brief	Wrappers for running the algorithm on a weighted graph. See IGraphAlg documentation for details.
+	 */
+	void setWeightedGraph(const hyperbolicity::compact_graph_ptr_t& weightedGraph);
+	bool supportsWeightedGraph() const;
+
 	/*
 	 * @returns	The algorithm's name.
 	 */
@@ -8,6 +8,9 @@
 #include <iomanip>
 #include <stdio.h>
 #include <random>
+#include <thread>
+#include <mutex>
+#include <exception>
 #include <boost\filesystem.hpp>
 #include <boost\tokenizer.hpp>
 #include <boost\lexical_cast.hpp>
@@ -20,6 +23,7 @@
 #include "Graph\FurthestNode.h"
 #include "Graph\SpanningTree.h"
 #include "HyperbolicityAlgorithms.h"
+#include "BoundChannel.h"
 
 using namespace std;
 using namespace hyperbolicity;
@@ -33,19 +37,44 @@ typedef boost::tokenizer< boost::char_separator<char> > tokenizer;
 
 struct GraphBreakdown
 {
-	GraphBreakdown(string graphTitle, const graph_collection_t& graphBreakdown) : title(graphTitle), graphs(graphBreakdown) {}
+	GraphBreakdown(string graphTitle, const graph_collection_t& graphBreakdown, bool isAtoms = false) : title(graphTitle), graphs(graphBreakdown), areAtoms(isAtoms), knownDelta(0) {}
 
 	string	title;
 	graph_ptr_collection_t graphs;
+	//true if the graphs are atoms (see GraphAlgorithms::getAtoms()), rather than biconnected components
+	bool areAtoms;
+	//the largest delta of the quads evaluated while loading - those crossing splits and those holding two false twins, which the graphs
+	//no longer have, the isometric cycles through degree-2 chains, and those of the graphs whose delta is known from their structure,
+	//which were dropped (see HyperbolicityAlgorithms::getSplitComponents(), reduceFalseTwins(), getChainCycleDelta() and classify())
+	delta_t knownDelta;
+	node_combination_t knownState;
+	//an upper bound on the delta of each of the graphs (InfiniteDelta if none is known - see HyperbolicityAlgorithms::classify())
+	vector<delta_t> upperBounds;
+	//the chain core of each of the graphs, searched in its place (see runAlgorithmOnCore()) - without a graph if the chain cores are not
+	//searched, or the graph's core is no smaller than it
+	vector<HyperbolicityAlgorithms::WeightedCore> cores;
 };
 
 vector<GraphBreakdown> graphs;
 string outputDir = ".\\";
 bool shouldCalculateUpperBound = true;
 bool shouldProduceRawFiles = true;
+bool shouldDecomposeToAtoms = false;
+bool shouldSplitDecompose = false;
+//run the selected algorithms concurrently on each graph (see raceAlgorithms())
+bool shouldRaceAlgorithms = false;
+//run the algorithms that support weighted graphs on the chain cores of the graphs, which bounds their deltas rather than finding them
+//(see runAlgorithmOnCore())
+bool shouldSearchChainCores = false;
+//split decomposition is not attempted on components whose split search would cost more than this (see
+//HyperbolicityAlgorithms::getSplitComponents() - the search is not linear, it takes O(n * m * minimal degree) time)
+const unsigned long long MaxSplitSearchCost = 1ULL << 31;
 
 const unsigned int SecondsBetweenWriteToRaw = 30;
 
+//guards the console output of algorithms running concurrently
+mutex outputMutex;
+
 //delete functor for shared pointer to an array (AKA shared array)
 template <typename T>
 struct arrayDeleter
@@ -95,13 +124,15 @@ void printMenu()
 	cout << "* 2.  Load graph directory.           *" << endl;
 	cout << "* 3.  Select output directory.        *" << endl;
 	cout << "* 4.  Run an algorithm(s).            *" << endl;
-	cout << "* 5.  Deprecated.                     *" << endl; //Calculate delta on given nodes. *" << endl;
-	cout << "* 6.  Deprecated.                     *" << endl; //Calculate distance b/w 2 nodes. *" << endl;
+	cout << "* 5.  Decompose to atoms is: " << (shouldDecomposeToAtoms ? "ON " : "OFF") << "      *" << endl;
+	cout << "* 6.  Split decomposition is: " << (shouldSplitDecompose ? "ON " : "OFF") << "     *" << endl;
 	cout << "* 7.  Calculate upper bound is: " << (shouldCalculateUpperBound ? "ON " : "OFF") << "   *" << endl;
 	cout << "* 8.  Produce raw result file: " << (shouldProduceRawFiles ? "ON " : "OFF") << "    *" << endl;
 	cout << "* 9.  Split to bicomponents.          *" << endl;
 	cout << "* 10. Convert to Pajek.               *" << endl;
-	cout << "* 11. Exit.                           *" << endl;
+	cout << "* 11. Race algorithms is: " << (shouldRaceAlgorithms ? "ON " : "OFF") << "         *" << endl;
+	cout << "* 12. Search chain cores is: " << (shouldSearchChainCores ? "ON " : "OFF") << "      *" << endl;
+	cout << "* 13. Exit.                           *" << endl;
 	cout << "***************************************" << endl;
 	cout << endl;
 }
@@ -109,8 +140,9 @@ void printMenu()
 void loadGraph(string graphPath, unsigned int type)
 {
 	graph_ptr_t curGraph;
-	if (1 == type)	curGraph = GraphAlgorithms::LoadGraphFromFile(graphPath.c_str());
-	else if (2 == type) curGraph = GraphAlgorithms::LoadGraphFromEdgeListFile(graphPath.c_str(), true);
+	//pendant trees are never part of a biconnected component with a cycle, so they are dropped while loading
+	if (1 == type)	curGraph = GraphAlgorithms::LoadGraphFromFile(graphPath.c_str(), true);
+	else if (2 == type) curGraph = GraphAlgorithms::LoadGraphFromEdgeListFile(graphPath.c_str(), true, true);
 	else throw runtime_error("Invalid graph type entered");
 
 	//if graph path is too long, trim the beginning, and display it
@@ -118,8 +150,8 @@ void loadGraph(string graphPath, unsigned int type)
 	if (graphPath.length() > MaxPathLen) graphPath = "..." + graphPath.substr(graphPath.length()-MaxPathLen);
 	cout << "Graph " << graphPath.c_str() << " loaded successfully!" << endl;
 
-	//display stats before & after pruning trees
-	cout << "Graph has " << curGraph->size() << " nodes and " << (curGraph->edgeCount() / 2) << " edges." << endl;
+	//display stats after pruning trees
+	cout << "Graph has " << curGraph->size() << " nodes and " << (curGraph->edgeCount() / 2) << " edges (after pruning trees)." << endl;
 
 	//calculate biconnected components
 	cout << "Calculating biconnected components..." << endl;
@@ -138,10 +170,153 @@ void loadGraph(string graphPath, unsigned int type)
 		}
 	}
 
-	graphs.push_back(GraphBreakdown(curGraph->getTitle(), subgraphs));
+	cout << subgraphs.size() << " biconnected components larger than " << State::size() << " nodes have been found (out of " << bicon.size() << " found)" << endl;
+
+	//further split each biconnected component into atoms
+	if (shouldDecomposeToAtoms)
+	{
+		cout << "Calculating atoms..." << endl;
+		graph_ptr_collection_t atoms;
+		size_t atomCount = 0;
+		nodeCount = edgeCount = 0;
+		for (graph_ptr_collection_t::const_iterator it = subgraphs.cbegin(); it != subgraphs.cend(); ++it)
+		{
+			graph_ptr_collection_t curAtoms = GraphAlgorithms::getAtoms(*it);
+			atomCount += curAtoms.size();
+			for (graph_ptr_collection_t::const_iterator atomIt = curAtoms.cbegin(); atomIt != curAtoms.cend(); ++atomIt)
+			{
+				if ((*atomIt)->size() >= State::size())
+				{
+					atoms.push_back(*atomIt);
+					nodeCount += (*atomIt)->size();
+					edgeCount += (*atomIt)->edgeCount();
+				}
+			}
+		}
+		subgraphs.swap(atoms);
+		cout << subgraphs.size() << " atoms larger than " << State::size() << " nodes have been found (out of " << atomCount << " found)" << endl;
+	}
+
+	GraphBreakdown breakdown(curGraph->getTitle(), graph_collection_t(), shouldDecomposeToAtoms);
+
+	//split decomposition - quads crossing the splits are evaluated right away
+	if (shouldSplitDecompose)
+	{
+		cout << "Calculating split components..." << endl;
+		graph_ptr_collection_t components;
+		for (graph_ptr_collection_t::const_iterator it = subgraphs.cbegin(); it != subgraphs.cend(); ++it)
+		{
+			DeltaHyperbolicity splitDelta;
+			graph_ptr_collection_t curComponents = HyperbolicityAlgorithms::getSplitComponents(*it, MaxSplitSearchCost, splitDelta);
+			components.insert(components.end(), curComponents.cbegin(), curComponents.cend());
+			if (splitDelta.getDelta() > breakdown.knownDelta)
+			{
+				breakdown.knownDelta = splitDelta.getDelta();
+				breakdown.knownState = splitDelta.getState();
+			}
+		}
+		cout << components.size() << " split components have been found (the quads crossing the splits give a delta of " << breakdown.knownDelta << ")" << endl;
+		subgraphs.swap(components);
+	}
+
+	//contract false twins - quads holding two twins of the same class are evaluated right away
+	cout << "Contracting false twins..." << endl;
+	delta_t twinsDelta = 0;
+	size_t contractedCount = 0;
+	graph_ptr_collection_t reduced;
+	nodeCount = edgeCount = 0;
+	for (graph_ptr_collection_t::const_iterator it = subgraphs.cbegin(); it != subgraphs.cend(); ++it)
+	{
+		size_t sizeBefore = (*it)->size();
+		DeltaHyperbolicity curDelta = HyperbolicityAlgorithms::reduceFalseTwins(*it);
+		contractedCount += sizeBefore - (*it)->size();
+		if (curDelta.getDelta() > twinsDelta) twinsDelta = curDelta.getDelta();
+		if (curDelta.getDelta() > breakdown.knownDelta)
+		{
+			breakdown.knownDelta = curDelta.getDelta();
+			breakdown.knownState = curDelta.getState();
+		}
+
+		if ((*it)->size() >= State::size())
+		{
+			reduced.push_back(*it);
+		}
+	}
+	cout << contractedCount << " false twins have been contracted (their quads give a delta of " << twinsDelta << ")" << endl;
+
+	//the shortest cycle through every degree-2 chain is isometric, so its delta is known right away (the sub-graphs themselves are
+	//searched as they are)
+	cout << "Checking the cycles of degree-2 chains..." << endl;
+	delta_t chainsDelta = 0;
+	size_t chainCount = 0;
+	for (graph_ptr_collection_t::const_iterator it = reduced.cbegin(); it != reduced.cend(); ++it)
+	{
+		size_t curChainCount = 0;
+		DeltaHyperbolicity curDelta = HyperbolicityAlgorithms::getChainCycleDelta(*it, curChainCount);
+		chainCount += curChainCount;
+		if (curDelta.getDelta() > chainsDelta) chainsDelta = curDelta.getDelta();
+		if (curDelta.getDelta() > breakdown.knownDelta)
+		{
+			breakdown.knownDelta = curDelta.getDelta();
+			breakdown.knownState = curDelta.getState();
+		}
+	}
+	cout << chainCount << " degree-2 chains have been found (their cycles give a delta of " << chainsDelta << ")" << endl;
+
+	//graphs whose delta is known from their structure are not searched at all
+	cout << "Classifying sub-graphs..." << endl;
+	size_t classCounts[4] = {0, 0, 0, 0};
+	size_t coreCount = 0;
+	size_t coreNodeCount = 0;
+	for (graph_ptr_collection_t::const_iterator it = reduced.cbegin(); it != reduced.cend(); ++it)
+	{
+		DeltaHyperbolicity lowerBound;
+		delta_t upperBound;
+		HyperbolicityAlgorithms::GraphClass graphClass = HyperbolicityAlgorithms::classify(*it, lowerBound, upperBound);
+		++classCounts[graphClass];
+		if (lowerBound.getDelta() > breakdown.knownDelta)
+		{
+			breakdown.knownDelta = lowerBound.getDelta();
+			breakdown.knownState = lowerBound.getState();
+		}
+
+		if ( (HyperbolicityAlgorithms::CompleteGraph != graphClass) && (HyperbolicityAlgorithms::CactusGraph != graphClass) )
+		{
+			breakdown.graphs.push_back(*it);
+			breakdown.upperBounds.push_back(upperBound);
+			nodeCount += (*it)->size();
+			edgeCount += (*it)->edgeCount();
+
+			//a core no smaller than the graph saves nothing, and one without a quad of nodes cannot be searched
+			HyperbolicityAlgorithms::WeightedCore core = HyperbolicityAlgorithms::WeightedCore();
+			if (shouldSearchChainCores)
+			{
+				core = HyperbolicityAlgorithms::getChainCore(*it);
+				if ( (core.graph->size() < (*it)->size()) && (core.graph->size() >= State::size()) )
+				{
+					++coreCount;
+					coreNodeCount += core.graph->size();
+				}
+				else
+				{
+					core = HyperbolicityAlgorithms::WeightedCore();
+				}
+			}
+			breakdown.cores.push_back(core);
+		}
+	}
+	cout << classCounts[HyperbolicityAlgorithms::CompleteGraph] << " complete graphs and " << classCounts[HyperbolicityAlgorithms::CactusGraph] <<
+		" cacti have been dropped, " << classCounts[HyperbolicityAlgorithms::ChordalGraph] << " chordal graphs are bounded by 1 (known delta is now " <<
+		breakdown.knownDelta << ")" << endl;
+
+	graphs.push_back(breakdown);
 
-	cout << subgraphs.size() << " biconnected components larger than " << State::size() << " nodes have been added (out of " << bicon.size() << " found)" << endl;
+	cout << breakdown.graphs.size() << " sub-graphs have been added" << endl;
 	cout << "Total number of nodes is " << nodeCount << " and total number of edges is " << edgeCount/2 << endl;
+	if (shouldSearchChainCores)
+	{
+		cout << coreCount << " sub-graphs have a smaller chain core to be searched in their place, of " << coreNodeCount << " nodes in total" << endl;
+	}
 }
 
 void loadSingleGraph()
@@ -427,9 +602,317 @@ delta_t calculateUpperBound(graph_ptr_t g)
 	return (b1 < b2 ? b1 : b2);
 }
 
+void printMessage(const string& message)
+{
+	//algorithms racing on a graph report from their own threads
+	lock_guard<mutex> lock(outputMutex);
+	cout << message << endl;
+}
+
+/*
+ * @brief	Runs a single algorithm on a subgraph, writing its raw & summary data, until it completes, a limit is reached, or the bounds are
+ *			cancelled (see BoundChannel::isCancelled() - e.g. they are settled). The time limit is a deadline the algorithm checks between
+ *			chunks of its initialization and steps (see IGraphAlg::isStopRequested()), not only between steps.
+ * @param	rawFile		The algorithm's raw data file (null if raw files are not produced).
+ * @param	timeToMax	Will be set to the number of seconds from the algorithm's initialization to its best delta.
+ * @returns	The best delta the algorithm found, and its state (not initialized if no step produced a state - an exact algorithm's step
+ *			returns no state once nothing beats the lower bound).
+ */
+DeltaHyperbolicity runAlgorithm(AlgRunner& alg, const graph_ptr_t curGraph, const node_combination_t& initialState, const bound_channel_ptr_t& bounds,
+								file_ptr_t rawFile, file_ptr_t sumFile, unsigned int runsPerGraph, unsigned int timeLimit, bool runBf, delta_t upperBound,
+								double& timeToMax)
+{
+	//initialize statistical variables
+	const double InfiniteTime = -1;
+	node_combination_t maxDeltaState;
+	delta_t maxDelta = 0;
+	delta_t minDelta = InfiniteDelta;
+	delta_t deltaSum = 0;
+	unordered_map<delta_t, unsigned int> deltaDistributions;
+	double maxTime = 0;
+	double minTime = InfiniteTime;
+	long double timeSum = 0;
+	double timeSquareSum = 0;
+	uint64_t numOfIterationsToMax = 0;
+	double lastRawWriteTime = (-static_cast<int>(SecondsBetweenWriteToRaw)-1) * CLOCKS_PER_SEC;
+	uint64_t runCount = 0;
+	timeToMax = 0;
+
+	try
+	{
+		//nothing to search for if the bounds have already met (e.g. a chordal graph, once a delta of 1 is known)
+		clock_t initialAlgTime = clock();
+		const bool shouldInitialize = !bounds->isCancelled();
+		if (shouldInitialize)
+		{
+			alg.setDeadline( (0 == timeLimit) ? IGraphAlg::NoDeadline : initialAlgTime + static_cast<clock_t>(timeLimit) * CLOCKS_PER_SEC );
+			alg.initialize(curGraph, initialState, bounds);
+			clock_t initFinishTime = clock();
+			stringstream message;
+			message << alg.getName() << " finished initialization process in " << initFinishTime - initialAlgTime << " milliseconds";
+			printMessage(message.str());
+		}
+
+		for (runCount = 0; shouldInitialize && !alg.isStopRequested() && !alg.isComplete() && (runCount < runsPerGraph || 0 == runsPerGraph); ++runCount)
+		{
+			//run another step, get best delta found so far
+			clock_t t1 = clock();
+			DeltaHyperbolicity delta = alg.step();
+			double timeElapsed = (clock() - t1) / static_cast<double>(CLOCKS_PER_SEC);
+
+			//if max delta for current algorithm was improved - update it (a step that found nothing has no state to keep)
+			const bool hasState = delta.getState().isInitialized();
+			if ( hasState && (maxDelta < delta.getDelta() || !maxDeltaState.isInitialized()) ) 
+			{
+				maxDelta = delta.getDelta();
+				maxDeltaState = delta.getState();
+				numOfIterationsToMax = runCount+1;
+				timeToMax = (clock() - initialAlgTime) / static_cast<double>(CLOCKS_PER_SEC);
+			}
+
+			//update summarized info
+			if ( (minDelta == InfiniteDelta) || (minDelta > delta.getDelta()) ) minDelta = delta.getDelta();
+			deltaSum += delta.getDelta();
+			if (deltaDistributions.find(delta.getDelta()) != deltaDistributions.end())
+			{
+				++deltaDistributions[delta.getDelta()];
+			}
+			else
+			{
+				deltaDistributions[delta.getDelta()] = 1;
+			}
+
+			if (maxTime < timeElapsed) maxTime = timeElapsed;
+			if ( (minTime == InfiniteTime) || (minTime > timeElapsed) ) minTime = timeElapsed;
+			timeSum += timeElapsed;
+			timeSquareSum += timeElapsed * timeElapsed;
+
+			//write results to raw data file as long as at least 30 seconds have passed since last write time, or if this is the last write for this graph
+			stringstream rawData;
+			rawData << curGraph->getTitle() << ", " << delta.getDelta() << ", " << timeElapsed << ", {" << (hasState ? delta.printNodes() : string()) << "}\n";
+			if (shouldProduceRawFiles) 
+			{
+				writeStringToFile(rawFile, rawData.str());
+				double now = clock();
+				if ( ( (now - lastRawWriteTime) / static_cast<double>(CLOCKS_PER_SEC) > SecondsBetweenWriteToRaw) || 
+					!(runCount+1 < runsPerGraph || (0 == runsPerGraph && !alg.isComplete() ) ) )
+				{
+					fflush(rawFile.get());
+
+					lastRawWriteTime = now;
+				}
+			}
+		}
+
+		if (bounds->isSettled())
+		{
+			stringstream message;
+			message << alg.getName() << ": lower bound " << bounds->currentLowerBound() << " has reached the upper bound, nothing left to improve";
+			printMessage(message.str());
+		}
+		else if (shouldInitialize && alg.isStopRequested() && !bounds->isCancelled())
+		{
+			//a stop request that is not a cancellation is the deadline
+			stringstream message;
+			message << alg.getName() << " reached the time limit " << (0 == runCount ? "while initializing" : "in a step") << ", "
+					<< static_cast<int>(100 * alg.getProgress()) << "% of which was done";
+			printMessage(message.str());
+		}
+
+		string statistics = (shouldInitialize ? alg.getStatistics() : string());
+		if (!statistics.empty()) printMessage(alg.getName() + " statistics: " + statistics);
+
+		//write summary to summary-file
+		stringstream sumData;
+		sumData << runCount << ", ";
+		if (0 == runCount)
+		{
+			sumData << "n/a, n/a, n/a, n/a, {}, n/a, n/a, n/a, n/a, n/a, n/a, " << upperBound << "\n";
+		}
+		else
+		{
+			sumData << numOfIterationsToMax << ", " << maxDelta << ", " << deltaSum / static_cast<double>(runCount) << ", " << minDelta << ", ";
+			for (unordered_map<delta_t, unsigned int>::const_iterator it = deltaDistributions.cbegin(); it != deltaDistributions.cend(); ++it)
+			{
+				sumData << "{" << it->first << ":" << it->second << "} ";
+			}
+			sumData << ", {" << (maxDeltaState.isInitialized() ? maxDeltaState.printNodes() : string()) << "}, ";
+			double timeAvg = timeSum / static_cast<long double>(runCount);
+			double timeVar = (timeSquareSum - timeAvg*timeSum) / static_cast<double>(runCount);
+			sumData << minTime << ", " << timeAvg << ", " << maxTime << ", " << timeVar << ", " << runBf << ", " << upperBound << "\n";
+		}
+
+		writeStringToFile(sumFile, sumData.str());
+		fflush(sumFile.get());
+	}
+	catch (const std::exception& ex)
+	{
+		printMessage(alg.getName() + " threw an exception: " + ex.what());
+		stringstream exceptionMessage;
+		exceptionMessage << ", " << "Exception: " << ex.what() << "\n";
+		if (shouldProduceRawFiles)
+		{
+			stringstream rawMessage;
+			rawMessage << curGraph->getTitle() << exceptionMessage.str();
+			writeStringToFile(rawFile, rawMessage.str());
+			fflush(rawFile.get());
+		}
+
+		writeStringToFile(sumFile, exceptionMessage.str());
+		fflush(sumFile.get());
+
+		throw;
+	}
+	catch (...)
+	{
+		printMessage(alg.getName() + " threw an unknown exception!");
+		stringstream exceptionMessage;
+		exceptionMessage << ", " << "Unknown Exception!\n";
+		if (shouldProduceRawFiles)
+		{
+			stringstream rawMessage;
+			rawMessage << curGraph->getTitle() << exceptionMessage.str();
+			writeStringToFile(rawFile, rawMessage.str());
+			fflush(rawFile.get());
+		}
+
+		writeStringToFile(sumFile, exceptionMessage.str());
+		fflush(sumFile.get());
+
+		throw;
+	}
+
+	return (maxDeltaState.isInitialized() ? DeltaHyperbolicity(maxDelta, maxDeltaState) : DeltaHyperbolicity());
+}
+
+/*
+ * @brief	Runs a single algorithm on a subgraph (see runAlgorithm()) - or on the subgraph's chain core instead, if it has one and the algorithm
+ *			supports weighted graphs (see HyperbolicityAlgorithms::getChainCore()). The core's delta is at most the subgraph's, so the core
+ *			has bounds of its own, seeded with the subgraph's (only a 4-tuple beating the subgraph's lower bound matters). Every delta found
+ *			on the core is a delta of the subgraph as well, and the core's upper bound plus 4 times its chains' reach bounds the subgraph's.
+ *			The core's bounds are only seeded once, so a search of the core is not stopped by what others find on the subgraph meanwhile.
+ * @param	core	The subgraph's chain core, without a graph if it has none.
+ * @returns	The best delta found, and its state in the subgraph's nodes (see runAlgorithm()).
+ */
+DeltaHyperbolicity runAlgorithmOnCore(AlgRunner& alg, const graph_ptr_t curGraph, const HyperbolicityAlgorithms::WeightedCore& core,
+									  const node_combination_t& initialState, const bound_channel_ptr_t& bounds, file_ptr_t rawFile, file_ptr_t sumFile,
+									  unsigned int runsPerGraph, unsigned int timeLimit, bool runBf, delta_t upperBound, double& timeToMax)
+{
+	if ( (nullptr == core.graph.get()) || !alg.supportsWeightedGraph() )
+	{
+		return runAlgorithm(alg, curGraph, initialState, bounds, rawFile, sumFile, runsPerGraph, timeLimit, runBf, upperBound, timeToMax);
+	}
+
+	bound_channel_ptr_t coreBounds(new BoundChannel());
+	coreBounds->publishLowerBound(bounds->currentLowerBound());
+	coreBounds->publishUpperBound(bounds->currentUpperBound());
+	alg.setWeightedGraph(core.weights);
+	DeltaHyperbolicity result;
+	try
+	{
+		//the initial state is in the subgraph's nodes, which the core does not share
+		graph_ptr_t coreGraph(new Graph(*core.graph));
+		result = runAlgorithm(alg, coreGraph, node_combination_t(), coreBounds, rawFile, sumFile, runsPerGraph, timeLimit, runBf, upperBound, timeToMax);
+	}
+	catch (...)
+	{
+		alg.setWeightedGraph(compact_graph_ptr_t());
+		throw;
+	}
+	alg.setWeightedGraph(compact_graph_ptr_t());
+
+	bounds->publishLowerBound(coreBounds->currentLowerBound());
+	const delta_t coreUpperBound = coreBounds->currentUpperBound();
+	if (InfiniteDelta != coreUpperBound) bounds->publishUpperBound(coreUpperBound + 4 * core.chainReach);
+	stringstream message;
+	message << alg.getName() << " searched the chain core of " << curGraph->getTitle() << " (" << core.graph->size() << " of its " << curGraph->size()
+			<< " nodes) - its delta is at least " << bounds->currentLowerBound();
+	if (InfiniteDelta != bounds->currentUpperBound()) message << " and at most " << bounds->currentUpperBound();
+	printMessage(message.str());
+
+	if (!result.getState().isInitialized()) return result;
+	const node_combination_t& coreState = result.getState();
+	return DeltaHyperbolicity(result.getDelta(), node_combination_t(curGraph->getNode(core.nodes[coreState[0]->getIndex()]),
+		curGraph->getNode(core.nodes[coreState[1]->getIndex()]), curGraph->getNode(core.nodes[coreState[2]->getIndex()]),
+		curGraph->getNode(core.nodes[coreState[3]->getIndex()])));
+}
+
+/*
+ * @brief	Races the given algorithms on a subgraph - each one runs on its own thread and its own copy of the graph (so node marks are not
+ *			shared), and they all share the bounds, so each one prunes by the best delta any of them has found. The race ends once they
+ *			have all stopped: an exact algorithm that completes settles the bounds, which stops the rest (as does the lower bound reaching
+ *			an upper bound, or a failure of any of them, which cancels the bounds). Those that support weighted graphs race on the subgraph's
+ *			chain core instead, if it has one (see runAlgorithmOnCore()).
+ *			The processor cores are split between the algorithms (see IGraphAlg::setThreadLimit()), so that together they do not run more
+ *			threads than there are cores - each one has all of them again once the race is over.
+ * @returns	The best delta found, and its state (not initialized if no algorithm ran a step).
+ * @throws	The first exception thrown by an algorithm, once all of them have stopped.
+ */
+DeltaHyperbolicity raceAlgorithms(const alg_runner_collection_t& algorithms, const graph_ptr_t curGraph, const HyperbolicityAlgorithms::WeightedCore& core,
+								  const node_combination_t& initialState, const bound_channel_ptr_t& bounds, const vector<file_ptr_t>& rawFiles,
+								  const vector<file_ptr_t>& sumFiles, unsigned int runsPerGraph, unsigned int timeLimit, bool runBf, delta_t upperBound)
+{
+	vector<DeltaHyperbolicity> results(algorithms.size());
+	vector<double> timesToMax(algorithms.size(), 0);
+	vector<exception_ptr> errors(algorithms.size());
+	vector<thread> threads;
+	const unsigned int coreCount = max(1u, thread::hardware_concurrency());
+	for (size_t i = 0; i < algorithms.size(); ++i)
+	{
+		//the first coreCount % algorithms.size() algorithms get a core more than the rest (and each gets at least one)
+		const unsigned int threadLimit = max(1u, static_cast<unsigned int>(coreCount / algorithms.size() + (i < coreCount % algorithms.size() ? 1 : 0)));
+		algorithms[i]->setThreadLimit(threadLimit);
+		threads.push_back(thread([&, i]()
+		{
+			try
+			{
+				graph_ptr_t ownGraph(new Graph(*curGraph));
+				results[i] = runAlgorithmOnCore(*algorithms[i], ownGraph, core, initialState, bounds, (shouldProduceRawFiles ? rawFiles[i] : file_ptr_t()),
+					sumFiles[i], runsPerGraph, timeLimit, runBf, upperBound, timesToMax[i]);
+			}
+			catch (...)
+			{
+				//the others are stopped, and the error is rethrown once they are done
+				errors[i] = current_exception();
+				bounds->cancel();
+			}
+		}));
+	}
+	for (auto it = threads.begin(); it != threads.end(); ++it)
+	{
+		it->join();
+	}
+	for (auto it = algorithms.cbegin(); it != algorithms.cend(); ++it)
+	{
+		(*it)->setThreadLimit(IGraphAlg::NoThreadLimit);
+	}
+	for (auto it = errors.cbegin(); it != errors.cend(); ++it)
+	{
+		if (*it) rethrow_exception(*it);
+	}
+
+	//the winner found the best delta first
+	size_t winner = results.size();
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		if (!results[i].getState().isInitialized()) continue;
+		if ( (results.size() == winner) || (results[i].getDelta() > results[winner].getDelta()) ||
+			( (results[i].getDelta() == results[winner].getDelta()) && (timesToMax[i] < timesToMax[winner]) ) )
+		{
+			winner = i;
+		}
+	}
+	if (results.size() == winner) return DeltaHyperbolicity();
+
+	stringstream message;
+	message << "Race won by " << algorithms[winner]->getName() << " with a delta of " << results[winner].getDelta() << ", found after " << timesToMax[winner] << " seconds";
+	printMessage(message.str());
+	return DeltaHyperbolicity(results[winner].getDelta(), results[winner].getState());
+}
+
 void runGivenAlgorithms(alg_runner_collection_t algorithms, const vector<file_ptr_t>& rawFiles, const vector<file_ptr_t>& sumFiles, file_ptr_t generalSumFile, unsigned int runsPerGraph, unsigned int timeLimit)
 {
-	const unsigned int BruteForceThreshold = 100;
+	const unsigned int BruteForceThreshold = 400;
 	alg_runner_collection_t* algsToRun = &algorithms;
 	
 	//try to load BruteForce algorithm to use on graph below size threshold
@@ -460,6 +943,8 @@ void runGivenAlgorithms(alg_runner_collection_t algorithms, const vector<file_pt
 			clock_t initialTime = clock();
 			DeltaHyperbolicity bestDH;
 			delta_t maxUpperBound = 0;
+			//the largest upper bound known on a subgraph's delta once it was searched (InfiniteDelta if one of them has none)
+			delta_t maxSearchedUpperBound = 0;
 			bool allRunsWithBf = true;
 
 			for (graph_collection_t::const_iterator subgraphIt = graph.cbegin(); subgraphIt != graph.cend(); ++subgraphIt)
@@ -471,6 +956,12 @@ void runGivenAlgorithms(alg_runner_collection_t algorithms, const vector<file_pt
 					writeStringToFile(*it, curGraph->getTitle() + ", ");
 				}
 
+				//bounds shared by all algorithms running on the subgraph - a result only matters if it beats the best delta found so far
+				bound_channel_ptr_t bounds(new BoundChannel());
+				bounds->publishLowerBound(bestDH.getDelta());
+				bounds->publishLowerBound(graphIt->knownDelta);
+				bounds->publishUpperBound(graphIt->upperBounds[subgraphIt - graph.cbegin()]);
+
 				unsigned int algIndex = 0;
 				algsToRun = &algorithms;
 				bool runBf = curGraph->size() < BruteForceThreshold;
@@ -482,164 +973,66 @@ void runGivenAlgorithms(alg_runner_collection_t algorithms, const vector<file_pt
 				{
 					allRunsWithBf = false;
 				}
+
+				//calculate upper bound for subgraph
+				delta_t upperBound = 0;
+				if (shouldCalculateUpperBound)
+				{
+					upperBound = calculateUpperBound(curGraph);
+					if (upperBound > maxUpperBound) maxUpperBound = upperBound;
+					bounds->publishUpperBound(upperBound);
+				}
+
+				//the algorithms either race on the subgraph, or run one after the other (each starting from the best state found before it).
+				//brute force is exact on the subgraph itself, so it is not run on the chain core
+				const HyperbolicityAlgorithms::WeightedCore core = ( (algsToRun == &bfAlg) ? HyperbolicityAlgorithms::WeightedCore() :
+																	 graphIt->cores[subgraphIt - graph.cbegin()] );
+				const bool shouldRace = shouldRaceAlgorithms && (algsToRun->size() > 1);
 				for (alg_runner_collection_t::const_iterator algIt = algsToRun->cbegin(); algIt != algsToRun->cend(); ++algIt, ++algIndex)
 				{
-					//initialize statistical variables
-					const double InfiniteTime = -1;
-					node_combination_t maxDeltaState;
-					delta_t maxDelta = 0;
-					delta_t minDelta = InfiniteDelta;
-					delta_t deltaSum = 0;
-					unordered_map<delta_t, unsigned int> deltaDistributions;
-					double maxTime = 0;
-					double minTime = InfiniteTime;
-					long double timeSum = 0;
-					double timeSquareSum = 0;
-					uint64_t numOfIterationsToMax = 0;
-					double lastRawWriteTime = (-static_cast<int>(SecondsBetweenWriteToRaw)-1) * CLOCKS_PER_SEC;
-					uint64_t runCount = 0;
-
-					//calculate upper bound for subgraph
-					delta_t upperBound = 0;
-					if (shouldCalculateUpperBound)
-					{
-						upperBound = calculateUpperBound(curGraph);
-						if (upperBound > maxUpperBound) maxUpperBound = upperBound;
-					}
+					double timeToMax = 0;
+					DeltaHyperbolicity result = ( shouldRace ?
+						raceAlgorithms(*algsToRun, curGraph, core, bestDH.getState(), bounds, rawFiles, sumFiles, runsPerGraph, timeLimit, runBf, upperBound) :
+						runAlgorithmOnCore(**algIt, curGraph, core, bestDH.getState(), bounds, (shouldProduceRawFiles ? rawFiles[algIndex] : file_ptr_t()),
+										   sumFiles[algIndex], runsPerGraph, timeLimit, runBf, upperBound, timeToMax) );
 
-					try
+					if ( result.getState().isInitialized() && (!bestDH.getState().isInitialized() || (bestDH.getDelta() < result.getDelta())) )
 					{
-						clock_t initialAlgTime = clock();
-						(*algIt)->initialize(curGraph, bestDH.getState());
-						clock_t initFinishTime = clock();
-						cout << "Algorithm finished initialization process in " << initFinishTime - initialAlgTime << " milliseconds" << endl;
-
-						for (runCount = 0; !(*algIt)->isComplete() && ( (clock()-initialAlgTime) / static_cast<double>(CLOCKS_PER_SEC) < timeLimit || 0 == timeLimit) && (runCount < runsPerGraph || 0 == runsPerGraph); ++runCount)
-						{
-							//run another step, get best delta found so far
-							clock_t t1 = clock();
-							DeltaHyperbolicity delta = (*algIt)->step();
-							double timeElapsed = (clock() - t1) / static_cast<double>(CLOCKS_PER_SEC);
-
-							//if the best delta is still uninitialized - initialize it now with the current state
-							if (!bestDH.getState().isInitialized())
-							{
-								bestDH.set(maxDelta, delta.getState());
-							}
-
-							//if max delta for current algorithm was improved - update it
-							if ( maxDelta < delta.getDelta() || !maxDeltaState.isInitialized() ) 
-							{
-								maxDelta = delta.getDelta();
-								maxDeltaState = delta.getState();
-								numOfIterationsToMax = runCount+1;
-
-								//check if best delta was improved by this new finding
-								if (bestDH.getDelta() < maxDelta) 
-								{
-									bestDH.set(maxDelta, delta.getState());
-								}
-							}
-
-							//update summarized info
-							if ( (minDelta == InfiniteDelta) || (minDelta > delta.getDelta()) ) minDelta = delta.getDelta();
-							deltaSum += delta.getDelta();
-							if (deltaDistributions.find(delta.getDelta()) != deltaDistributions.end())
-							{
-								++deltaDistributions[delta.getDelta()];
-							}
-							else
-							{
-								deltaDistributions[delta.getDelta()] = 1;
-							}
-
-							if (maxTime < timeElapsed) maxTime = timeElapsed;
-							if ( (minTime == InfiniteTime) || (minTime > timeElapsed) ) minTime = timeElapsed;
-							timeSum += timeElapsed;
-							timeSquareSum += timeElapsed * timeElapsed;
-
-							//write results to raw data file as long as at least 30 seconds have passed since last write time, or if this is the last write for this graph
-							stringstream rawData;
-							rawData << curGraph->getTitle() << ", " << delta.getDelta() << ", " << timeElapsed << ", {" << delta.printNodes() << "}\n";
-							if (shouldProduceRawFiles) 
-							{
-								writeStringToFile(rawFiles[algIndex], rawData.str());
-								double now = clock();
-								if ( ( (now - lastRawWriteTime) / static_cast<double>(CLOCKS_PER_SEC) > SecondsBetweenWriteToRaw) || 
-									!(runCount+1 < runsPerGraph || (0 == runsPerGraph && !(*algIt)->isComplete() ) ) )
-								{
-									fflush(rawFiles[algIndex].get());
-
-									lastRawWriteTime = now;
-								}
-							}
-						}
-
-						//write summary to summary-file
-						stringstream sumData;
-						sumData << runCount << ", ";
-						if (0 == runCount)
-						{
-							sumData << "n/a, n/a, n/a, n/a, {}, n/a, n/a, n/a, n/a, n/a, n/a, " << upperBound << "\n";
-						}
-						else
-						{
-							sumData << numOfIterationsToMax << ", " << maxDelta << ", " << deltaSum / static_cast<double>(runCount) << ", " << minDelta << ", ";
-							for (unordered_map<delta_t, unsigned int>::const_iterator it = deltaDistributions.cbegin(); it != deltaDistributions.cend(); ++it)
-							{
-								sumData << "{" << it->first << ":" << it->second << "} ";
-							}
-							if (!maxDeltaState.isInitialized()) throw std::exception("Max delta state should be initialized by this point");
-							sumData << ", {" << maxDeltaState.printNodes() << "}, ";
-							double timeAvg = timeSum / static_cast<long double>(runCount);
-							double timeVar = (timeSquareSum - timeAvg*timeSum) / static_cast<double>(runCount);
-							sumData << minTime << ", " << timeAvg << ", " << maxTime << ", " << timeVar << ", " << runBf << ", " << upperBound << "\n";
-						}
-
-						writeStringToFile(sumFiles[algIndex], sumData.str());
-						fflush(sumFiles[algIndex].get());
+						bestDH.set(result.getDelta(), result.getState());
 					}
-					catch (const std::exception& ex)
-					{
-						cout << "Algorithm threw an exception: " << ex.what() << endl;
-						stringstream exceptionMessage;
-						exceptionMessage << ", " << "Exception: " << ex.what() << "\n";
-						if (shouldProduceRawFiles)
-						{
-							stringstream rawMessage;
-							rawMessage << curGraph->getTitle() << exceptionMessage.str();
-							writeStringToFile(rawFiles[algIndex], rawMessage.str());
-							fflush(sumFiles[algIndex].get());
-						}
+					if (shouldRace) break;
+				}
 
-						writeStringToFile(sumFiles[algIndex], exceptionMessage.str());
-						fflush(sumFiles[algIndex].get());
+				//settled bounds (e.g. an exact algorithm completed) give the subgraph's delta
+				const delta_t searchedUpperBound = bounds->currentUpperBound();
+				if ( (InfiniteDelta == searchedUpperBound) || (InfiniteDelta == maxSearchedUpperBound) )
+				{
+					maxSearchedUpperBound = InfiniteDelta;
+				}
+				else if (searchedUpperBound > maxSearchedUpperBound)
+				{
+					maxSearchedUpperBound = searchedUpperBound;
+				}
+			}
 
-						throw;
-					}
-					catch (...)
-					{
-						cout << "Algorithm threw an unknown exception!" << endl;
-						stringstream exceptionMessage;
-						exceptionMessage << ", " << "Unknown Exception!\n";
-						if (shouldProduceRawFiles)
-						{
-							stringstream rawMessage;
-							rawMessage << curGraph->getTitle() << exceptionMessage.str();
-							writeStringToFile(rawFiles[algIndex], rawMessage.str());
-							fflush(sumFiles[algIndex].get());
-						}
+			double timeElapsed = (clock() - initialTime) / static_cast<double>(CLOCKS_PER_SEC);
 
-						writeStringToFile(sumFiles[algIndex], exceptionMessage.str());
-						fflush(sumFiles[algIndex].get());
+			//quads crossing splits and holding contracted twins were evaluated when the graph was loaded
+			if (graphIt->knownDelta > bestDH.getDelta()) bestDH.set(graphIt->knownDelta, graphIt->knownState);
 
-						throw;
-					}
+			//gluing atoms along clique separators may add up to 1 to the delta, but no more - which only bounds the graph's delta if the
+			//atoms' deltas are bounded (by their bounds once searched, which are the deltas themselves if they were found exactly)
+			if (graphIt->areAtoms)
+			{
+				cout << "Note - the delta of " << graphIt->title << " is at least " << bestDH.getDelta() << " (the maximum found over its atoms)";
+				if (InfiniteDelta != maxSearchedUpperBound)
+				{
+					cout << ", and at most " << (maxSearchedUpperBound + 1) << " (the maximum upper bound over its atoms, plus 1)";
 				}
+				cout << endl;
+				maxUpperBound += 1;
 			}
 
-			double timeElapsed = (clock() - initialTime) / static_cast<double>(CLOCKS_PER_SEC);
-
 			generalSumData << bestDH.getDelta() << ", " << timeElapsed << ", " << allRunsWithBf <<  ", ";
 
 			if (shouldCalculateUpperBound)
@@ -826,8 +1219,9 @@ cout << origin->getIndex() << "\tto\t" << distanceIt->first << ":\t" << distance
 void printUsage(char* imageName)
 {
 	cout << "Usage (ui):\n\t" << imageName << endl;
-	cout << "Usage (single execution):\n\t" << imageName << " -i input-file -o output-dir -n num-of-executions -t time-limit [-R] -a algorithm1 algorithm2 ..." << endl;
+	cout << "Usage (single execution):\n\t" << imageName << " -i input-file -o output-dir -n num-of-executions -t time-limit [-R] [-P] -a algorithm1 algorithm2 ..." << endl;
 	cout << "-R: do NOT produce raw files" << endl;
+	cout << "-P: race the algorithms - run them concurrently on each graph, until an exact one completes or the bounds meet" << endl;
 }
 
 void commandLineExecution(int argc, char** argv)
@@ -838,28 +1232,43 @@ void commandLineExecution(int argc, char** argv)
 		return;
 	}
 
-	if (_stricmp(argv[1], "-i") != 0 || _stricmp(argv[3], "-o") != 0 || _stricmp(argv[5], "-n") != 0 || _stricmp(argv[7], "-t") != 0 || 
-		( _stricmp(argv[9], "-a") != 0 && (_stricmp(argv[9], "-R") != 0 || _stricmp(argv[10], "-a") != 0) ) )
+	if (_stricmp(argv[1], "-i") != 0 || _stricmp(argv[3], "-o") != 0 || _stricmp(argv[5], "-n") != 0 || _stricmp(argv[7], "-t") != 0)
 	{
 		printUsage(argv[0]);
 		return;
 	}
 
-	char* input = argv[2];
-	string myOutputDir(argv[4]);
-	unsigned int n = atoi(argv[6]);
-	unsigned int timeLimit = atoi(argv[8]);
-
-	int algCmdIndex = 10;
-	if (_stricmp(argv[9], "-R") == 0)
+	//optional flags come before the algorithms
+	shouldProduceRawFiles = true;
+	shouldRaceAlgorithms = false;
+	int algCmdIndex = 9;
+	for (; (algCmdIndex < argc) && (_stricmp(argv[algCmdIndex], "-a") != 0); ++algCmdIndex)
 	{
-		shouldProduceRawFiles = false;
-		++algCmdIndex;
+		if (_stricmp(argv[algCmdIndex], "-R") == 0)
+		{
+			shouldProduceRawFiles = false;
+		}
+		else if (_stricmp(argv[algCmdIndex], "-P") == 0)
+		{
+			shouldRaceAlgorithms = true;
+		}
+		else
+		{
+			printUsage(argv[0]);
+			return;
+		}
 	}
-	else
+	if (algCmdIndex >= argc)
 	{
-		shouldProduceRawFiles = true;
+		printUsage(argv[0]);
+		return;
 	}
+	++algCmdIndex;
+
+	char* input = argv[2];
+	string myOutputDir(argv[4]);
+	unsigned int n = atoi(argv[6]);
+	unsigned int timeLimit = atoi(argv[8]);
 
 	vector<string> algs;
 	for (; algCmdIndex < argc; ++algCmdIndex)
@@ -943,7 +1352,7 @@ void uiExecution()
 		stringstream(input) >> choice;
 
 		//start loop, loading algorithms requested by the user (unless "exit" is typed)
-		while (11 != choice)
+		while (13 != choice)
 		{
 			cout << endl;
 			switch (choice)
@@ -965,11 +1374,11 @@ void uiExecution()
 				break;
 
 			case 5:
-				//calculateDelta();
+				shouldDecomposeToAtoms = !shouldDecomposeToAtoms;
 				break;
 
 			case 6:
-				//calculateDistance();
+				shouldSplitDecompose = !shouldSplitDecompose;
 				break;
 
 			case 7:
@@ -1028,6 +1437,14 @@ void uiExecution()
 					}
 				}
 				break;
+
+			case 11:
+				shouldRaceAlgorithms = !shouldRaceAlgorithms;
+				break;
+
+			case 12:
+				shouldSearchChainCores = !shouldSearchChainCores;
+				break;
 			}
 			cout << endl;
 
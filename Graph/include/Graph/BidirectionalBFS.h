@@ -0,0 +1,69 @@
+/*
+ * Written by Eran Kravitz
+ * Email: kravitzer@gmail.com
+ */
+
+#pragma once
+
+#include "CompactGraph.h"
+#include "defs.h"
+#include <vector>
+
+namespace hyperbolicity
+{
+
+/*
+ * @brief	Finds the distance between two nodes of a compact graph by growing a BFS ball around each of them, a level at a time (always
+ *			the side with the smaller frontier), until the balls meet. Only nodes within about half the distance of either node are
+ *			visited, which for short distances is far less than a full traversal, and the search stops once a given bound is exceeded.
+ * @note	Instances keep scratch buffers between calls (cleared by a generation count, not per call) and are not thread-safe.
+ */
+class BidirectionalBFS
+{
+public:
+	/*
+	 * @brief	Ctor receiving the graph to run on. The graph must outlive this instance.
+	 */
+	explicit BidirectionalBFS(const CompactGraph& graph);
+
+	/*
+	 * @brief	Default dtor.
+	 */
+	~BidirectionalBFS();
+
+	/*
+	 * @returns	The distance between the given nodes, or CompactInfiniteDistance if it is larger than maxDistance (or they are not connected).
+	 */
+	compact_distance_t run(node_index_t source, node_index_t target, compact_distance_t maxDistance);
+
+private:
+	//do *not* allow copy ctor / assignment operator
+	BidirectionalBFS(const BidirectionalBFS&);
+	BidirectionalBFS& operator=(const BidirectionalBFS&);
+
+	/*
+	 * @brief	The state of one of the two searches.
+	 */
+	struct Side
+	{
+		//the generation in which each node was reached (a node is reached in this run iff it equals the current generation), and its distance
+		std::vector<unsigned int> reached;
+		std::vector<compact_distance_t> distances;
+		//the nodes of the last level, and the level's distance
+		std::vector<node_index_t> frontier;
+		compact_distance_t depth;
+	};
+
+	/*
+	 * @brief	Expands the given side by one level.
+	 * @returns	The shortest distance through a node the other side has reached, CompactInfiniteDistance if there is none yet.
+	 */
+	compact_distance_t expand(Side& side, const Side& other);
+
+	const CompactGraph& _graph;
+	Side _sides[2];
+	unsigned int _generation;
+	std::vector<node_index_t> _next;
+};
+
+} // namespace hyperbolicity
@@ -0,0 +1,150 @@
+/*
+ * Written by Eran Kravitz
+ * Email: kravitzer@gmail.com
+ */
+
+#pragma once
+
+#include "CompactGraph.h"
+#include "defs.h"
+#include <vector>
+
+namespace hyperbolicity
+{
+
+/*
+ * @brief	The weighted core of a graph: every maximal chain of degree-2 nodes is contracted into a single edge, weighted by the chain's
+ *			length, between the chain's ends (the core nodes - those whose degree is not 2, and one node of every component that is a
+ *			simple cycle). For every chain, the shortest cycle through it - the chain closed by a shortest path between its ends that
+ *			avoids it - is found by a bucket-queue (Dial) search on the core. That cycle is isometric, so its delta is a lower bound on
+ *			the graph's delta (see Chain::cycleLength).
+ *			The distances between core nodes are the same on the core as on the graph, so the core may be searched in place of the graph
+ *			(see createCoreGraph()) - its delta is a lower bound on the graph's delta, and no chain node is farther than half its chain
+ *			from a core node, which bounds how far above it the graph's delta may be.
+ * @note	Instances keep scratch buffers between searches (cleared by a generation count, not per search) and are not thread-safe.
+ */
+class ChainCore
+{
+public:
+	//a chain node has no core index, and a direct edge between core nodes has no chain
+	static const unsigned int NoCoreNode = static_cast<unsigned int>(-1);
+	static const unsigned int NoChain = static_cast<unsigned int>(-1);
+
+	/*
+	 * @brief	A maximal chain of degree-2 nodes.
+	 */
+	struct Chain
+	{
+		//the core indices of the chain's ends (equal if the chain closes a cycle by itself)
+		unsigned int first, second;
+		//the number of edges from first to second
+		compact_distance_t length;
+		//the length of the shortest cycle through the chain, 0 if the chain is on no cycle
+		compact_distance_t cycleLength;
+		//the chain's nodes, from first to second, are _chainNodes[nodesBegin, nodesEnd)
+		size_t nodesBegin, nodesEnd;
+	};
+
+	/*
+	 * @brief	Contracts the chains of the given graph, and finds the shortest cycle through each of them.
+	 * @throws	std::overflow_error	If a chain is too long for its length to be represented as compact_distance_t.
+	 */
+	explicit ChainCore(const CompactGraph& graph);
+
+	/*
+	 * @brief	Default dtor.
+	 */
+	~ChainCore();
+
+	/*
+	 * @returns	The number of core nodes.
+	 */
+	size_t size() const;
+
+	/*
+	 * @returns	The node of the original graph of the given core index.
+	 */
+	node_index_t getNode(unsigned int coreIndex) const;
+
+	/*
+	 * @returns	The number of chains, and the chain of the given index.
+	 */
+	size_t chainCount() const;
+	const Chain& getChain(size_t chain) const;
+
+	/*
+	 * @returns	The nodes (of the original graph) of the shortest cycle through the given chain, in order - empty if the chain is on no cycle.
+	 */
+	std::vector<node_index_t> getCycle(size_t chain);
+
+	/*
+	 * @returns	The core as a weighted compact graph, whose node i is core node i - an edge of weight 1 for every edge between core nodes,
+	 *			and an edge weighted by its length for every chain between distinct core nodes (so there may be parallel edges).
+	 */
+	compact_graph_ptr_t createCoreGraph() const;
+
+private:
+	//do *not* allow copy ctor / assignment operator
+	ChainCore(const ChainCore&);
+	ChainCore& operator=(const ChainCore&);
+
+	/*
+	 * @brief	A core edge, before the edges are arranged by node.
+	 */
+	struct Edge
+	{
+		unsigned int from, to;
+		compact_distance_t weight;
+		unsigned int chain;
+	};
+
+	/*
+	 * @brief	Adds the edges of the given core node - a direct edge to every core neighbor, and the chains leaving it that were not added yet.
+	 */
+	void addEdges(const CompactGraph& graph, unsigned int coreIndex, std::vector<Edge>& edges);
+
+	/*
+	 * @brief	Walks the chain leaving the given core node through the given neighbor, and adds it (and its edges) unless it was already added.
+	 */
+	void addChain(const CompactGraph& graph, node_index_t origin, node_index_t next, std::vector<Edge>& edges);
+
+	/*
+	 * @brief	Runs Dial's algorithm on the core from the given source until the given target is settled, skipping the edges of the given chain.
+	 * @returns	The distance to the target, CompactInfiniteDistance if it was not reached.
+	 */
+	compact_distance_t runCore(unsigned int source, unsigned int excludedChain, unsigned int target);
+
+	/*
+	 * @brief	Adds the given core node to the queue at the given distance, reached from parent through the given edge, if it improves on
+	 *			its distance so far.
+	 */
+	void relax(unsigned int coreIndex, unsigned int distance, unsigned int parent, size_t parentEdge);
+
+	//the core index of every node of the original graph, and the original node of every core index
+	std::vector<unsigned int> _coreIndices;
+	std::vector<node_index_t> _nodes;
+	//the chain of every chain node (NoChain for core nodes)
+	std::vector<unsigned int> _chainIndices;
+	std::vector<Chain> _chains;
+	std::vector<node_index_t> _chainNodes;
+
+	//the core in compressed-sparse-row form (see CompactGraph), with the weight and chain of every edge
+	std::vector<size_t> _offsets;
+	std::vector<unsigned int> _neighbors;
+	std::vector<compact_distance_t> _weights;
+	std::vector<unsigned int> _edgeChains;
+
+	//scratch buffers of the traversals: the generation in which each core node was reached & settled, its distance, the node & edge
+	//it was reached from, and the bucket queue (a ring of maxWeight + 1 buckets), with the buckets used in the current run
+	unsigned int _generation;
+	std::vector<unsigned int> _reached;
+	std::vector<unsigned int> _settled;
+	std::vector<compact_distance_t> _distances;
+	std::vector<unsigned int> _parents;
+	std::vector<size_t> _parentEdges;
+	std::vector<std::vector<unsigned int>> _buckets;
+	std::vector<size_t> _usedBuckets;
+	size_t _queued;
+};
+
+} // namespace hyperbolicity
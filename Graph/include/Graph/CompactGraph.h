@@ -0,0 +1,95 @@
+/*
+ * Written by Eran Kravitz
+ * Email: kravitzer@gmail.com
+ */
+
+#pragma once
+
+#include "defs.h"
+#include <vector>
+#include <utility>
+
+namespace hyperbolicity
+{
+
+/*
+ * @brief	A read-only snapshot of a graph's adjacency in compressed-sparse-row form. Node indices are the same as in the originating graph.
+ *			Unlike the node-based graph, it holds no per-node state (i.e. no marking), so several traversals may run on it concurrently.
+ *			The edges may be weighted (e.g. the core of ChainCore, whose edges stand for chains) - distances on a weighted graph are the
+ *			lengths of its shortest weighted paths.
+ */
+class CompactGraph
+{
+public:
+	/*
+	 * @brief	Builds a snapshot of the given graph.
+	 * @throws	std::invalid_argument	Upon a null graph.
+	 */
+	explicit CompactGraph(const graph_ptr_t graph);
+
+	/*
+	 * @brief	Builds a graph of the given number of nodes, where each node's neighbors are the targets of its edges in the given list (so a
+	 *			bidirectional edge should appear in both directions), in their order in the list.
+	 * @param	weights	The weight of every edge in the list, by position - empty (the default) for an unweighted graph.
+	 * @throws	std::invalid_argument	Upon an edge with an end out of range, or weights that do not match the edges or are not positive.
+	 */
+	CompactGraph(size_t nodeCount, const std::vector<std::pair<node_index_t, node_index_t>>& edges,
+				 const std::vector<compact_distance_t>& weights = std::vector<compact_distance_t>());
+
+	/*
+	 * @brief	Default dtor.
+	 */
+	~CompactGraph();
+
+	/*
+	 * @returns	The number of nodes.
+	 */
+	size_t size() const;
+
+	/*
+	 * @returns	The number of edges (bidirectional edges are counted twice, as in Graph::edgeCount()).
+	 */
+	size_t edgeCount() const;
+
+	/*
+	 * @returns	The degree of the given node.
+	 */
+	size_t degree(node_index_t index) const;
+
+	/*
+	 * @returns	Pointers to the beginning and end of the given node's neighbor list.
+	 */
+	const unsigned int* neighborsBegin(node_index_t index) const;
+	const unsigned int* neighborsEnd(node_index_t index) const;
+
+	/*
+	 * @returns	True if the edges are weighted.
+	 */
+	bool isWeighted() const;
+
+	/*
+	 * @returns	A pointer to the weights of the given node's edges, in the order of its neighbor list - null if the graph is not weighted.
+	 */
+	const compact_distance_t* weightsBegin(node_index_t index) const;
+
+	/*
+	 * @returns	The largest weight of an edge (1 if the graph is not weighted).
+	 */
+	compact_distance_t maxWeight() const;
+
+private:
+	//do *not* allow copy ctor / assignment operator
+	CompactGraph(const CompactGraph&);
+	CompactGraph& operator=(const CompactGraph&);
+
+	//_offsets[i] is the position of node i's first neighbor in _neighbors, _offsets[size()] is the total edge count
+	std::vector<size_t> _offsets;
+	std::vector<unsigned int> _neighbors;
+	//the weight of every edge, in the order of _neighbors (empty if the graph is not weighted)
+	std::vector<compact_distance_t> _weights;
+	compact_distance_t _maxWeight;
+};
+
+typedef std::shared_ptr<CompactGraph> compact_graph_ptr_t;
+
+} // namespace hyperbolicity
@@ -0,0 +1,128 @@
+/*
+ * Written by Eran Kravitz
+ * Email: kravitzer@gmail.com
+ */
+
+#pragma once
+
+#include "DistanceMatrix.h"
+#include "CompactGraph.h"
+#include "defs.h"
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <memory>
+
+namespace hyperbolicity
+{
+
+/*
+ * @brief	In-memory distance matrix using 2 bits per entry. For adjacent nodes u and v, |d(u, x) - d(v, x)| <= 1 for every x, so given
+ *			a BFS spanning tree, every row can be stored as the difference from its parent's row (-1, 0 or +1), and only the rows of the
+ *			tree roots are stored explicitly. That is 8 times smaller than the dense matrix.
+ *			A row is decoded by walking up the tree to the nearest row available (a root, or one in a bounded LRU cache of decoded rows)
+ *			and applying the differences back down, 64 entries at a time using SSE2. The cache is split into shards that are locked
+ *			separately, and decoded rows are shared with their readers, so decoding and copying are done without holding any lock.
+ *			A single distance is read from a cached row of either node if there is one, and otherwise by summing the differences up to
+ *			the root, which needs no lock at all.
+ */
+class DeltaEncodedDistanceMatrix : public IDistanceMatrix
+{
+public:
+	/*
+	 * @brief	Computes and encodes all distances, using multi-source BFS.
+	 * @param	graph			The graph (should be connected - each additional component adds an explicit row).
+	 * @param	memoryBudget	Number of bytes to use - whatever is left after the encoded matrix goes to the cache of decoded rows.
+	 * @param	progress		Called after every batch of sources (optional). If it stops the computation, the matrix is left incomplete and
+	 *							must not be used.
+	 * @throws	std::overflow_error		If a distance cannot be represented as compact_distance_t.
+	 * @throws	std::invalid_argument	Upon a weighted graph, whose adjacent nodes' rows may differ by more than 1.
+	 */
+	DeltaEncodedDistanceMatrix(const CompactGraph& graph, unsigned long long memoryBudget, const progress_callback_t& progress = progress_callback_t());
+	virtual ~DeltaEncodedDistanceMatrix();
+
+	virtual size_t size() const;
+	virtual compact_distance_t getDistance(node_index_t u, node_index_t v) const;
+	virtual void getRow(node_index_t u, compact_distance_t* row) const;
+	virtual compact_distance_t getMaxDistance() const;
+
+	/*
+	 * @returns	The number of bytes needed to encode the matrix of a graph with the given number of nodes (excluding the cache).
+	 */
+	static unsigned long long getEncodedSize(size_t nodeCount);
+
+	//the minimal number of decoded rows kept in the cache
+	static const size_t MinCachedRows = 16;
+
+	//the number of separately locked parts of the cache
+	static const size_t CacheShardCount = 16;
+
+private:
+	//do *not* allow copy ctor / assignment operator
+	DeltaEncodedDistanceMatrix(const DeltaEncodedDistanceMatrix&);
+	DeltaEncodedDistanceMatrix& operator=(const DeltaEncodedDistanceMatrix&);
+
+	typedef std::vector<compact_distance_t> row_t;
+	typedef std::shared_ptr<const row_t> row_ptr_t;
+	typedef std::list<std::pair<node_index_t, row_ptr_t>> row_cache_t;
+
+	//LRU cache of decoded rows - most recently used first, and the position of each cached row (by node) in it
+	struct CacheShard
+	{
+		row_cache_t cache;
+		std::unordered_map<node_index_t, row_cache_t::iterator> positions;
+		std::mutex mutex;
+	};
+
+	/*
+	 * @brief	Builds the BFS spanning forest (_parent, _rootRows' keys).
+	 * @returns	The nodes in BFS order, so that every node comes after its parent.
+	 */
+	std::vector<node_index_t> buildForest(const CompactGraph& graph);
+
+	/*
+	 * @brief	Computes the rows of all nodes and encodes each one relative to its parent's row.
+	 * @param	progress	Called after every batch of sources, and may stop the computation (leaving the rest unencoded).
+	 */
+	void encode(const CompactGraph& graph, const std::vector<node_index_t>& order, const progress_callback_t& progress);
+
+	/*
+	 * @returns	The 2-bit code of the distance from u to x, relative to the distance from u's parent to x (0 is -1, 1 is 0, 2 is +1).
+	 */
+	unsigned int getCode(node_index_t u, node_index_t x) const;
+
+	/*
+	 * @returns	The full (padded) row of the given node - either a root row, or a cached one (decoding it if necessary).
+	 */
+	row_ptr_t getDecodedRow(node_index_t u) const;
+
+	/*
+	 * @returns	The already available row of the given node (a root row or a cached one), null if there is none.
+	 */
+	row_ptr_t findRow(node_index_t u) const;
+
+	/*
+	 * @brief	Adds a decoded row to the cache, evicting the least recently used row of its shard if it is full.
+	 */
+	void cacheRow(node_index_t u, const row_ptr_t& row) const;
+
+	size_t _size;
+	//rows are padded to a multiple of 64 entries, so that decoding never handles partial blocks
+	size_t _paddedSize;
+	compact_distance_t _maxDistance;
+
+	//parent of each node in the BFS forest (roots are their own parents), and the explicit rows of the roots
+	std::vector<node_index_t> _parent;
+	std::unordered_map<node_index_t, std::shared_ptr<row_t>> _rootRows;
+
+	//the codes of each node's row, _paddedSize / 4 bytes per node. Within every 16 bytes (64 entries), entry 16 * k + b is kept in
+	//bits 2k..2k+1 of byte b, so that the entries decoded by one shift & mask are consecutive
+	std::vector<unsigned char> _codes;
+
+	//the row of node u is cached in shard u % CacheShardCount
+	mutable CacheShard _shards[CacheShardCount];
+	size_t _maxCachedRowsPerShard;
+};
+
+} // namespace hyperbolicity
@@ -0,0 +1,121 @@
+/*
+ * Written by Eran Kravitz
+ * Email: kravitzer@gmail.com
+ */
+
+#pragma once
+
+#include "CompactGraph.h"
+#include "defs.h"
+#include <vector>
+#include <functional>
+
+namespace hyperbolicity
+{
+
+/*
+ * @brief	Called between chunks of a long computation, with the fraction of it done so far (0 to 1). Returning false stops the computation.
+ */
+typedef std::function<bool (double progress)> progress_callback_t;
+
+/*
+ * @brief	All-pairs shortest path distances of a connected graph, in compact form. Implementations differ in where the distances
+ *			are kept (memory, disk) and must all be safe to read from several threads at once.
+ */
+class IDistanceMatrix
+{
+public:
+	virtual ~IDistanceMatrix() {}
+
+	/*
+	 * @returns	The number of nodes.
+	 */
+	virtual size_t size() const = 0;
+
+	/*
+	 * @returns	The distance between the given nodes, CompactInfiniteDistance if they are not connected.
+	 */
+	virtual compact_distance_t getDistance(node_index_t u, node_index_t v) const = 0;
+
+	/*
+	 * @brief	Copies the distances from the given node to every node into row (which must have room for size() entries).
+	 */
+	virtual void getRow(node_index_t u, compact_distance_t* row) const = 0;
+
+	/*
+	 * @returns	The largest finite distance in the matrix (i.e. the diameter, for a connected graph).
+	 */
+	virtual compact_distance_t getMaxDistance() const = 0;
+};
+
+typedef std::shared_ptr<IDistanceMatrix> distance_matrix_ptr_t;
+
+/*
+ * @brief	Distance matrix kept entirely in memory as n*n compact distances.
+ */
+class DenseDistanceMatrix : public IDistanceMatrix
+{
+public:
+	/*
+	 * @brief	Calculates all distances, using multi-source BFS (see MultiSourceBFS, which runs Dial's algorithm on a weighted graph).
+	 * @param	progress	Called after every batch of sources (optional). If it stops the computation, the matrix is left incomplete and
+	 *						must not be used.
+	 * @throws	std::overflow_error	If a distance cannot be represented as compact_distance_t.
+	 */
+	explicit DenseDistanceMatrix(const CompactGraph& graph, const progress_callback_t& progress = progress_callback_t());
+	virtual ~DenseDistanceMatrix();
+
+	virtual size_t size() const;
+	virtual compact_distance_t getDistance(node_index_t u, node_index_t v) const;
+	virtual void getRow(node_index_t u, compact_distance_t* row) const;
+	virtual compact_distance_t getMaxDistance() const;
+
+	/*
+	 * @returns	The row of the given node, without copying it.
+	 */
+	const compact_distance_t* row(node_index_t u) const;
+
+private:
+	//do *not* allow copy ctor / assignment operator
+	DenseDistanceMatrix(const DenseDistanceMatrix&);
+	DenseDistanceMatrix& operator=(const DenseDistanceMatrix&);
+
+	size_t _size;
+	compact_distance_t _maxDistance;
+	std::vector<compact_distance_t> _distances;
+};
+
+/*
+ * @brief	Chooses the distance matrix representation for a graph, according to a memory budget.
+ */
+class DistanceMatrixFactory
+{
+public:
+	//default memory budget for a distance matrix - 1GB
+	static const unsigned long long DefaultMemoryBudget = 1ULL << 30;
+
+	/*
+	 * @brief	Creates a distance matrix for the given graph. If the full matrix fits in the budget, it is kept in memory as is,
+	 *			otherwise if its 2-bit delta encoding fits, it is kept in memory encoded (see DeltaEncodedDistanceMatrix). Failing both,
+	 *			it is computed into a tiled file on disk, and only a bounded number of tiles are held in memory.
+	 *			The distances of a weighted graph are not delta encoded (neighbors' rows may differ by more than 1), so they go to disk instead.
+	 * @param	graph			The graph (must be connected).
+	 * @param	memoryBudget	Number of bytes the matrix may use.
+	 * @param	progress		Called between batches of sources (optional), and may stop the computation.
+	 * @param	shouldMarkFarApartPairs	Whether a tiled matrix should mark its far-apart pairs (see TiledDistanceMatrix) - the other
+	 *									representations read whole rows cheaply, so they need no marks.
+	 * @returns	The matrix, null if progress stopped its computation.
+	 * @throws	std::overflow_error	If a distance cannot be represented as compact_distance_t.
+	 * @throws	std::exception		Upon an I/O error with the tiled representation.
+	 */
+	static distance_matrix_ptr_t create(const graph_ptr_t graph, unsigned long long memoryBudget = DefaultMemoryBudget,
+										const progress_callback_t& progress = progress_callback_t(), bool shouldMarkFarApartPairs = false);
+
+	/*
+	 * @brief	Overload for an existing compact snapshot of the graph.
+	 */
+	static distance_matrix_ptr_t create(const CompactGraph& graph, unsigned long long memoryBudget = DefaultMemoryBudget,
+										const progress_callback_t& progress = progress_callback_t(), bool shouldMarkFarApartPairs = false);
+};
+
+} // namespace hyperbolicity
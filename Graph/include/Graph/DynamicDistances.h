@@ -0,0 +1,136 @@
+/*
+ * Written by Eran Kravitz
+ * Email: kravitzer@gmail.com
+ */
+
+#pragma once
+
+#include "CompactGraph.h"
+#include "MultiSourceBFS.h"
+#include "defs.h"
+#include <vector>
+#include <unordered_map>
+
+namespace hyperbolicity
+{
+
+/*
+ * @brief	Keeps distance rows of selected nodes of a graph that is being modified, and keeps them valid across deletions instead of
+ *			recomputing them: after nodes are deleted, each stored row is compacted in place to the new indices, and only rows whose
+ *			distances may have changed are recomputed.
+ *
+ *			A row of x is affected by the deletion of w only if some remaining node y with d(x,y) = d(x,w)+1 is left with no neighbor
+ *			at distance d(x,y)-1 from x (i.e. w was its only parent in the BFS from x). Otherwise every remaining node keeps a shortest
+ *			path parent, so by induction on the distance, no distance from x changed. Deleting a pendant tree or a chain that is not a
+ *			shortest path between its ends never affects other distances, so callers doing only such deletions may skip the check.
+ */
+class DynamicDistances
+{
+public:
+	//mapping value of a deleted node, see synchronize()
+	static const node_index_t DeletedNode = static_cast<node_index_t>(-1);
+
+	/*
+	 * @brief	Ctor receiving the graph whose distances are kept.
+	 */
+	explicit DynamicDistances(const graph_ptr_t graph);
+
+	/*
+	 * @brief	Default dtor.
+	 */
+	~DynamicDistances();
+
+	/*
+	 * @returns	The distance row of the given node (computed if not stored yet). The reference is valid until the next call to a
+	 *			non-const method.
+	 */
+	const std::vector<compact_distance_t>& getRow(node_index_t node);
+
+	/*
+	 * @brief	Makes sure the rows of the given nodes are stored, computing the missing ones together in a single multi-source run.
+	 */
+	void loadRows(const node_index_t* nodes, size_t count);
+
+	/*
+	 * @returns	True iff the row of the given node is stored.
+	 */
+	bool hasRow(node_index_t node) const;
+
+	/*
+	 * @brief	Drops the stored row of the given node (if any).
+	 */
+	void removeRow(node_index_t node);
+
+	/*
+	 * @brief	Drops all stored rows.
+	 */
+	void clear();
+
+	/*
+	 * @brief	Brings the stored rows up to date after nodes were deleted from the graph (by any number of calls to removeNode() or
+	 *			deleteMarkedNodes() since the last synchronization). Rows of deleted nodes are dropped.
+	 * @param	isDistancePreserving	True if the caller knows that the deletions did not change any distance between remaining nodes
+	 *									(e.g. only pendant trees or non-shortest chains were deleted), so that rows are only remapped.
+	 * @returns	A mapping from each old node index to its new index (or DeletedNode), for callers to remap their own state.
+	 *			The reference is valid until the next synchronization.
+	 */
+	const std::vector<node_index_t>& synchronize(bool isDistancePreserving = false);
+
+	/*
+	 * @brief	Brings the stored rows up to date after the (bidirectional) edge between the given nodes was removed from the graph.
+	 *			Rows must be synchronized with the graph before the edge is removed.
+	 */
+	void edgeRemoved(node_index_t a, node_index_t b);
+
+	/*
+	 * @returns	The number of rows that were recomputed, since the instance was created, due to deletions.
+	 */
+	size_t getRecomputedRowCount() const;
+
+	/*
+	 * @returns	The number of rows that were kept, since the instance was created, by remapping them after deletions.
+	 */
+	size_t getRemappedRowCount() const;
+
+private:
+	//do *not* allow copy ctor / assignment operator
+	DynamicDistances(const DynamicDistances&);
+	DynamicDistances& operator=(const DynamicDistances&);
+
+	typedef std::vector<compact_distance_t> row_t;
+
+	/*
+	 * @brief	Takes a new snapshot of the graph (both its adjacency and its node pointers).
+	 */
+	void takeSnapshot();
+
+	/*
+	 * @returns	True iff a deletion left some node of the row without a shortest path parent from the row's origin.
+	 * @param	row		The row, with the old indices.
+	 * @param	deleted	The old indices of the deleted nodes.
+	 */
+	bool isRowAffected(const row_t& row, const std::vector<node_index_t>& deleted) const;
+
+	/*
+	 * @returns	True iff the given node has a neighbor one step closer to the row's origin, in the current snapshot.
+	 */
+	bool hasParent(const row_t& row, node_index_t node) const;
+
+	graph_ptr_t _graph;
+
+	//the graph at the last synchronization - its adjacency, and the node at each index (to detect deletions & new indices)
+	compact_graph_ptr_t _compactGraph;
+	node_ptr_collection_t _nodes;
+	std::shared_ptr<MultiSourceBFS> _bfs;
+
+	//stored rows by origin node
+	std::unordered_map<node_index_t, row_t> _rows;
+
+	//last mapping returned by synchronize()
+	std::vector<node_index_t> _mapping;
+
+	size_t _recomputedRowCount;
+	size_t _remappedRowCount;
+};
+
+} // namespace hyperbolicity
@@ -6,6 +6,7 @@
 #pragma once
 
 #include "Graph.h"
+#include "CompactGraph.h"
 #include <vector>
 #include <queue>
 #include <unordered_map>
@@ -30,11 +31,13 @@ namespace hyperbolicity
 
 		/*
 		 * @brief	Loads the graph from the given file.
-		 * @param	path	The file path to be loaded.
+		 * @param	path				The file path to be loaded.
+		 * @param	shouldPruneTrees	If true, only the 2-core is created (see getTwoCore()) - pendant trees are dropped before any of their
+		 *								nodes is. Nodes keep their index in the file as their label.
 		 * @returns	A graph instance loaded from the file.
 		 * @throws	std::exception	Upon a failure (I/O failure, invalid format, etc.).
 		 */
-		static graph_ptr_t LoadGraphFromFile(const std::string& path);
+		static graph_ptr_t LoadGraphFromFile(const std::string& path, bool shouldPruneTrees = false);
 
 
 		/*
@@ -42,16 +45,51 @@ namespace hyperbolicity
 		 *			Comments are allowed if line starts with "#".
 		 * @param	path			The file path to be loaded.
 		 * @param	isBidirectional	True if each line represents a bidirectional edge, false otherwise.
+		 * @param	shouldPruneTrees	If true, only the 2-core is created (see getTwoCore()). Nodes keep their index in order of appearance
+		 *								as their label.
 		 * @returns	A graph instance loaded from the file.
 		 * @throws	std::exception	Upon a failure (I/O failure, invalid format, etc.).
 		 */
-		static graph_ptr_t LoadGraphFromEdgeListFile(const std::string& path, bool isBidirectional);
+		static graph_ptr_t LoadGraphFromEdgeListFile(const std::string& path, bool isBidirectional, bool shouldPruneTrees = false);
 
 		/*
 		 * @returns	Returns the collection of the sub-graphs that are biconnected within the graph.
 		 */
 		static graph_ptr_collection_t getBiconnectedComponents(const graph_ptr_t graph);
 
+		/*
+		 * @brief	Decomposes the graph by its clique minimal separators. The resulting atoms are isometric subgraphs, usually much smaller
+		 *			than the biconnected components, and the graph's delta hyperbolicity is between the maximum over them and that maximum
+		 *			plus 1 (Cohen, Coudert, Ducoffe & Lancin) - e.g. atoms of delta 1 may be glued into a graph of delta 1.5.
+		 *			A minimal triangulation and the candidate separators are found with MCS-M, then each candidate that is a clique
+		 *			in the graph splits off an atom (after Berry, Pogorelcnik & Simonet). Takes O(nm) time.
+		 * @returns	The atoms, as sub-graphs (a graph with no clique separator is returned as a single atom).
+		 */
+		static graph_ptr_collection_t getAtoms(const graph_ptr_t graph);
+
+		/*
+		 * @returns	The sub-graph induced by the given nodes, with the given title (node labels are kept).
+		 */
+		static graph_ptr_t getInducedSubgraph(const graph_ptr_t graph, const std::vector<node_index_t>& nodes, const std::string& title);
+
+		/*
+		 * @brief	Finds the 2-core of the graph - the nodes left once nodes of degree 0 or 1 are removed, repeatedly. Every node keeps a
+		 *			count of its neighbors not yet peeled, and the nodes are peeled a level at a time: peeling a node decrements its neighbors'
+		 *			counts, and a neighbor whose count drops to 1 joins the next level. Takes O(n + m) time, and no recursion.
+		 * @param	graph		The graph to run on.
+		 * @returns	The nodes of the 2-core, by increasing index.
+		 */
+		static std::vector<node_index_t> getTwoCore(const CompactGraph& graph);
+
+		/*
+		 * @param	graph	The graph the distances were found on.
+		 * @param	row		The distances from some node u to every node.
+		 * @returns	True if none of v's neighbors is farther from u than v is. A pair (u, v) is far-apart if this holds both ways around.
+		 *			On a weighted graph, a neighbor w only counts if a shortest path from u to w runs through v - otherwise d(u, w) grows
+		 *			by less than the edge's weight, while w's distances to other nodes may grow by all of it.
+		 */
+		static bool isFarthestAmongNeighbors(const CompactGraph& graph, const compact_distance_t* row, node_index_t v);
+
 	private:
 		static const int NodeIndexMaxNumOfDigits;
 		static const char* EdgeMarker;
@@ -73,6 +111,12 @@ namespace hyperbolicity
 		 */
 		static std::string shortPath(const std::string& path);
 
+		/*
+		 * @brief	Creates a graph of the given number of nodes and the given (unidirectional) edges, or only of its 2-core.
+		 */
+		static graph_ptr_t createGraph(const std::string& title, size_t nodeCount, const std::vector<std::pair<node_index_t, node_index_t>>& edges,
+									   bool shouldPruneTrees);
+
 		static void biconnected(const graph_ptr_t graph, node_index_t v, node_index_t u, std::unordered_map<node_index_t, unsigned int>& number, std::unordered_map<node_index_t, unsigned int>& lowpt, unsigned int index, std::vector<std::pair<node_index_t, node_index_t>>& edgeStack, graph_ptr_collection_t& biconnectedGraphs);
 		
 		/*
@@ -0,0 +1,75 @@
+/*
+ * Written by Eran Kravitz
+ * Email: kravitzer@gmail.com
+ */
+
+#pragma once
+
+#include "CompactGraph.h"
+#include "defs.h"
+#include <vector>
+
+namespace hyperbolicity
+{
+
+/*
+ * @brief	Computes distance rows over a compact graph. Up to 64 sources are traversed together in a single bit-parallel BFS
+ *			(each node holds a 64-bit mask of the sources that have reached it), so that every edge is scanned once per level for
+ *			the whole block instead of once per source.
+ *			On a weighted graph (see CompactGraph::isWeighted()) the sources are traversed one at a time instead, by Dial's algorithm
+ *			(a ring of maxWeight + 1 buckets of nodes by distance).
+ * @note	Instances keep scratch buffers between calls and are not thread-safe; use one instance per thread.
+ */
+class MultiSourceBFS
+{
+public:
+	//the maximal number of sources in a single bit-parallel run
+	static const size_t MaxSources = 64;
+
+	/*
+	 * @brief	Ctor receiving the graph to run on. The graph must outlive this instance.
+	 */
+	explicit MultiSourceBFS(const CompactGraph& graph);
+
+	/*
+	 * @brief	Default dtor.
+	 */
+	~MultiSourceBFS();
+
+	/*
+	 * @brief	Calculates the distances from each of the given sources to every node in the graph.
+	 * @param	sources		The source nodes.
+	 * @param	count		Number of sources, at most MaxSources.
+	 * @param	rows		rows[i] receives the distances from sources[i], and must have room for graph.size() entries.
+	 *						Unreachable nodes are set to CompactInfiniteDistance.
+	 * @throws	std::invalid_argument	If count exceeds MaxSources.
+	 * @throws	std::overflow_error		If a distance cannot be represented as compact_distance_t.
+	 */
+	void run(const node_index_t* sources, size_t count, compact_distance_t* const* rows);
+
+	/*
+	 * @brief	Single source overload, using a regular queue-based BFS.
+	 */
+	void run(node_index_t source, compact_distance_t* row);
+
+private:
+	/*
+	 * @brief	Single source run on a weighted graph, by Dial's algorithm.
+	 */
+	void runWeighted(node_index_t source, compact_distance_t* row);
+
+	//do *not* allow copy ctor / assignment operator
+	MultiSourceBFS(const MultiSourceBFS&);
+	MultiSourceBFS& operator=(const MultiSourceBFS&);
+
+	const CompactGraph& _graph;
+
+	//bit-parallel state - the sources that have reached each node, the ones that reached it on the last level, and the ones reaching it now
+	std::vector<unsigned long long> _seen, _frontier, _next;
+
+	//queue for single source runs, and the buckets of runs on a weighted graph
+	std::vector<unsigned int> _queue;
+	std::vector<std::vector<unsigned int>> _buckets;
+};
+
+} // namespace hyperbolicity
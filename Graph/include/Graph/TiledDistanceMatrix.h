@@ -0,0 +1,219 @@
+/*
+ * Written by Eran Kravitz
+ * Email: kravitzer@gmail.com
+ */
+
+#pragma once
+
+#include "DistanceMatrix.h"
+#include "CompactGraph.h"
+#include "defs.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <memory>
+#include <future>
+
+namespace hyperbolicity
+{
+
+/*
+ * @brief	Out-of-core distance matrix, for graphs whose full matrix does not fit in memory.
+ *			Rows are computed in blocks of TileSize sources (using multi-source BFS) and written to a temporary file as TileSize x TileSize
+ *			tiles. Only the tiles on or above the diagonal are stored (the matrix is symmetric), a tile row at a time, so that each block of
+ *			sources is written sequentially. Random access goes through a bounded LRU cache of tiles, split into shards that are locked
+ *			separately. Tiles are shared with their readers, so copying out of a tile and reading a missing one from the file are both
+ *			done without holding any shard's lock. Sequential access (see TileReader) reads the file in order, fetching the next tile in
+ *			the background while the current one is being processed.
+ *			Optionally, the far-apart pairs (see GraphAlgorithms::isFarthestAmongNeighbors()) are marked as well, in a bit plane stored
+ *			after each tile: while a block of sources is computed its full rows are in memory, so the pairs are checked from the block's
+ *			side, and the bits of a tile left of the diagonal are combined into the mirrored tile, which was written by an earlier block.
+ *			A single pass of a TileReader then finds every far-apart pair, which no order of whole rows could do in a single pass.
+ */
+class TiledDistanceMatrix : public IDistanceMatrix
+{
+public:
+	/*
+	 * @brief	Computes the matrix into a temporary file, which is deleted when the instance is destroyed.
+	 * @param	graph			The graph (must be connected).
+	 * @param	memoryBudget	Number of bytes to use - bounds both the rows computed at once and the tile cache.
+	 * @param	progress		Called after every block of sources (optional). If it stops the computation, the matrix is left incomplete
+	 *							and must not be used.
+	 * @param	shouldMarkFarApartPairs	Whether to mark the far-apart pairs as well (see TileReader::Tile::isFarApart()).
+	 * @throws	std::overflow_error	If a distance cannot be represented as compact_distance_t.
+	 * @throws	std::exception		Upon an I/O error.
+	 */
+	TiledDistanceMatrix(const CompactGraph& graph, unsigned long long memoryBudget, const progress_callback_t& progress = progress_callback_t(),
+						bool shouldMarkFarApartPairs = false);
+	virtual ~TiledDistanceMatrix();
+
+	virtual size_t size() const;
+	virtual compact_distance_t getDistance(node_index_t u, node_index_t v) const;
+	virtual void getRow(node_index_t u, compact_distance_t* row) const;
+	virtual compact_distance_t getMaxDistance() const;
+
+	/*
+	 * @returns	The tile dimension.
+	 */
+	size_t getTileSize() const;
+
+	/*
+	 * @returns	The number of tiles in each row/column of the matrix.
+	 */
+	size_t getTileCount() const;
+
+	/*
+	 * @returns	True if the far-apart pairs were marked.
+	 */
+	bool hasFarApartPairs() const;
+
+	/*
+	 * @brief	Reads the tiles of a tiled matrix in file order (tile (i, j) for every i <= j, by rows), using its own file handle. While the
+	 *			caller processes a tile, the next one is already being read in the background.
+	 */
+	class TileReader
+	{
+	public:
+		/*
+		 * @brief	A tile: rows [rowBegin, rowEnd) and columns [colBegin, colEnd) of the matrix, where rowBegin <= colBegin.
+		 */
+		struct Tile
+		{
+			node_index_t rowBegin, rowEnd;
+			node_index_t colBegin, colEnd;
+
+			/*
+			 * @returns	The distance between rowBegin + r and colBegin + c.
+			 */
+			compact_distance_t getDistance(size_t r, size_t c) const;
+
+			/*
+			 * @returns	True if rowBegin + r and colBegin + c are a far-apart pair (always false unless the pairs were marked - see
+			 *			hasFarApartPairs()). Both halves of a tile on the diagonal are marked.
+			 */
+			bool isFarApart(size_t r, size_t c) const;
+
+			//the tile's record, as read from the file, and the tile dimension
+			std::vector<compact_distance_t> data;
+			size_t stride;
+			bool hasFarApartPairs;
+		};
+
+		/*
+		 * @throws	std::exception	If the file cannot be opened.
+		 */
+		explicit TileReader(const TiledDistanceMatrix& matrix);
+		~TileReader();
+
+		/*
+		 * @brief	Fetches the next tile.
+		 * @param	tile	Set to the next tile, which remains valid until the next call.
+		 * @returns	False if there are no more tiles (tile is left unchanged), true otherwise.
+		 * @throws	std::exception	Upon an I/O error.
+		 */
+		bool next(const Tile*& tile);
+
+	private:
+		//do *not* allow copy ctor / assignment operator
+		TileReader(const TileReader&);
+		TileReader& operator=(const TileReader&);
+
+		/*
+		 * @brief	Starts reading the record of tile (_i, _j) in the background.
+		 */
+		void prefetch();
+
+		const TiledDistanceMatrix& _matrix;
+		FILE* _file;
+
+		//the next tile to be returned, and its read
+		size_t _i, _j;
+		std::future<std::vector<compact_distance_t>> _pending;
+
+		//the tile last returned
+		Tile _current;
+	};
+
+	//the minimal & maximal tile dimensions
+	static const size_t MinTileSize = 64;
+	static const size_t MaxTileSize = 1024;
+
+	//the minimal number of tiles kept in the cache
+	static const size_t MinCachedTiles = 4;
+
+	//the number of separately locked parts of the cache
+	static const size_t CacheShardCount = 16;
+
+private:
+	//do *not* allow copy ctor / assignment operator
+	TiledDistanceMatrix(const TiledDistanceMatrix&);
+	TiledDistanceMatrix& operator=(const TiledDistanceMatrix&);
+
+	typedef std::vector<compact_distance_t> tile_t;
+	typedef std::shared_ptr<const tile_t> tile_ptr_t;
+	typedef std::list<std::pair<size_t, tile_ptr_t>> tile_cache_t;
+
+	//LRU cache of tiles - most recently used first, and the position of each cached tile (by tile number) in it
+	struct CacheShard
+	{
+		tile_cache_t cache;
+		std::unordered_map<size_t, tile_cache_t::iterator> positions;
+		std::mutex mutex;
+	};
+
+	/*
+	 * @brief	Computes all rows, tile row by tile row, and writes them to the file.
+	 * @param	progress	Called after every tile row, and may stop the computation (leaving the rest unwritten).
+	 */
+	void computeTiles(const CompactGraph& graph, const progress_callback_t& progress);
+
+	/*
+	 * @brief	Marks the far-apart pairs of the current block of sources (see computeTiles()) in the record of tile (i, j), before it is
+	 *			written - its nodes v are only checked from the block's side (no neighbor of v is farther from the source than v), unless the
+	 *			tile is on the diagonal.
+	 * @param	rows	The rows of the block.
+	 * @param	marks	The bit plane to fill.
+	 */
+	void markFarApartPairs(const CompactGraph& graph, size_t i, size_t j, const std::vector<compact_distance_t>& rows, std::vector<unsigned char>& marks) const;
+
+	/*
+	 * @brief	Completes the far-apart marks of tile (j, i), for every j < i - written by block j, and checked from the side of block i
+	 *			(the current one) here.
+	 * @param	rows	The rows of block i.
+	 * @param	marks	Buffer for a bit plane.
+	 */
+	void completeFarApartPairs(const CompactGraph& graph, size_t i, const std::vector<compact_distance_t>& rows, std::vector<unsigned char>& marks);
+
+	/*
+	 * @returns	The (i, j) tile (where i <= j), from the cache or the file.
+	 */
+	tile_ptr_t getTile(size_t i, size_t j) const;
+
+	/*
+	 * @returns	The position in the file of tile (i, j), where i <= j.
+	 */
+	long long getTileOffset(size_t i, size_t j) const;
+
+	/*
+	 * @returns	The number of compact distances in the record of a tile - the tile, followed by its far-apart marks (if any).
+	 */
+	size_t getRecordSize() const;
+
+	size_t _size;
+	size_t _tileSize;
+	size_t _tileCount;
+	bool _hasFarApartPairs;
+	compact_distance_t _maxDistance;
+	std::string _path;
+	FILE* _file;
+
+	//tile (i, j) is cached in shard (i * tileCount + j) % CacheShardCount
+	mutable CacheShard _shards[CacheShardCount];
+	size_t _maxCachedTilesPerShard;
+	mutable std::mutex _fileMutex;
+};
+
+} // namespace hyperbolicity
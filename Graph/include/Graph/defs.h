@@ -8,6 +8,7 @@
 #include <memory>
 #include <vector>
 #include <unordered_map>
+#include <climits>
 
 namespace hyperbolicity
 {
@@ -28,6 +29,10 @@ namespace hyperbolicity
 	typedef	int												distance_t;
 	typedef std::unordered_map<node_index_t, distance_t>	distance_dict_t;
 
+	//compact (2-byte) distance, used by the distance matrices
+	typedef unsigned short									compact_distance_t;
+
 	//constants
 	const distance_t										InfiniteDistance = -1;
+	const compact_distance_t								CompactInfiniteDistance = USHRT_MAX;
 }
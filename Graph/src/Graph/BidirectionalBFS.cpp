@@ -0,0 +1,81 @@
+#include "BidirectionalBFS.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace hyperbolicity
+{
+
+BidirectionalBFS::BidirectionalBFS(const CompactGraph& graph) : _graph(graph), _generation(0)
+{
+	for (size_t i = 0; i < 2; ++i)
+	{
+		_sides[i].reached.assign(graph.size(), 0);
+		_sides[i].distances.assign(graph.size(), 0);
+	}
+}
+
+BidirectionalBFS::~BidirectionalBFS()
+{
+	//empty on purpose
+}
+
+compact_distance_t BidirectionalBFS::run(node_index_t source, node_index_t target, compact_distance_t maxDistance)
+{
+	if (source == target) return 0;
+
+	//a new generation marks every node as unreached, the buffers are only cleared once the count wraps around
+	if (0 == ++_generation)
+	{
+		for (size_t i = 0; i < 2; ++i) fill(_sides[i].reached.begin(), _sides[i].reached.end(), 0);
+		_generation = 1;
+	}
+	const node_index_t ends[2] = { source, target };
+	for (size_t i = 0; i < 2; ++i)
+	{
+		Side& side = _sides[i];
+		side.reached[ends[i]] = _generation;
+		side.distances[ends[i]] = 0;
+		side.frontier.assign(1, ends[i]);
+		side.depth = 0;
+	}
+
+	//the balls' radii add up to a lower bound on the distance, so the search ends once they exceed the bound
+	while (_sides[0].depth + _sides[1].depth < maxDistance)
+	{
+		Side& side = (_sides[0].frontier.size() <= _sides[1].frontier.size() ? _sides[0] : _sides[1]);
+		Side& other = (&side == &_sides[0] ? _sides[1] : _sides[0]);
+		if (side.frontier.empty()) break;
+
+		compact_distance_t distance = expand(side, other);
+		if (CompactInfiniteDistance != distance) return (distance <= maxDistance ? distance : CompactInfiniteDistance);
+	}
+
+	return CompactInfiniteDistance;
+}
+
+compact_distance_t BidirectionalBFS::expand(Side& side, const Side& other)
+{
+	++side.depth;
+	_next.clear();
+
+	//all of the level is expanded, as the first node met is not necessarily on a shortest path
+	compact_distance_t best = CompactInfiniteDistance;
+	for (vector<node_index_t>::const_iterator u = side.frontier.cbegin(); u != side.frontier.cend(); ++u)
+	{
+		for (const unsigned int* w = _graph.neighborsBegin(*u); w != _graph.neighborsEnd(*u); ++w)
+		{
+			if (_generation == side.reached[*w]) continue;
+			side.reached[*w] = _generation;
+			side.distances[*w] = side.depth;
+			_next.push_back(*w);
+
+			if (_generation == other.reached[*w]) best = min(best, static_cast<compact_distance_t>(side.depth + other.distances[*w]));
+		}
+	}
+
+	side.frontier.swap(_next);
+	return best;
+}
+
+} // namespace hyperbolicity
@@ -0,0 +1,278 @@
+#include "ChainCore.h"
+#include <algorithm>
+#include <stdexcept>
+#include <memory>
+
+using namespace std;
+
+namespace hyperbolicity
+{
+
+ChainCore::ChainCore(const CompactGraph& graph) : _coreIndices(graph.size(), static_cast<unsigned int>(NoCoreNode)),
+	_chainIndices(graph.size(), static_cast<unsigned int>(NoChain)), _generation(0), _queued(0)
+{
+	for (node_index_t node = 0; node < graph.size(); ++node)
+	{
+		if (2 == graph.degree(node)) continue;
+		_coreIndices[node] = static_cast<unsigned int>(_nodes.size());
+		_nodes.push_back(node);
+	}
+
+	//every chain is walked from the first of its ends to be reached, direct edges are added from both ends
+	vector<Edge> edges;
+	const size_t degreeCoreSize = _nodes.size();
+	for (unsigned int i = 0; i < degreeCoreSize; ++i)
+	{
+		addEdges(graph, i, edges);
+	}
+
+	//a component that is a simple cycle has no core node yet, so its first node becomes one
+	for (node_index_t node = 0; node < graph.size(); ++node)
+	{
+		if ( (NoCoreNode != _coreIndices[node]) || (NoChain != _chainIndices[node]) ) continue;
+		_coreIndices[node] = static_cast<unsigned int>(_nodes.size());
+		_nodes.push_back(node);
+		addEdges(graph, _coreIndices[node], edges);
+	}
+
+	//arrange the edges by node
+	const size_t coreSize = _nodes.size();
+	_offsets.assign(coreSize + 1, 0);
+	compact_distance_t maxWeight = 1;
+	for (vector<Edge>::const_iterator it = edges.cbegin(); it != edges.cend(); ++it)
+	{
+		++_offsets[it->from + 1];
+		maxWeight = max(maxWeight, it->weight);
+	}
+	for (size_t i = 0; i < coreSize; ++i) _offsets[i + 1] += _offsets[i];
+	_neighbors.resize(edges.size());
+	_weights.resize(edges.size());
+	_edgeChains.resize(edges.size());
+	vector<size_t> positions(_offsets.cbegin(), _offsets.cend() - 1);
+	for (vector<Edge>::const_iterator it = edges.cbegin(); it != edges.cend(); ++it)
+	{
+		const size_t position = positions[it->from]++;
+		_neighbors[position] = it->to;
+		_weights[position] = it->weight;
+		_edgeChains[position] = it->chain;
+	}
+
+	_reached.assign(coreSize, 0);
+	_settled.assign(coreSize, 0);
+	_distances.assign(coreSize, 0);
+	_parents.assign(coreSize, static_cast<unsigned int>(NoCoreNode));
+	_parentEdges.assign(coreSize, 0);
+	//a node is only pushed up to maxWeight ahead of the current distance, so that many buckets (and one more) never collide
+	_buckets.resize(maxWeight + 1);
+
+	//the shortest cycle through a chain closes it with the shortest path between its ends that avoids it
+	for (size_t i = 0; i < _chains.size(); ++i)
+	{
+		Chain& chain = _chains[i];
+		if (chain.first == chain.second)
+		{
+			chain.cycleLength = chain.length;
+			continue;
+		}
+
+		const compact_distance_t distance = runCore(chain.first, static_cast<unsigned int>(i), chain.second);
+		if ( (CompactInfiniteDistance != distance) && (static_cast<unsigned int>(chain.length) + distance < CompactInfiniteDistance) )
+		{
+			chain.cycleLength = static_cast<compact_distance_t>(chain.length + distance);
+		}
+	}
+}
+
+ChainCore::~ChainCore()
+{
+	//empty on purpose
+}
+
+size_t ChainCore::size() const
+{
+	return _nodes.size();
+}
+
+node_index_t ChainCore::getNode(unsigned int coreIndex) const
+{
+	return _nodes[coreIndex];
+}
+
+size_t ChainCore::chainCount() const
+{
+	return _chains.size();
+}
+
+const ChainCore::Chain& ChainCore::getChain(size_t chain) const
+{
+	return _chains[chain];
+}
+
+void ChainCore::addEdges(const CompactGraph& graph, unsigned int coreIndex, vector<Edge>& edges)
+{
+	const node_index_t origin = _nodes[coreIndex];
+	for (const unsigned int* next = graph.neighborsBegin(origin); next != graph.neighborsEnd(origin); ++next)
+	{
+		if (NoCoreNode != _coreIndices[*next])
+		{
+			Edge edge = { coreIndex, _coreIndices[*next], 1, NoChain };
+			edges.push_back(edge);
+		}
+		else if (NoChain == _chainIndices[*next])
+		{
+			addChain(graph, origin, *next, edges);
+		}
+	}
+}
+
+void ChainCore::addChain(const CompactGraph& graph, node_index_t origin, node_index_t next, vector<Edge>& edges)
+{
+	const unsigned int chainIndex = static_cast<unsigned int>(_chains.size());
+	Chain chain;
+	chain.first = _coreIndices[origin];
+	chain.nodesBegin = _chainNodes.size();
+	chain.cycleLength = 0;
+
+	node_index_t prev = origin;
+	node_index_t cur = next;
+	unsigned int length = 1;
+	while (NoCoreNode == _coreIndices[cur])
+	{
+		if (length >= CompactInfiniteDistance - 1) throw overflow_error("Chain is too long for compact distances");
+		_chainIndices[cur] = chainIndex;
+		_chainNodes.push_back(cur);
+
+		const unsigned int* neighbors = graph.neighborsBegin(cur);
+		const node_index_t tmp = cur;
+		cur = (neighbors[0] == prev ? neighbors[1] : neighbors[0]);
+		prev = tmp;
+		++length;
+	}
+
+	chain.second = _coreIndices[cur];
+	chain.length = static_cast<compact_distance_t>(length);
+	chain.nodesEnd = _chainNodes.size();
+	_chains.push_back(chain);
+
+	//a chain closing a cycle by itself is never on a shortest path
+	if (chain.first == chain.second) return;
+	Edge forward = { chain.first, chain.second, chain.length, chainIndex };
+	Edge backward = { chain.second, chain.first, chain.length, chainIndex };
+	edges.push_back(forward);
+	edges.push_back(backward);
+}
+
+compact_distance_t ChainCore::runCore(unsigned int source, unsigned int excludedChain, unsigned int target)
+{
+	//a new generation marks every node as unreached, the buffers are only cleared once the count wraps around
+	if (0 == ++_generation)
+	{
+		fill(_reached.begin(), _reached.end(), 0);
+		fill(_settled.begin(), _settled.end(), 0);
+		_generation = 1;
+	}
+	_queued = 0;
+
+	compact_distance_t current = 0;
+	relax(source, 0, NoCoreNode, 0);
+
+	//the buckets are visited by increasing distance - a node may be queued more than once, only its first (shortest) entry counts
+	compact_distance_t result = CompactInfiniteDistance;
+	while ( (_queued > 0) && (CompactInfiniteDistance == result) )
+	{
+		vector<unsigned int>& bucket = _buckets[current % _buckets.size()];
+		for (size_t i = 0; i < bucket.size(); ++i)
+		{
+			--_queued;
+			const unsigned int u = bucket[i];
+			if ( (_generation == _settled[u]) || (_distances[u] != current) ) continue;
+			_settled[u] = _generation;
+			if (u == target)
+			{
+				result = current;
+				break;
+			}
+
+			for (size_t edge = _offsets[u]; edge < _offsets[u + 1]; ++edge)
+			{
+				if (_edgeChains[edge] == excludedChain) continue;
+				const unsigned int w = _neighbors[edge];
+				if (_generation != _settled[w]) relax(w, current + _weights[edge], u, edge);
+			}
+		}
+		bucket.clear();
+		++current;
+	}
+
+	//the search may end with nodes still queued
+	for (vector<size_t>::const_iterator it = _usedBuckets.cbegin(); it != _usedBuckets.cend(); ++it)
+	{
+		_buckets[*it].clear();
+	}
+	_usedBuckets.clear();
+	return result;
+}
+
+void ChainCore::relax(unsigned int coreIndex, unsigned int distance, unsigned int parent, size_t parentEdge)
+{
+	if ( (_generation == _reached[coreIndex]) && (_distances[coreIndex] <= distance) ) return;
+	if (distance >= CompactInfiniteDistance) throw overflow_error("Distance is too large for compact distances");
+
+	_reached[coreIndex] = _generation;
+	_distances[coreIndex] = static_cast<compact_distance_t>(distance);
+	_parents[coreIndex] = parent;
+	_parentEdges[coreIndex] = parentEdge;
+
+	const size_t bucket = distance % _buckets.size();
+	if (_buckets[bucket].empty()) _usedBuckets.push_back(bucket);
+	_buckets[bucket].push_back(coreIndex);
+	++_queued;
+}
+
+vector<node_index_t> ChainCore::getCycle(size_t chain)
+{
+	vector<node_index_t> cycle;
+	const Chain& cur = _chains[chain];
+	if (0 == cur.cycleLength) return cycle;
+
+	cycle.push_back(_nodes[cur.first]);
+	cycle.insert(cycle.end(), _chainNodes.cbegin() + cur.nodesBegin, _chainNodes.cbegin() + cur.nodesEnd);
+	if (cur.first == cur.second) return cycle;
+
+	//walk back from the second end to the first along the shortest path avoiding the chain, expanding the chains it goes through
+	runCore(cur.first, static_cast<unsigned int>(chain), cur.second);
+	for (unsigned int node = cur.second; node != cur.first; node = _parents[node])
+	{
+		cycle.push_back(_nodes[node]);
+		const unsigned int edgeChain = _edgeChains[_parentEdges[node]];
+		if (NoChain == edgeChain) continue;
+
+		//the path goes from the parent to the node, so the chain is walked backwards
+		const Chain& pathChain = _chains[edgeChain];
+		if (pathChain.first == _parents[node])
+		{
+			cycle.insert(cycle.end(), _chainNodes.crbegin() + (_chainNodes.size() - pathChain.nodesEnd), _chainNodes.crbegin() + (_chainNodes.size() - pathChain.nodesBegin));
+		}
+		else
+		{
+			cycle.insert(cycle.end(), _chainNodes.cbegin() + pathChain.nodesBegin, _chainNodes.cbegin() + pathChain.nodesEnd);
+		}
+	}
+	return cycle;
+}
+
+compact_graph_ptr_t ChainCore::createCoreGraph() const
+{
+	vector<pair<node_index_t, node_index_t>> edges;
+	edges.reserve(_neighbors.size());
+	for (unsigned int i = 0; i < _nodes.size(); ++i)
+	{
+		for (size_t position = _offsets[i]; position < _offsets[i + 1]; ++position)
+		{
+			edges.push_back(make_pair(static_cast<node_index_t>(i), static_cast<node_index_t>(_neighbors[position])));
+		}
+	}
+	return make_shared<CompactGraph>(_nodes.size(), edges, _weights);
+}
+
+} // namespace hyperbolicity
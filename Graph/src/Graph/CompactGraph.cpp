@@ -0,0 +1,103 @@
+#include "CompactGraph.h"
+#include "Graph.h"
+#include "Node.h"
+#include <stdexcept>
+#include <algorithm>
+
+using namespace std;
+
+namespace hyperbolicity
+{
+
+CompactGraph::CompactGraph(const graph_ptr_t graph) : _maxWeight(1)
+{
+	if (nullptr == graph.get()) throw std::invalid_argument("Graph pointer is invalid");
+
+	_offsets.resize(graph->size() + 1, 0);
+	_neighbors.reserve(graph->edgeCount());
+	for (node_index_t i = 0; i < graph->size(); ++i)
+	{
+		_offsets[i] = _neighbors.size();
+		const node_weak_ptr_collection_t& edges = graph->getNode(i)->getEdges();
+		for (node_weak_ptr_collection_t::const_iterator it = edges.cbegin(); it != edges.cend(); ++it)
+		{
+			_neighbors.push_back(static_cast<unsigned int>(it->lock()->getIndex()));
+		}
+	}
+	_offsets[graph->size()] = _neighbors.size();
+}
+
+CompactGraph::CompactGraph(size_t nodeCount, const vector<pair<node_index_t, node_index_t>>& edges,
+						   const vector<compact_distance_t>& weights /* = vector<compact_distance_t>() */) :
+	_offsets(nodeCount + 1, 0), _neighbors(edges.size()), _weights(weights.size()), _maxWeight(1)
+{
+	if ( !weights.empty() && (weights.size() != edges.size()) ) throw std::invalid_argument("Edge weights do not match the edges");
+	for (vector<compact_distance_t>::const_iterator it = weights.cbegin(); it != weights.cend(); ++it)
+	{
+		if (0 == *it) throw std::invalid_argument("Edge weight is not positive");
+		_maxWeight = max(_maxWeight, *it);
+	}
+
+	//count the edges of every node, then place each edge at its node's next free position
+	for (vector<pair<node_index_t, node_index_t>>::const_iterator it = edges.cbegin(); it != edges.cend(); ++it)
+	{
+		if ( (it->first >= nodeCount) || (it->second >= nodeCount) ) throw std::invalid_argument("Edge end is out of range");
+		++_offsets[it->first + 1];
+	}
+	for (size_t i = 0; i < nodeCount; ++i) _offsets[i + 1] += _offsets[i];
+
+	vector<size_t> positions(_offsets.cbegin(), _offsets.cend() - 1);
+	for (size_t i = 0; i < edges.size(); ++i)
+	{
+		const size_t position = positions[edges[i].first]++;
+		_neighbors[position] = static_cast<unsigned int>(edges[i].second);
+		if (!weights.empty()) _weights[position] = weights[i];
+	}
+}
+
+CompactGraph::~CompactGraph()
+{
+	//empty on purpose
+}
+
+size_t CompactGraph::size() const
+{
+	return _offsets.size() - 1;
+}
+
+size_t CompactGraph::edgeCount() const
+{
+	return _neighbors.size();
+}
+
+size_t CompactGraph::degree(node_index_t index) const
+{
+	return _offsets[index + 1] - _offsets[index];
+}
+
+const unsigned int* CompactGraph::neighborsBegin(node_index_t index) const
+{
+	return _neighbors.data() + _offsets[index];
+}
+
+const unsigned int* CompactGraph::neighborsEnd(node_index_t index) const
+{
+	return _neighbors.data() + _offsets[index + 1];
+}
+
+bool CompactGraph::isWeighted() const
+{
+	return !_weights.empty();
+}
+
+const compact_distance_t* CompactGraph::weightsBegin(node_index_t index) const
+{
+	return (_weights.empty() ? nullptr : _weights.data() + _offsets[index]);
+}
+
+compact_distance_t CompactGraph::maxWeight() const
+{
+	return _maxWeight;
+}
+
+} // namespace hyperbolicity
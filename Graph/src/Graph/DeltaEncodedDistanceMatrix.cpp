@@ -0,0 +1,266 @@
+#include "DeltaEncodedDistanceMatrix.h"
+#include "MultiSourceBFS.h"
+#include <emmintrin.h>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+namespace hyperbolicity
+{
+
+namespace
+{
+	//number of entries covered by 16 bytes of codes
+	const size_t EntriesPerCodeBlock = 64;
+
+	/*
+	 * @brief	Adds 16 decoded codes (one per byte, 0..2) minus 1 to 16 consecutive entries of the parent row.
+	 */
+	inline void applyCodes(__m128i codes, const compact_distance_t* parentRow, compact_distance_t* row)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i one = _mm_set1_epi16(1);
+		__m128i low = _mm_sub_epi16(_mm_unpacklo_epi8(codes, zero), one);
+		__m128i high = _mm_sub_epi16(_mm_unpackhi_epi8(codes, zero), one);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(row), _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(parentRow)), low));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(row + 8), _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(parentRow + 8)), high));
+	}
+
+	/*
+	 * @brief	Decodes a row from its parent's row and its codes. Unreachable entries stay CompactInfiniteDistance, as their code is always 0 difference.
+	 */
+	void decodeRow(const unsigned char* codes, const compact_distance_t* parentRow, compact_distance_t* row, size_t paddedSize)
+	{
+		const __m128i mask = _mm_set1_epi8(3);
+		for (size_t c = 0; c < paddedSize; c += EntriesPerCodeBlock, codes += 16)
+		{
+			__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes));
+			applyCodes(_mm_and_si128(block, mask), parentRow + c, row + c);
+			applyCodes(_mm_and_si128(_mm_srli_epi16(block, 2), mask), parentRow + c + 16, row + c + 16);
+			applyCodes(_mm_and_si128(_mm_srli_epi16(block, 4), mask), parentRow + c + 32, row + c + 32);
+			applyCodes(_mm_and_si128(_mm_srli_epi16(block, 6), mask), parentRow + c + 48, row + c + 48);
+		}
+	}
+}
+
+DeltaEncodedDistanceMatrix::DeltaEncodedDistanceMatrix(const CompactGraph& graph, unsigned long long memoryBudget,
+													   const progress_callback_t& progress /* = progress_callback_t() */) :
+	_size(graph.size()), _paddedSize((graph.size() + EntriesPerCodeBlock - 1) / EntriesPerCodeBlock * EntriesPerCodeBlock), _maxDistance(0)
+{
+	if (graph.isWeighted()) throw std::invalid_argument("Weighted graphs cannot be delta encoded");
+	vector<node_index_t> order = buildForest(graph);
+	encode(graph, order, progress);
+
+	//whatever is left of the budget goes to the cache
+	unsigned long long rowBytes = _paddedSize * sizeof(compact_distance_t);
+	unsigned long long used = _codes.size() + _rootRows.size() * rowBytes;
+	size_t maxCachedRows = max(MinCachedRows, static_cast<size_t>(memoryBudget > used ? (memoryBudget - used) / rowBytes : 0));
+	_maxCachedRowsPerShard = max(static_cast<size_t>(1), maxCachedRows / CacheShardCount);
+}
+
+DeltaEncodedDistanceMatrix::~DeltaEncodedDistanceMatrix()
+{
+	//empty on purpose
+}
+
+size_t DeltaEncodedDistanceMatrix::size() const
+{
+	return _size;
+}
+
+compact_distance_t DeltaEncodedDistanceMatrix::getDistance(node_index_t u, node_index_t v) const
+{
+	row_ptr_t row = findRow(v);
+	if (nullptr != row.get()) return (*row)[u];
+	row = findRow(u);
+	if (nullptr != row.get()) return (*row)[v];
+
+	//sum the differences along the way up from u to its root - the codes & the root rows never change, so no lock is needed
+	int difference = 0;
+	while (_parent[u] != u)
+	{
+		difference += static_cast<int>(getCode(u, v)) - 1;
+		u = _parent[u];
+	}
+
+	const row_t& rootRow = *_rootRows.find(u)->second;
+	if (CompactInfiniteDistance == rootRow[v]) return CompactInfiniteDistance;
+	return static_cast<compact_distance_t>(rootRow[v] + difference);
+}
+
+void DeltaEncodedDistanceMatrix::getRow(node_index_t u, compact_distance_t* row) const
+{
+	row_ptr_t decoded = getDecodedRow(u);
+	copy(decoded->cbegin(), decoded->cbegin() + _size, row);
+}
+
+compact_distance_t DeltaEncodedDistanceMatrix::getMaxDistance() const
+{
+	return _maxDistance;
+}
+
+unsigned long long DeltaEncodedDistanceMatrix::getEncodedSize(size_t nodeCount)
+{
+	unsigned long long paddedSize = (nodeCount + EntriesPerCodeBlock - 1) / EntriesPerCodeBlock * EntriesPerCodeBlock;
+	//the codes, plus a single explicit row for the root
+	return nodeCount * paddedSize / 4 + paddedSize * sizeof(compact_distance_t);
+}
+
+vector<node_index_t> DeltaEncodedDistanceMatrix::buildForest(const CompactGraph& graph)
+{
+	const node_index_t NoParent = static_cast<node_index_t>(-1);
+	_parent.assign(_size, NoParent);
+	vector<node_index_t> order;
+	order.reserve(_size);
+
+	for (node_index_t root = 0; root < _size; ++root)
+	{
+		if (NoParent != _parent[root]) continue;
+
+		//a new component - its root's row is kept explicitly
+		_parent[root] = root;
+		_rootRows[root] = make_shared<row_t>(_paddedSize, CompactInfiniteDistance);
+		size_t next = order.size();
+		order.push_back(root);
+		while (next < order.size())
+		{
+			node_index_t u = order[next++];
+			for (const unsigned int* w = graph.neighborsBegin(u); w != graph.neighborsEnd(u); ++w)
+			{
+				if (NoParent != _parent[*w]) continue;
+				_parent[*w] = u;
+				order.push_back(*w);
+			}
+		}
+	}
+
+	return order;
+}
+
+void DeltaEncodedDistanceMatrix::encode(const CompactGraph& graph, const vector<node_index_t>& order, const progress_callback_t& progress)
+{
+	//every code starts as no difference, which is also what the padding entries keep
+	const size_t rowBytes = _paddedSize / 4;
+	_codes.assign(_size * rowBytes, 0x55);
+
+	MultiSourceBFS bfs(graph);
+	vector<compact_distance_t> rows(MultiSourceBFS::MaxSources * _size);
+	node_index_t sources[MultiSourceBFS::MaxSources];
+	compact_distance_t* rowPointers[MultiSourceBFS::MaxSources];
+	for (size_t k = 0; k < MultiSourceBFS::MaxSources; ++k) rowPointers[k] = &rows[k * _size];
+
+	//each node's row is encoded against its parent's, so every batch also computes the parents of the nodes it encodes
+	size_t next = 0;
+	while (next < order.size())
+	{
+		size_t sourceCount = 0;
+		vector<pair<size_t, size_t>> encoded;
+		while ( (next < order.size()) && (sourceCount + 2 <= MultiSourceBFS::MaxSources) )
+		{
+			//the node may already be in the batch, as the parent of an earlier one
+			node_index_t u = order[next++];
+			size_t uSlot = find(sources, sources + sourceCount, u) - sources;
+			if (uSlot == sourceCount) sources[sourceCount++] = u;
+			if (_parent[u] == u) continue;
+
+			size_t parentSlot = find(sources, sources + sourceCount, _parent[u]) - sources;
+			if (parentSlot == sourceCount) sources[sourceCount++] = _parent[u];
+			encoded.push_back(make_pair(uSlot, parentSlot));
+		}
+		bfs.run(sources, sourceCount, rowPointers);
+
+		for (size_t k = 0; k < sourceCount * _size; ++k)
+		{
+			if (rows[k] != CompactInfiniteDistance && rows[k] > _maxDistance) _maxDistance = rows[k];
+		}
+
+		for (size_t k = 0; k < sourceCount; ++k)
+		{
+			unordered_map<node_index_t, shared_ptr<row_t>>::iterator rootRow = _rootRows.find(sources[k]);
+			if (rootRow != _rootRows.end()) copy(rowPointers[k], rowPointers[k] + _size, rootRow->second->begin());
+		}
+
+		for (vector<pair<size_t, size_t>>::const_iterator it = encoded.cbegin(); it != encoded.cend(); ++it)
+		{
+			const compact_distance_t* row = rowPointers[it->first];
+			const compact_distance_t* parentRow = rowPointers[it->second];
+			unsigned char* codes = &_codes[sources[it->first] * rowBytes];
+			for (node_index_t x = 0; x < _size; ++x)
+			{
+				//unreachable from both (a different component) is kept as no difference
+				int difference = (CompactInfiniteDistance == row[x] ? 0 : static_cast<int>(row[x]) - static_cast<int>(parentRow[x]));
+				size_t position = x % EntriesPerCodeBlock;
+				unsigned char& byte = codes[x / EntriesPerCodeBlock * 16 + position % 16];
+				const unsigned int shift = 2 * (position / 16);
+				byte = static_cast<unsigned char>( (byte & ~(3 << shift)) | ((difference + 1) << shift) );
+			}
+		}
+
+		if (progress && !progress(static_cast<double>(next) / order.size())) return;
+	}
+}
+
+unsigned int DeltaEncodedDistanceMatrix::getCode(node_index_t u, node_index_t x) const
+{
+	size_t position = x % EntriesPerCodeBlock;
+	unsigned char byte = _codes[u * (_paddedSize / 4) + x / EntriesPerCodeBlock * 16 + position % 16];
+	return (byte >> (2 * (position / 16))) & 3;
+}
+
+DeltaEncodedDistanceMatrix::row_ptr_t DeltaEncodedDistanceMatrix::findRow(node_index_t u) const
+{
+	if (_parent[u] == u) return _rootRows.find(u)->second;
+
+	CacheShard& shard = _shards[u % CacheShardCount];
+	lock_guard<mutex> lock(shard.mutex);
+	unordered_map<node_index_t, row_cache_t::iterator>::iterator position = shard.positions.find(u);
+	if (position == shard.positions.end()) return row_ptr_t();
+
+	//move to the front of the LRU list
+	shard.cache.splice(shard.cache.begin(), shard.cache, position->second);
+	return shard.cache.front().second;
+}
+
+void DeltaEncodedDistanceMatrix::cacheRow(node_index_t u, const row_ptr_t& row) const
+{
+	CacheShard& shard = _shards[u % CacheShardCount];
+	lock_guard<mutex> lock(shard.mutex);
+
+	//another thread may have decoded it meanwhile
+	if (shard.positions.find(u) != shard.positions.end()) return;
+
+	//whoever still uses an evicted row keeps its own reference
+	if (shard.cache.size() >= _maxCachedRowsPerShard)
+	{
+		shard.positions.erase(shard.cache.back().first);
+		shard.cache.pop_back();
+	}
+	shard.cache.push_front(make_pair(u, row));
+	shard.positions[u] = shard.cache.begin();
+}
+
+DeltaEncodedDistanceMatrix::row_ptr_t DeltaEncodedDistanceMatrix::getDecodedRow(node_index_t u) const
+{
+	//walk up to the nearest available row
+	vector<node_index_t> path;
+	row_ptr_t row;
+	while (nullptr == (row = findRow(u)).get())
+	{
+		path.push_back(u);
+		u = _parent[u];
+	}
+
+	//and decode the rows back down, caching each of them
+	for (vector<node_index_t>::const_reverse_iterator it = path.crbegin(); it != path.crend(); ++it)
+	{
+		shared_ptr<row_t> decoded = make_shared<row_t>(_paddedSize);
+		decodeRow(&_codes[*it * (_paddedSize / 4)], row->data(), decoded->data(), _paddedSize);
+		row = decoded;
+		cacheRow(*it, row);
+	}
+
+	return row;
+}
+
+} // namespace hyperbolicity
@@ -0,0 +1,113 @@
+#include "DistanceMatrix.h"
+#include "DeltaEncodedDistanceMatrix.h"
+#include "TiledDistanceMatrix.h"
+#include "MultiSourceBFS.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace hyperbolicity
+{
+
+DenseDistanceMatrix::DenseDistanceMatrix(const CompactGraph& graph, const progress_callback_t& progress /* = progress_callback_t() */) : _size(graph.size()), _maxDistance(0)
+{
+	//the rows are added a batch at a time (without moving - the room is reserved), so that the first batch is not held up by filling
+	//the whole matrix
+	_distances.reserve(_size * _size);
+	MultiSourceBFS bfs(graph);
+	node_index_t sources[MultiSourceBFS::MaxSources];
+	compact_distance_t* rows[MultiSourceBFS::MaxSources];
+	for (node_index_t first = 0; first < _size; first += MultiSourceBFS::MaxSources)
+	{
+		size_t count = min(MultiSourceBFS::MaxSources, _size - first);
+		_distances.resize((first + count) * _size);
+		for (size_t i = 0; i < count; ++i)
+		{
+			sources[i] = first + i;
+			rows[i] = &_distances[(first + i) * _size];
+		}
+		bfs.run(sources, count, rows);
+		if (progress && !progress(static_cast<double>(first + count) / _size)) return;
+	}
+
+	for (vector<compact_distance_t>::const_iterator it = _distances.cbegin(); it != _distances.cend(); ++it)
+	{
+		if (*it != CompactInfiniteDistance && *it > _maxDistance) _maxDistance = *it;
+	}
+}
+
+DenseDistanceMatrix::~DenseDistanceMatrix()
+{
+	//empty on purpose
+}
+
+size_t DenseDistanceMatrix::size() const
+{
+	return _size;
+}
+
+compact_distance_t DenseDistanceMatrix::getDistance(node_index_t u, node_index_t v) const
+{
+	return _distances[u * _size + v];
+}
+
+void DenseDistanceMatrix::getRow(node_index_t u, compact_distance_t* row) const
+{
+	copy(_distances.cbegin() + u * _size, _distances.cbegin() + (u + 1) * _size, row);
+}
+
+compact_distance_t DenseDistanceMatrix::getMaxDistance() const
+{
+	return _maxDistance;
+}
+
+const compact_distance_t* DenseDistanceMatrix::row(node_index_t u) const
+{
+	return &_distances[u * _size];
+}
+
+distance_matrix_ptr_t DistanceMatrixFactory::create(const graph_ptr_t graph, unsigned long long memoryBudget /* = DefaultMemoryBudget */,
+													 const progress_callback_t& progress /* = progress_callback_t() */,
+													 bool shouldMarkFarApartPairs /* = false */)
+{
+	CompactGraph compactGraph(graph);
+	return create(compactGraph, memoryBudget, progress, shouldMarkFarApartPairs);
+}
+
+distance_matrix_ptr_t DistanceMatrixFactory::create(const CompactGraph& graph, unsigned long long memoryBudget /* = DefaultMemoryBudget */,
+													 const progress_callback_t& progress /* = progress_callback_t() */,
+													 bool shouldMarkFarApartPairs /* = false */)
+{
+	//remember whether the computation was stopped, as the matrices cannot tell
+	bool isStopped = false;
+	progress_callback_t trackedProgress;
+	if (progress)
+	{
+		trackedProgress = [&progress, &isStopped](double fraction) -> bool
+		{
+			isStopped = !progress(fraction);
+			return !isStopped;
+		};
+	}
+
+	distance_matrix_ptr_t matrix;
+	unsigned long long denseBytes = static_cast<unsigned long long>(graph.size()) * graph.size() * sizeof(compact_distance_t);
+	//the delta encoding must leave room for at least a few decoded rows
+	unsigned long long rowBytes = static_cast<unsigned long long>(graph.size()) * sizeof(compact_distance_t);
+	if (denseBytes <= memoryBudget)
+	{
+		matrix = distance_matrix_ptr_t(new DenseDistanceMatrix(graph, trackedProgress));
+	}
+	else if ( !graph.isWeighted() && (DeltaEncodedDistanceMatrix::getEncodedSize(graph.size()) + DeltaEncodedDistanceMatrix::MinCachedRows * rowBytes <= memoryBudget) )
+	{
+		matrix = distance_matrix_ptr_t(new DeltaEncodedDistanceMatrix(graph, memoryBudget, trackedProgress));
+	}
+	else
+	{
+		matrix = distance_matrix_ptr_t(new TiledDistanceMatrix(graph, memoryBudget, trackedProgress, shouldMarkFarApartPairs));
+	}
+
+	return (isStopped ? distance_matrix_ptr_t() : matrix);
+}
+
+} // namespace hyperbolicity
@@ -0,0 +1,196 @@
+#include "DynamicDistances.h"
+#include "Graph.h"
+#include "Node.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace hyperbolicity
+{
+
+const node_index_t DynamicDistances::DeletedNode;
+
+DynamicDistances::DynamicDistances(const graph_ptr_t graph) : _graph(graph), _recomputedRowCount(0), _remappedRowCount(0)
+{
+	takeSnapshot();
+}
+
+DynamicDistances::~DynamicDistances()
+{
+	//empty on purpose
+}
+
+const vector<compact_distance_t>& DynamicDistances::getRow(node_index_t node)
+{
+	loadRows(&node, 1);
+	return _rows[node];
+}
+
+void DynamicDistances::loadRows(const node_index_t* nodes, size_t count)
+{
+	node_index_t sources[MultiSourceBFS::MaxSources];
+	compact_distance_t* rows[MultiSourceBFS::MaxSources];
+	size_t missing = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		row_t& row = _rows[nodes[i]];
+		if (!row.empty()) continue;
+
+		row.resize(_compactGraph->size());
+		sources[missing] = nodes[i];
+		rows[missing] = row.data();
+		if (++missing == MultiSourceBFS::MaxSources)
+		{
+			_bfs->run(sources, missing, rows);
+			missing = 0;
+		}
+	}
+
+	if (missing > 0) _bfs->run(sources, missing, rows);
+}
+
+bool DynamicDistances::hasRow(node_index_t node) const
+{
+	return (_rows.find(node) != _rows.cend());
+}
+
+void DynamicDistances::removeRow(node_index_t node)
+{
+	_rows.erase(node);
+}
+
+void DynamicDistances::clear()
+{
+	_rows.clear();
+}
+
+const vector<node_index_t>& DynamicDistances::synchronize(bool isDistancePreserving /* = false */)
+{
+	//find where each node went - a node was deleted iff the graph no longer holds it at its index
+	const size_t oldSize = _nodes.size();
+	vector<node_index_t> deleted;
+	_mapping.assign(oldSize, DeletedNode);
+	for (node_index_t i = 0; i < oldSize; ++i)
+	{
+		node_index_t newIndex = _nodes[i]->getIndex();
+		if ( (newIndex < _graph->size()) && (_graph->getNode(newIndex) == _nodes[i]) )
+		{
+			_mapping[i] = newIndex;
+		}
+		else
+		{
+			deleted.push_back(i);
+		}
+	}
+	if (deleted.empty()) return _mapping;
+
+	//keep the rows that were not affected, compacting them in place to the new indices (which never exceed the old ones)
+	unordered_map<node_index_t, row_t> newRows;
+	vector<node_index_t> rowsToRecompute;
+	for (unordered_map<node_index_t, row_t>::iterator it = _rows.begin(); it != _rows.end(); ++it)
+	{
+		if (DeletedNode == _mapping[it->first]) continue;
+
+		if (!isDistancePreserving && isRowAffected(it->second, deleted))
+		{
+			rowsToRecompute.push_back(_mapping[it->first]);
+			++_recomputedRowCount;
+			continue;
+		}
+
+		row_t& row = it->second;
+		for (node_index_t i = 0; i < oldSize; ++i)
+		{
+			if (DeletedNode != _mapping[i]) row[_mapping[i]] = row[i];
+		}
+		row.resize(_graph->size());
+		newRows[_mapping[it->first]].swap(row);
+		++_remappedRowCount;
+	}
+	_rows.swap(newRows);
+
+	takeSnapshot();
+	loadRows(rowsToRecompute.data(), rowsToRecompute.size());
+	return _mapping;
+}
+
+void DynamicDistances::edgeRemoved(node_index_t a, node_index_t b)
+{
+	takeSnapshot();
+
+	//only the farther end of the edge (if the ends are at different distances) may have lost its only parent
+	vector<node_index_t> rowsToRecompute;
+	for (unordered_map<node_index_t, row_t>::const_iterator it = _rows.cbegin(); it != _rows.cend(); ++it)
+	{
+		const row_t& row = it->second;
+		if (row[a] == row[b]) continue;
+
+		node_index_t farther = (row[a] > row[b] ? a : b);
+		if (!hasParent(row, farther)) rowsToRecompute.push_back(it->first);
+	}
+
+	for (vector<node_index_t>::const_iterator it = rowsToRecompute.cbegin(); it != rowsToRecompute.cend(); ++it)
+	{
+		_rows.erase(*it);
+	}
+	_recomputedRowCount += rowsToRecompute.size();
+	_remappedRowCount += _rows.size();
+	loadRows(rowsToRecompute.data(), rowsToRecompute.size());
+}
+
+size_t DynamicDistances::getRecomputedRowCount() const
+{
+	return _recomputedRowCount;
+}
+
+size_t DynamicDistances::getRemappedRowCount() const
+{
+	return _remappedRowCount;
+}
+
+void DynamicDistances::takeSnapshot()
+{
+	_bfs.reset();
+	_compactGraph = compact_graph_ptr_t(new CompactGraph(_graph));
+	_bfs = shared_ptr<MultiSourceBFS>(new MultiSourceBFS(*_compactGraph));
+
+	_nodes.resize(_graph->size());
+	for (node_index_t i = 0; i < _graph->size(); ++i)
+	{
+		_nodes[i] = _graph->getNode(i);
+	}
+}
+
+bool DynamicDistances::isRowAffected(const row_t& row, const vector<node_index_t>& deleted) const
+{
+	for (vector<node_index_t>::const_iterator w = deleted.cbegin(); w != deleted.cend(); ++w)
+	{
+		if (CompactInfiniteDistance == row[*w]) continue;
+
+		//look for remaining neighbors of w that had w as a parent, and see whether they have another (remaining) one
+		for (const unsigned int* y = _compactGraph->neighborsBegin(*w); y != _compactGraph->neighborsEnd(*w); ++y)
+		{
+			if ( (DeletedNode == _mapping[*y]) || (row[*y] != row[*w] + 1) ) continue;
+
+			bool hasRemainingParent = false;
+			for (const unsigned int* p = _compactGraph->neighborsBegin(*y); p != _compactGraph->neighborsEnd(*y) && !hasRemainingParent; ++p)
+			{
+				hasRemainingParent = ( (DeletedNode != _mapping[*p]) && (row[*p] + 1 == row[*y]) );
+			}
+			if (!hasRemainingParent) return true;
+		}
+	}
+
+	return false;
+}
+
+bool DynamicDistances::hasParent(const row_t& row, node_index_t node) const
+{
+	for (const unsigned int* p = _compactGraph->neighborsBegin(node); p != _compactGraph->neighborsEnd(node); ++p)
+	{
+		if (row[*p] + 1 == row[node]) return true;
+	}
+	return false;
+}
+
+} // namespace hyperbolicity
@@ -2,6 +2,7 @@
 #include "defs.h"
 #include "FurthestNode.h"
 #include "NodeDistances.h"
+#include "CompactGraph.h"
 #include "boost/format.hpp"
 #include <memory>
 #include <vector>
@@ -55,39 +56,33 @@ namespace hyperbolicity
 		}
 	}
 
-	graph_ptr_t GraphAlgorithms::LoadGraphFromFile(const std::string& path)
+	graph_ptr_t GraphAlgorithms::LoadGraphFromFile(const std::string& path, bool shouldPruneTrees /* = false */)
 	{
 		shared_ptr<FILE> inputFile = OpenFile(path.c_str(), "rb", _SH_DENYWR);
-		
-		//create graph
-		graph_ptr_t g(new Graph(shortPath(path)));
-
-		//create graph nodes
 		unsigned int nodeCount = ReadNodeCount(inputFile);
-		for (unsigned int i = 0; i < nodeCount; ++i) g->insertNode();
-
-		//create edges
 		vector<Edge> edges = ReadEdges(inputFile);
+
+		vector<pair<node_index_t, node_index_t>> edgePairs;
+		edgePairs.reserve(edges.size());
 		for (vector<Edge>::const_iterator it = edges.cbegin(); it != edges.end(); ++it)
 		{
-			node_ptr_t src = g->getNode(it->src);
-			src->insertUnidirectionalEdgeTo(g->getNode(it->dst));
+			edgePairs.push_back(pair<node_index_t, node_index_t>(it->src, it->dst));
 		}
+		vector<Edge>().swap(edges);
 
-		return g;
+		return createGraph(shortPath(path), nodeCount, edgePairs, shouldPruneTrees);
 	}
 
-	graph_ptr_t GraphAlgorithms::LoadGraphFromEdgeListFile(const std::string& path, bool isBidirectional)
+	graph_ptr_t GraphAlgorithms::LoadGraphFromEdgeListFile(const std::string& path, bool isBidirectional, bool shouldPruneTrees /* = false */)
 	{
-		//create graph
-		graph_ptr_t g(new Graph(shortPath(path)));
-
 		//start reading from file
 		ifstream inputFile;
 		inputFile.exceptions(ios::badbit);
 		inputFile.open(path.c_str());
 
+		//nodes are numbered by order of appearance
 		unordered_map<node_index_t,node_index_t> addedNodes;
+		vector<pair<node_index_t, node_index_t>> edges;
 		string line;
 		while (!inputFile.eof())
 		{
@@ -104,40 +99,103 @@ namespace hyperbolicity
 			node_index_t node1Index = atoi(line.c_str());
 			node_index_t node2Index = atoi(line.c_str() + tabIndex + 1);
 
-			//get node pointers (either from graph if already added before, or create and get the new node pointers)
-			node_ptr_t node1,node2;
-			if (addedNodes.cend() == addedNodes.find(node1Index))
-			{
-				node1 = g->insertNode();
-				addedNodes[node1Index] = node1->getIndex();
-			}
-			else
-			{
-				node1 = g->getNode(addedNodes[node1Index]);
-			}
+			//get node indices (either added before, or the next ones)
+			const node_index_t node1 = addedNodes.insert(make_pair(node1Index, addedNodes.size())).first->second;
+			const node_index_t node2 = addedNodes.insert(make_pair(node2Index, addedNodes.size())).first->second;
+
+			//add edge(s)
+			edges.push_back(pair<node_index_t, node_index_t>(node1, node2));
+			if (isBidirectional) edges.push_back(pair<node_index_t, node_index_t>(node2, node1));
+		}
 
-			if (addedNodes.cend() == addedNodes.find(node2Index))
+		return createGraph(shortPath(path), addedNodes.size(), edges, shouldPruneTrees);
+	}
+
+	graph_ptr_t GraphAlgorithms::createGraph(const string& title, size_t nodeCount, const vector<pair<node_index_t, node_index_t>>& edges, bool shouldPruneTrees)
+	{
+		graph_ptr_t g(new Graph(title));
+		if (!shouldPruneTrees)
+		{
+			for (size_t i = 0; i < nodeCount; ++i) g->insertNode();
+			for (vector<pair<node_index_t, node_index_t>>::const_iterator it = edges.cbegin(); it != edges.cend(); ++it)
 			{
-				node2 = g->insertNode();
-				addedNodes[node2Index] = node2->getIndex();
+				g->getNode(it->first)->insertUnidirectionalEdgeTo(g->getNode(it->second));
 			}
-			else
+			return g;
+		}
+
+		//only the 2-core's nodes are created, labeled by their index in the full graph
+		vector<node_index_t> core = getTwoCore(CompactGraph(nodeCount, edges));
+		vector<node_index_t> newIndices(nodeCount, nodeCount);
+		for (vector<node_index_t>::const_iterator it = core.cbegin(); it != core.cend(); ++it)
+		{
+			newIndices[*it] = g->insertNode((boost::format("%1%") % *it).str())->getIndex();
+		}
+		for (vector<pair<node_index_t, node_index_t>>::const_iterator it = edges.cbegin(); it != edges.cend(); ++it)
+		{
+			if ( (nodeCount == newIndices[it->first]) || (nodeCount == newIndices[it->second]) ) continue;
+			g->getNode(newIndices[it->first])->insertUnidirectionalEdgeTo(g->getNode(newIndices[it->second]));
+		}
+		return g;
+	}
+
+	vector<node_index_t> GraphAlgorithms::getTwoCore(const CompactGraph& graph)
+	{
+		const size_t n = graph.size();
+
+		//the number of neighbors of every node not yet peeled (it keeps decreasing once the node is peeled, which is harmless), and whether
+		//it was peeled
+		vector<int> degrees(n);
+		vector<char> isPeeled(n, 0);
+		vector<node_index_t> level;
+		for (node_index_t v = 0; v < n; ++v)
+		{
+			degrees[v] = static_cast<int>(graph.degree(v));
+			if (graph.degree(v) > 1) continue;
+			isPeeled[v] = 1;
+			level.push_back(v);
+		}
+
+		//peel a level at a time - a neighbor joins the next level by the one decrement that takes its count from 2 to 1
+		vector<node_index_t> next;
+		while (!level.empty())
+		{
+			next.clear();
+			for (vector<node_index_t>::const_iterator u = level.cbegin(); u != level.cend(); ++u)
 			{
-				node2 = g->getNode(addedNodes[node2Index]);
+				for (const unsigned int* w = graph.neighborsBegin(*u); w != graph.neighborsEnd(*u); ++w)
+				{
+					if (2 != degrees[*w]--) continue;
+					isPeeled[*w] = 1;
+					next.push_back(*w);
+				}
 			}
+			level.swap(next);
+		}
 
-			//add edge(s)
-			if (isBidirectional)
+		vector<node_index_t> core;
+		for (node_index_t v = 0; v < n; ++v)
+		{
+			if (!isPeeled[v]) core.push_back(v);
+		}
+		return core;
+	}
+
+	bool GraphAlgorithms::isFarthestAmongNeighbors(const CompactGraph& graph, const compact_distance_t* row, node_index_t v)
+	{
+		const compact_distance_t* weight = graph.weightsBegin(v);
+		for (const unsigned int* w = graph.neighborsBegin(v); w != graph.neighborsEnd(v); ++w)
+		{
+			if (nullptr == weight)
 			{
-				node1->insertBidirectionalEdgeTo(node2);
+				if (row[*w] > row[v]) return false;
 			}
-			else
+			else if (row[*w] == row[v] + *weight++)
 			{
-				node1->insertUnidirectionalEdgeTo(node2);
+				return false;
 			}
 		}
-
-		return g;
+		return true;
 	}
 
 	graph_ptr_collection_t GraphAlgorithms::getBiconnectedComponents(const graph_ptr_t graph)
@@ -154,6 +212,168 @@ namespace hyperbolicity
 		return biconnectedGraphs;
 	}
 
+	graph_ptr_collection_t GraphAlgorithms::getAtoms(const graph_ptr_t graph)
+	{
+		const size_t n = graph->size();
+		CompactGraph compactGraph(graph);
+
+		//MCS-M - repeatedly number the unnumbered node of highest weight, and increase the weight of every unnumbered node it reaches
+		//through unnumbered nodes of lower weight (such a node is its neighbor in the minimal triangulation). Each node's
+		//earlier-numbered neighbors in the triangulation are kept, and a node whose weight did not increase since the previous
+		//one starts a new clique of the triangulation, i.e. those neighbors are a minimal separator (which is a candidate)
+		vector<unsigned int> weight(n, 0);
+		vector<bool> isNumbered(n, false), isGenerator(n, false);
+		vector<vector<node_index_t>> earlierNeighbors(n);
+		vector<node_index_t> numberingOrder;
+		numberingOrder.reserve(n);
+
+		//reach cost of a node is the lowest possible maximal weight along a path to it (-1 for neighbors), found level by level
+		const int Unreached = INT_MAX;
+		vector<int> cost(n, Unreached);
+		vector<size_t> visitedAt(n, n);
+		vector<vector<node_index_t>> levels(n + 1);
+		vector<node_index_t> reached, touched;
+		int previousWeight = -1;
+		for (size_t i = 0; i < n; ++i)
+		{
+			node_index_t v = n;
+			for (node_index_t u = 0; u < n; ++u)
+			{
+				if (!isNumbered[u] && (n == v || weight[u] > weight[v])) v = u;
+			}
+			isNumbered[v] = true;
+			numberingOrder.push_back(v);
+			if (static_cast<int>(weight[v]) <= previousWeight) isGenerator[v] = true;
+			previousWeight = weight[v];
+
+			for (const unsigned int* u = compactGraph.neighborsBegin(v); u != compactGraph.neighborsEnd(v); ++u)
+			{
+				if (isNumbered[*u]) continue;
+				cost[*u] = -1;
+				touched.push_back(*u);
+				levels[0].push_back(*u);
+			}
+			for (size_t level = 0; level < levels.size(); ++level)
+			{
+				for (size_t k = 0; k < levels[level].size(); ++k)
+				{
+					const node_index_t u = levels[level][k];
+					if ( (cost[u] + 1 != static_cast<int>(level)) || (visitedAt[u] == i) ) continue;
+					visitedAt[u] = i;
+					if (cost[u] < static_cast<int>(weight[u])) reached.push_back(u);
+
+					const int costThroughU = max(cost[u], static_cast<int>(weight[u]));
+					for (const unsigned int* w = compactGraph.neighborsBegin(u); w != compactGraph.neighborsEnd(u); ++w)
+					{
+						if (isNumbered[*w] || cost[*w] <= costThroughU) continue;
+						if (Unreached == cost[*w]) touched.push_back(*w);
+						cost[*w] = costThroughU;
+						levels[costThroughU + 1].push_back(*w);
+					}
+				}
+				levels[level].clear();
+			}
+
+			for (vector<node_index_t>::const_iterator it = reached.cbegin(); it != reached.cend(); ++it)
+			{
+				++weight[*it];
+				earlierNeighbors[*it].push_back(v);
+			}
+			for (vector<node_index_t>::const_iterator it = touched.cbegin(); it != touched.cend(); ++it)
+			{
+				cost[*it] = Unreached;
+			}
+			reached.clear();
+			touched.clear();
+		}
+
+		//go over the candidates from the last numbered - a candidate that is a clique in the graph separates the component of the
+		//remaining graph that holds its node, which together with the separator is an atom
+		graph_ptr_collection_t atoms;
+		vector<bool> isRemoved(n, false);
+		vector<size_t> mark(n, n), separatorMark(n, n);
+		vector<node_index_t> atomNodes;
+		for (vector<node_index_t>::const_reverse_iterator it = numberingOrder.crbegin(); it != numberingOrder.crend(); ++it)
+		{
+			const node_index_t x = *it;
+			if (!isGenerator[x] || isRemoved[x]) continue;
+
+			const vector<node_index_t>& separator = earlierNeighbors[x];
+			bool isClique = true;
+			for (size_t k = 0; isClique && k < separator.size(); ++k)
+			{
+				for (const unsigned int* w = compactGraph.neighborsBegin(separator[k]); w != compactGraph.neighborsEnd(separator[k]); ++w)
+				{
+					mark[*w] = separator[k];
+				}
+				for (size_t j = 0; isClique && j < separator.size(); ++j)
+				{
+					isClique = (j == k || mark[separator[j]] == separator[k]);
+				}
+			}
+			if (!isClique) continue;
+
+			//collect the component of x, without crossing the separator
+			for (vector<node_index_t>::const_iterator s = separator.cbegin(); s != separator.cend(); ++s)
+			{
+				separatorMark[*s] = x;
+			}
+			atomNodes.assign(1, x);
+			isRemoved[x] = true;
+			for (size_t k = 0; k < atomNodes.size(); ++k)
+			{
+				for (const unsigned int* w = compactGraph.neighborsBegin(atomNodes[k]); w != compactGraph.neighborsEnd(atomNodes[k]); ++w)
+				{
+					if (isRemoved[*w] || separatorMark[*w] == x) continue;
+					isRemoved[*w] = true;
+					atomNodes.push_back(*w);
+				}
+			}
+			atomNodes.insert(atomNodes.end(), separator.cbegin(), separator.cend());
+
+			string title = (boost::format("%1%_%2%") % graph->getTitle() % (atoms.size()+1)).str();
+			atoms.push_back(getInducedSubgraph(graph, atomNodes, title));
+		}
+
+		//whatever remains is the last atom
+		atomNodes.clear();
+		for (node_index_t u = 0; u < n; ++u)
+		{
+			if (!isRemoved[u]) atomNodes.push_back(u);
+		}
+		if (!atomNodes.empty())
+		{
+			string title = (boost::format("%1%_%2%") % graph->getTitle() % (atoms.size()+1)).str();
+			atoms.push_back(getInducedSubgraph(graph, atomNodes, title));
+		}
+
+		return atoms;
+	}
+
+	graph_ptr_t GraphAlgorithms::getInducedSubgraph(const graph_ptr_t graph, const vector<node_index_t>& nodes, const string& title)
+	{
+		graph_ptr_t subgraph(new Graph(title));
+		unordered_map<node_index_t, node_ptr_t> indexMap;
+		for (vector<node_index_t>::const_iterator it = nodes.cbegin(); it != nodes.cend(); ++it)
+		{
+			indexMap[*it] = subgraph->insertNode(graph->getNode(*it)->getLabel());
+		}
+
+		//add each edge once, from its lower end
+		for (vector<node_index_t>::const_iterator it = nodes.cbegin(); it != nodes.cend(); ++it)
+		{
+			const node_weak_ptr_collection_t& edges = graph->getNode(*it)->getEdges();
+			for (node_weak_ptr_collection_t::const_iterator edgeIt = edges.cbegin(); edgeIt != edges.cend(); ++edgeIt)
+			{
+				node_index_t w = edgeIt->lock()->getIndex();
+				unordered_map<node_index_t, node_ptr_t>::const_iterator other = indexMap.find(w);
+				if ( (*it < w) && (other != indexMap.cend()) ) indexMap[*it]->insertBidirectionalEdgeTo(other->second);
+			}
+		}
+
+		return subgraph;
+	}
+
 	string GraphAlgorithms::shortPath(const string& path)
 	{
 		//find the 3rd to last path separator
@@ -0,0 +1,140 @@
+#include "MultiSourceBFS.h"
+#include <stdexcept>
+#include <algorithm>
+
+using namespace std;
+
+namespace hyperbolicity
+{
+
+MultiSourceBFS::MultiSourceBFS(const CompactGraph& graph) : _graph(graph)
+{
+	//empty on purpose
+}
+
+MultiSourceBFS::~MultiSourceBFS()
+{
+	//empty on purpose
+}
+
+void MultiSourceBFS::run(const node_index_t* sources, size_t count, compact_distance_t* const* rows)
+{
+	if (count > MaxSources) throw std::invalid_argument("Too many sources for a single multi-source BFS run");
+	if (_graph.isWeighted())
+	{
+		for (size_t i = 0; i < count; ++i) runWeighted(sources[i], rows[i]);
+		return;
+	}
+
+	const size_t n = _graph.size();
+	_seen.assign(n, 0);
+	_frontier.assign(n, 0);
+	_next.assign(n, 0);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		fill(rows[i], rows[i] + n, CompactInfiniteDistance);
+		rows[i][sources[i]] = 0;
+		_seen[sources[i]] |= (1ULL << i);
+		_frontier[sources[i]] |= (1ULL << i);
+	}
+
+	bool isActive = (count > 0);
+	for (unsigned int level = 1; isActive; ++level)
+	{
+		//push the frontier masks along the edges
+		for (size_t v = 0; v < n; ++v)
+		{
+			const unsigned long long mask = _frontier[v];
+			if (0 == mask) continue;
+			for (const unsigned int* it = _graph.neighborsBegin(v); it != _graph.neighborsEnd(v); ++it)
+			{
+				_next[*it] |= mask;
+			}
+		}
+
+		//keep only sources that reach a node for the first time, these form the next frontier
+		isActive = false;
+		for (size_t v = 0; v < n; ++v)
+		{
+			unsigned long long newMask = _next[v] & ~_seen[v];
+			_next[v] = 0;
+			_frontier[v] = newMask;
+			if (0 == newMask) continue;
+
+			if (level >= CompactInfiniteDistance) throw std::overflow_error("Distance exceeds the compact distance range");
+			isActive = true;
+			_seen[v] |= newMask;
+			for (size_t i = 0; newMask != 0; ++i, newMask >>= 1)
+			{
+				if (newMask & 1) rows[i][v] = static_cast<compact_distance_t>(level);
+			}
+		}
+	}
+}
+
+void MultiSourceBFS::run(node_index_t source, compact_distance_t* row)
+{
+	if (_graph.isWeighted())
+	{
+		runWeighted(source, row);
+		return;
+	}
+
+	const size_t n = _graph.size();
+	fill(row, row + n, CompactInfiniteDistance);
+	_queue.resize(n);
+
+	size_t head = 0, tail = 0;
+	_queue[tail++] = static_cast<unsigned int>(source);
+	row[source] = 0;
+	while (head < tail)
+	{
+		unsigned int cur = _queue[head++];
+		unsigned int nextDistance = row[cur] + 1;
+		for (const unsigned int* it = _graph.neighborsBegin(cur); it != _graph.neighborsEnd(cur); ++it)
+		{
+			if (CompactInfiniteDistance != row[*it]) continue;
+			if (nextDistance >= CompactInfiniteDistance) throw std::overflow_error("Distance exceeds the compact distance range");
+			row[*it] = static_cast<compact_distance_t>(nextDistance);
+			_queue[tail++] = *it;
+		}
+	}
+}
+
+void MultiSourceBFS::runWeighted(node_index_t source, compact_distance_t* row)
+{
+	fill(row, row + _graph.size(), CompactInfiniteDistance);
+	//a node is only pushed up to maxWeight ahead of the current distance, so that many buckets (and one more) never collide
+	_buckets.resize(_graph.maxWeight() + 1);
+	for (vector<vector<unsigned int>>::iterator it = _buckets.begin(); it != _buckets.end(); ++it) it->clear();
+
+	row[source] = 0;
+	_buckets[0].push_back(static_cast<unsigned int>(source));
+	size_t queued = 1;
+	for (unsigned int distance = 0; queued > 0; ++distance)
+	{
+		vector<unsigned int>& bucket = _buckets[distance % _buckets.size()];
+		queued -= bucket.size();
+		for (size_t i = 0; i < bucket.size(); ++i)
+		{
+			//a node is pushed again whenever its distance improves, so only its last push is current
+			const unsigned int cur = bucket[i];
+			if (row[cur] != distance) continue;
+
+			const compact_distance_t* weight = _graph.weightsBegin(cur);
+			for (const unsigned int* it = _graph.neighborsBegin(cur); it != _graph.neighborsEnd(cur); ++it, ++weight)
+			{
+				const unsigned int nextDistance = distance + *weight;
+				if ( (CompactInfiniteDistance != row[*it]) && (row[*it] <= nextDistance) ) continue;
+				if (nextDistance >= CompactInfiniteDistance) throw std::overflow_error("Distance exceeds the compact distance range");
+				row[*it] = static_cast<compact_distance_t>(nextDistance);
+				_buckets[nextDistance % _buckets.size()].push_back(*it);
+				++queued;
+			}
+		}
+		bucket.clear();
+	}
+}
+
+} // namespace hyperbolicity
@@ -0,0 +1,359 @@
+#include "TiledDistanceMatrix.h"
+#include "MultiSourceBFS.h"
+#include "GraphAlgorithms.h"
+#include <algorithm>
+#include <share.h>
+
+using namespace std;
+
+namespace hyperbolicity
+{
+
+TiledDistanceMatrix::TiledDistanceMatrix(const CompactGraph& graph, unsigned long long memoryBudget,
+										 const progress_callback_t& progress /* = progress_callback_t() */, bool shouldMarkFarApartPairs /* = false */) :
+	_size(graph.size()), _tileSize(MaxTileSize), _hasFarApartPairs(shouldMarkFarApartPairs), _maxDistance(0), _file(nullptr)
+{
+	//half of the budget goes to the block of rows computed at once, half to the tile cache
+	unsigned long long halfBudget = memoryBudget / 2;
+	while ( (_tileSize > MinTileSize) && (static_cast<unsigned long long>(_tileSize) * _size * sizeof(compact_distance_t) > halfBudget) )
+	{
+		_tileSize /= 2;
+	}
+	_tileCount = (_size + _tileSize - 1) / _tileSize;
+	size_t maxCachedTiles = max(MinCachedTiles, static_cast<size_t>(halfBudget / (_tileSize * _tileSize * sizeof(compact_distance_t))));
+	_maxCachedTilesPerShard = max(static_cast<size_t>(1), maxCachedTiles / CacheShardCount);
+
+	char* path = _tempnam(nullptr, "hyp");
+	if (nullptr == path) throw std::exception("Failed creating a name for the distance tiles file");
+	_path = path;
+	free(path);
+
+	_file = _fsopen(_path.c_str(), "w+b", _SH_DENYWR);
+	if (nullptr == _file) throw std::exception("Failed creating distance tiles file");
+
+	try
+	{
+		computeTiles(graph, progress);
+	}
+	catch (...)
+	{
+		fclose(_file);
+		remove(_path.c_str());
+		throw;
+	}
+}
+
+TiledDistanceMatrix::~TiledDistanceMatrix()
+{
+	fclose(_file);
+	remove(_path.c_str());
+}
+
+size_t TiledDistanceMatrix::size() const
+{
+	return _size;
+}
+
+compact_distance_t TiledDistanceMatrix::getDistance(node_index_t u, node_index_t v) const
+{
+	if (u > v) swap(u, v);
+
+	tile_ptr_t tile = getTile(u / _tileSize, v / _tileSize);
+	return (*tile)[(u % _tileSize) * _tileSize + (v % _tileSize)];
+}
+
+void TiledDistanceMatrix::getRow(node_index_t u, compact_distance_t* row) const
+{
+	const size_t i = u / _tileSize;
+	const size_t r = u % _tileSize;
+
+	for (size_t j = 0; j < _tileCount; ++j)
+	{
+		const size_t colBegin = j * _tileSize;
+		const size_t colCount = min(_size, colBegin + _tileSize) - colBegin;
+		if (i <= j)
+		{
+			//the row is stored as is
+			tile_ptr_t tile = getTile(i, j);
+			copy(tile->cbegin() + r * _tileSize, tile->cbegin() + r * _tileSize + colCount, row + colBegin);
+		}
+		else
+		{
+			//only the mirrored tile is stored, so the row is a column in it
+			tile_ptr_t tile = getTile(j, i);
+			for (size_t c = 0; c < colCount; ++c)
+			{
+				row[colBegin + c] = (*tile)[c * _tileSize + r];
+			}
+		}
+	}
+}
+
+compact_distance_t TiledDistanceMatrix::getMaxDistance() const
+{
+	return _maxDistance;
+}
+
+size_t TiledDistanceMatrix::getTileSize() const
+{
+	return _tileSize;
+}
+
+size_t TiledDistanceMatrix::getTileCount() const
+{
+	return _tileCount;
+}
+
+bool TiledDistanceMatrix::hasFarApartPairs() const
+{
+	return _hasFarApartPairs;
+}
+
+long long TiledDistanceMatrix::getTileOffset(size_t i, size_t j) const
+{
+	//tile row i starts after the (tileCount - r) tiles of every previous row r
+	unsigned long long tileNumber = static_cast<unsigned long long>(i) * _tileCount - static_cast<unsigned long long>(i) * (i - 1) / 2 + (j - i);
+	return static_cast<long long>(tileNumber * getRecordSize() * sizeof(compact_distance_t));
+}
+
+size_t TiledDistanceMatrix::getRecordSize() const
+{
+	//a bit per entry - the tile size is a power of 2 (of at least MinTileSize), so the bits fill whole compact distances
+	const size_t tileEntries = _tileSize * _tileSize;
+	return (_hasFarApartPairs ? tileEntries + tileEntries / (8 * sizeof(compact_distance_t)) : tileEntries);
+}
+
+void TiledDistanceMatrix::computeTiles(const CompactGraph& graph, const progress_callback_t& progress)
+{
+	MultiSourceBFS bfs(graph);
+	vector<compact_distance_t> rows(_tileSize * _size);
+	tile_t tile(_tileSize * _tileSize);
+	vector<unsigned char> marks(_hasFarApartPairs ? _tileSize * _tileSize / 8 : 0);
+	node_index_t sources[MultiSourceBFS::MaxSources];
+	compact_distance_t* rowPointers[MultiSourceBFS::MaxSources];
+
+	for (size_t i = 0; i < _tileCount; ++i)
+	{
+		//compute the rows of the current block of sources
+		const node_index_t first = i * _tileSize;
+		const size_t rowCount = min(_tileSize, _size - first);
+		for (size_t b = 0; b < rowCount; b += MultiSourceBFS::MaxSources)
+		{
+			size_t count = min(MultiSourceBFS::MaxSources, rowCount - b);
+			for (size_t k = 0; k < count; ++k)
+			{
+				sources[k] = first + b + k;
+				rowPointers[k] = &rows[(b + k) * _size];
+			}
+			bfs.run(sources, count, rowPointers);
+		}
+
+		for (size_t k = 0; k < rowCount * _size; ++k)
+		{
+			if (rows[k] != CompactInfiniteDistance && rows[k] > _maxDistance) _maxDistance = rows[k];
+		}
+
+		//the tiles left of the diagonal are mirrored in earlier tile rows, so their marks are completed there - then the file position
+		//is back at the start of this tile row
+		if (_hasFarApartPairs)
+		{
+			completeFarApartPairs(graph, i, rows, marks);
+			if (0 != _fseeki64(_file, getTileOffset(i, i), SEEK_SET)) throw std::exception("Failed writing distance tile");
+		}
+
+		//cut them into tiles - tiles of the same row are consecutive in the file, so this is a sequential write
+		for (size_t j = i; j < _tileCount; ++j)
+		{
+			const size_t colBegin = j * _tileSize;
+			const size_t colCount = min(_size, colBegin + _tileSize) - colBegin;
+			fill(tile.begin(), tile.end(), CompactInfiniteDistance);
+			for (size_t r = 0; r < rowCount; ++r)
+			{
+				copy(rows.cbegin() + r * _size + colBegin, rows.cbegin() + r * _size + colBegin + colCount, tile.begin() + r * _tileSize);
+			}
+
+			if (tile.size() != fwrite(tile.data(), sizeof(compact_distance_t), tile.size(), _file))
+			{
+				throw std::exception("Failed writing distance tile");
+			}
+
+			if (_hasFarApartPairs)
+			{
+				markFarApartPairs(graph, i, j, rows, marks);
+				if (marks.size() != fwrite(marks.data(), 1, marks.size(), _file)) throw std::exception("Failed writing distance tile");
+			}
+		}
+
+		if (progress && !progress(static_cast<double>(i + 1) / _tileCount)) return;
+	}
+
+	if (0 != fflush(_file)) throw std::exception("Failed writing distance tiles file");
+}
+
+void TiledDistanceMatrix::markFarApartPairs(const CompactGraph& graph, size_t i, size_t j, const vector<compact_distance_t>& rows,
+											vector<unsigned char>& marks) const
+{
+	fill(marks.begin(), marks.end(), 0);
+	const node_index_t rowBegin = i * _tileSize, colBegin = j * _tileSize;
+	const size_t rowCount = min(_tileSize, _size - rowBegin), colCount = min(_tileSize, _size - colBegin);
+	for (size_t r = 0; r < rowCount; ++r)
+	{
+		const compact_distance_t* row = &rows[r * _size];
+		for (size_t c = 0; c < colCount; ++c)
+		{
+			const node_index_t v = colBegin + c;
+			if ( (rowBegin + r == v) || (CompactInfiniteDistance == row[v]) || !GraphAlgorithms::isFarthestAmongNeighbors(graph, row, v) ) continue;
+
+			//on the diagonal both rows are in the block, so the pair is checked both ways around at once
+			if ( (i == j) && !GraphAlgorithms::isFarthestAmongNeighbors(graph, &rows[c * _size], rowBegin + r) ) continue;
+			const size_t bit = r * _tileSize + c;
+			marks[bit / 8] |= static_cast<unsigned char>(1 << (bit % 8));
+		}
+	}
+}
+
+void TiledDistanceMatrix::completeFarApartPairs(const CompactGraph& graph, size_t i, const vector<compact_distance_t>& rows, vector<unsigned char>& marks)
+{
+	//only the pairs already marked from block j's side are checked, so this is a small fraction of the work of marking them
+	const node_index_t colBegin = i * _tileSize;
+	const long long marksOffset = static_cast<long long>(_tileSize * _tileSize * sizeof(compact_distance_t));
+	for (size_t j = 0; j < i; ++j)
+	{
+		const long long offset = getTileOffset(j, i) + marksOffset;
+		if ( (0 != _fseeki64(_file, offset, SEEK_SET)) || (marks.size() != fread(marks.data(), 1, marks.size(), _file)) )
+		{
+			throw std::exception("Failed reading distance tile");
+		}
+
+		const node_index_t rowBegin = j * _tileSize;
+		for (size_t bit = 0; bit < marks.size() * 8; ++bit)
+		{
+			if (0 == (marks[bit / 8] & (1 << (bit % 8)))) continue;
+			const size_t r = bit / _tileSize, c = bit % _tileSize;
+			if (!GraphAlgorithms::isFarthestAmongNeighbors(graph, &rows[c * _size], rowBegin + r))
+			{
+				marks[bit / 8] &= static_cast<unsigned char>(~(1 << (bit % 8)));
+			}
+		}
+
+		if ( (0 != _fseeki64(_file, offset, SEEK_SET)) || (marks.size() != fwrite(marks.data(), 1, marks.size(), _file)) )
+		{
+			throw std::exception("Failed writing distance tile");
+		}
+	}
+}
+
+TiledDistanceMatrix::tile_ptr_t TiledDistanceMatrix::getTile(size_t i, size_t j) const
+{
+	const size_t tileNumber = i * _tileCount + j;
+	CacheShard& shard = _shards[tileNumber % CacheShardCount];
+	{
+		lock_guard<mutex> lock(shard.mutex);
+		unordered_map<size_t, tile_cache_t::iterator>::iterator position = shard.positions.find(tileNumber);
+		if (position != shard.positions.end())
+		{
+			//move to the front of the LRU list
+			shard.cache.splice(shard.cache.begin(), shard.cache, position->second);
+			return shard.cache.front().second;
+		}
+	}
+
+	//read it with no shard locked, so that readers of cached tiles are not held up by the disk
+	shared_ptr<tile_t> tile(new tile_t(_tileSize * _tileSize));
+	{
+		lock_guard<mutex> lock(_fileMutex);
+		if ( (0 != _fseeki64(_file, getTileOffset(i, j), SEEK_SET)) ||
+			 (tile->size() != fread(tile->data(), sizeof(compact_distance_t), tile->size(), _file)) )
+		{
+			throw std::exception("Failed reading distance tile");
+		}
+	}
+
+	lock_guard<mutex> lock(shard.mutex);
+	if (shard.positions.find(tileNumber) != shard.positions.end())
+	{
+		//another thread read it meanwhile
+		return tile;
+	}
+
+	//evict the least recently used tile - whoever still uses it keeps its own reference
+	if (shard.cache.size() >= _maxCachedTilesPerShard)
+	{
+		shard.positions.erase(shard.cache.back().first);
+		shard.cache.pop_back();
+	}
+	shard.cache.push_front(make_pair(tileNumber, tile_ptr_t(tile)));
+	shard.positions[tileNumber] = shard.cache.begin();
+	return tile;
+}
+
+TiledDistanceMatrix::TileReader::TileReader(const TiledDistanceMatrix& matrix) : _matrix(matrix), _i(0), _j(0)
+{
+	_file = _fsopen(matrix._path.c_str(), "rb", _SH_DENYNO);
+	if (nullptr == _file) throw std::exception("Failed opening distance tiles file for reading");
+	_current.stride = matrix._tileSize;
+	_current.hasFarApartPairs = matrix._hasFarApartPairs;
+	if (_matrix._tileCount > 0) prefetch();
+}
+
+TiledDistanceMatrix::TileReader::~TileReader()
+{
+	//a pending read uses the file, so it must be done before closing it
+	if (_pending.valid()) _pending.wait();
+	fclose(_file);
+}
+
+bool TiledDistanceMatrix::TileReader::next(const Tile*& tile)
+{
+	if (!_pending.valid()) return false;
+
+	const size_t i = _i, j = _j;
+	_current.data = _pending.get();
+
+	//move on to the next tile, and start reading it
+	if (++_j == _matrix._tileCount)
+	{
+		++_i;
+		_j = _i;
+	}
+	if (_i < _matrix._tileCount) prefetch();
+
+	_current.rowBegin = i * _current.stride;
+	_current.rowEnd = min(_matrix._size, (i + 1) * _current.stride);
+	_current.colBegin = j * _current.stride;
+	_current.colEnd = min(_matrix._size, (j + 1) * _current.stride);
+	tile = &_current;
+	return true;
+}
+
+void TiledDistanceMatrix::TileReader::prefetch()
+{
+	const size_t i = _i, j = _j;
+	_pending = async(launch::async, [this, i, j]() -> vector<compact_distance_t>
+	{
+		vector<compact_distance_t> record(_matrix.getRecordSize());
+		if ( (0 != _fseeki64(_file, _matrix.getTileOffset(i, j), SEEK_SET)) ||
+			 (record.size() != fread(record.data(), sizeof(compact_distance_t), record.size(), _file)) )
+		{
+			throw std::exception("Failed reading distance tile");
+		}
+		return record;
+	});
+}
+
+compact_distance_t TiledDistanceMatrix::TileReader::Tile::getDistance(size_t r, size_t c) const
+{
+	return data[r * stride + c];
+}
+
+bool TiledDistanceMatrix::TileReader::Tile::isFarApart(size_t r, size_t c) const
+{
+	if (!hasFarApartPairs) return false;
+
+	//the marks follow the tile's distances
+	const unsigned char* marks = reinterpret_cast<const unsigned char*>(data.data() + stride * stride);
+	const size_t bit = r * stride + c;
+	return (0 != (marks[bit / 8] & (1 << (bit % 8))));
+}
+
+} // namespace hyperbolicity
@@ -1,67 +1,1036 @@
 #include <Graph\Graph.h>
 #include <Graph\GraphAlgorithms.h>
+#include <Graph\CompactGraph.h>
+#include <Graph\DistanceMatrix.h>
+#include <Graph\DeltaEncodedDistanceMatrix.h>
+#include <Graph\TiledDistanceMatrix.h>
+#include <Graph\DynamicDistances.h>
 #include <Graph\defs.h>
 #include <Graph\FurthestNode.h>
 #include <Graph\NodeDistances.h>
 #include <Graph\SpanningTree.h>
+#include <Algorithm\IGraphAlg.h>
+#include <Algorithm\BoundChannel.h>
+#include <Algorithm\FourPointKernel.h>
+#include <Algorithm\HyperbolicityAlgorithms.h>
+#include <Windows.h>
 #include <iostream>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <queue>
+#include <random>
+#include <memory>
+#include <thread>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
 #include <time.h>
 
 using namespace std;
 using namespace hyperbolicity;
 
-int main()
+typedef IGraphAlg* (*AlgCreationMethod)();
+typedef void (*AlgReleaseMethod)(IGraphAlg*);
+typedef vector<pair<node_index_t, node_index_t>> edge_collection_t;
+typedef vector<vector<distance_t>> distances_t;
+
+//seed of the random graphs & kernel inputs (fixed, so a failure can be reproduced)
+const unsigned int RandomSeed = 20130511;
+
+//a plugin that runs longer than this many steps on a test graph is stopped (only exact plugins must complete)
+const unsigned int MaxPluginSteps = 1000;
+
+//the plugins are run with 1 to this many threads (see IGraphAlg::setThreadLimit()), a different number on each test graph
+const unsigned int MaxPluginThreads = 4;
+
+//a graph to check, and its distances & delta as calculated by a plain BFS & the brute force search below - and its chain core (see
+//HyperbolicityAlgorithms::getChainCore()), with the delta of the core nodes by the graph's distances
+struct TestGraph
+{
+	graph_ptr_t graph;
+	distances_t distances;
+	delta_t delta;
+	HyperbolicityAlgorithms::WeightedCore core;
+	delta_t coreDelta;
+};
+
+//a plugin to check - exact plugins must find the delta, the others must not report a delta larger than it
+struct PluginInfo
+{
+	const char* name;
+	bool isExact;
+};
+
+const PluginInfo Plugins[] =
+{
+	{ "BruteForce", true },
+	{ "Cohen", true },
+	{ "GromovProduct", false },
+	{ "MDS", false },
+	{ "SAParallelTempering", false },
+	{ "SARejectionFree", false },
+	{ "LargeDistances", false }
+};
+
+unsigned int failureCount = 0;
+
+void check(bool condition, const string& description)
+{
+	if (condition) return;
+	cout << "***ERROR*** - " << description << endl;
+	++failureCount;
+}
+
+/*
+ * @brief	Creates a graph whose node labels are their indices (so nodes of sub-graphs can be traced back to the original graph).
+ */
+graph_ptr_t createGraph(const string& title, size_t nodeCount, const edge_collection_t& edges)
+{
+	graph_ptr_t graph(new Graph(title));
+	for (size_t i = 0; i < nodeCount; ++i) graph->insertNode(to_string(static_cast<unsigned long long>(i)));
+	for (edge_collection_t::const_iterator it = edges.cbegin(); it != edges.cend(); ++it)
+	{
+		node_ptr_t u = graph->getNode(it->first);
+		node_ptr_t v = graph->getNode(it->second);
+		if ( (u != v) && (!u->hasEdge(v)) ) u->insertBidirectionalEdgeTo(v);
+	}
+	return graph;
+}
+
+/*
+ * @returns	The index of the given node in the graph it was originally created in (see createGraph()).
+ */
+node_index_t getOriginalIndex(const node_ptr_t node)
+{
+	return static_cast<node_index_t>(atoi(node->getLabel().c_str()));
+}
+
+/*
+ * @returns	The distances between every two nodes of the graph (by their index in it), using a plain BFS from every node.
+ */
+distances_t getDistances(const graph_ptr_t graph)
+{
+	size_t n = graph->size();
+	distances_t distances(n, vector<distance_t>(n, InfiniteDistance));
+	for (node_index_t source = 0; source < n; ++source)
+	{
+		vector<distance_t>& row = distances[source];
+		queue<node_index_t> pending;
+		row[source] = 0;
+		pending.push(source);
+		while (!pending.empty())
+		{
+			node_index_t u = pending.front();
+			pending.pop();
+			const node_weak_ptr_collection_t& edges = graph->getNode(u)->getEdges();
+			for (node_weak_ptr_collection_t::const_iterator it = edges.cbegin(); it != edges.cend(); ++it)
+			{
+				node_index_t v = it->lock()->getIndex();
+				if (InfiniteDistance != row[v]) continue;
+				row[v] = row[u] + 1;
+				pending.push(v);
+			}
+		}
+	}
+	return distances;
+}
+
+/*
+ * @returns	Twice the delta of the given sums - the largest minus the middle one.
+ */
+distance_t getDoubleDelta(distance_t s1, distance_t s2, distance_t s3)
+{
+	distance_t sums[3] = { s1, s2, s3 };
+	sort(sums, sums + 3);
+	return sums[2] - sums[1];
+}
+
+distance_t getDoubleDelta(const distances_t& d, node_index_t v1, node_index_t v2, node_index_t v3, node_index_t v4)
+{
+	return getDoubleDelta(d[v1][v2] + d[v3][v4], d[v1][v3] + d[v2][v4], d[v1][v4] + d[v2][v3]);
+}
+
+/*
+ * @returns	The delta of the graph, by evaluating every 4 nodes (0 if it has less than 4 nodes).
+ */
+delta_t getBruteForceDelta(const distances_t& d)
+{
+	size_t n = d.size();
+	distance_t best = 0;
+	for (node_index_t v1 = 0; v1 < n; ++v1)
+	{
+		for (node_index_t v2 = v1 + 1; v2 < n; ++v2)
+		{
+			for (node_index_t v3 = v2 + 1; v3 < n; ++v3)
+			{
+				for (node_index_t v4 = v3 + 1; v4 < n; ++v4)
+				{
+					best = max(best, getDoubleDelta(d, v1, v2, v3, v4));
+				}
+			}
+		}
+	}
+	return best / 2.0;
+}
+
+delta_t getBruteForceDelta(const graph_ptr_t graph)
+{
+	return getBruteForceDelta(getDistances(graph));
+}
+
+/*
+ * @brief	Checks that the state reported with a positive delta (whose nodes belong to the test graph, or to a sub-graph of it) attains it.
+ */
+void checkState(const TestGraph& test, const DeltaHyperbolicity& result, const string& description)
+{
+	if (result.getDelta() <= 0) return;
+
+	const node_combination_t& state = result.getState();
+	if (!state.isInitialized())
+	{
+		check(false, description + ": no state is reported with delta " + to_string(static_cast<long double>(result.getDelta())));
+		return;
+	}
+
+	distance_t doubleDelta = getDoubleDelta(test.distances, getOriginalIndex(state[0]), getOriginalIndex(state[1]), getOriginalIndex(state[2]), getOriginalIndex(state[3]));
+	check(doubleDelta == 2 * result.getDelta(), description + ": the state " + state.printNodes() + " has delta " + to_string(static_cast<long double>(doubleDelta / 2.0)) +
+		  ", not the reported " + to_string(static_cast<long double>(result.getDelta())));
+}
+
+/*
+ * @returns	A random connected graph - a random tree, plus the given number of random edges.
+ */
+edge_collection_t getRandomEdges(size_t nodeCount, size_t extraEdgeCount, mt19937& random)
+{
+	edge_collection_t edges;
+	for (node_index_t v = 1; v < nodeCount; ++v) edges.push_back(make_pair(static_cast<node_index_t>(random() % v), v));
+	for (size_t i = 0; i < extraEdgeCount; ++i) edges.push_back(make_pair(static_cast<node_index_t>(random() % nodeCount), static_cast<node_index_t>(random() % nodeCount)));
+	return edges;
+}
+
+void addGraph(vector<TestGraph>& tests, const graph_ptr_t graph)
+{
+	TestGraph test;
+	test.graph = graph;
+	test.distances = getDistances(graph);
+	test.delta = getBruteForceDelta(test.distances);
+
+	test.core = HyperbolicityAlgorithms::getChainCore(graph);
+	distances_t coreDistances(test.core.nodes.size(), vector<distance_t>(test.core.nodes.size()));
+	for (node_index_t u = 0; u < test.core.nodes.size(); ++u)
+	{
+		for (node_index_t v = 0; v < test.core.nodes.size(); ++v) coreDistances[u][v] = test.distances[test.core.nodes[u]][test.core.nodes[v]];
+	}
+	test.coreDelta = getBruteForceDelta(coreDistances);
+	tests.push_back(test);
+}
+
+/*
+ * @returns	Small connected graphs - random ones, and ones with long chains, pendant trees, false twins and splits.
+ */
+vector<TestGraph> getTestGraphs(mt19937& random)
+{
+	vector<TestGraph> tests;
+
+	//cycles, a grid and a complete graph (exact deltas of 0 up to 2)
+	const size_t cycleLengths[] = { 4, 5, 6, 7, 8, 11 };
+	for (size_t i = 0; i < sizeof(cycleLengths) / sizeof(cycleLengths[0]); ++i)
+	{
+		edge_collection_t edges;
+		for (node_index_t v = 0; v < cycleLengths[i]; ++v) edges.push_back(make_pair(v, static_cast<node_index_t>((v + 1) % cycleLengths[i])));
+		addGraph(tests, createGraph("cycle_" + to_string(static_cast<unsigned long long>(cycleLengths[i])), cycleLengths[i], edges));
+	}
+
+	edge_collection_t gridEdges;
+	for (node_index_t row = 0; row < 5; ++row)
+	{
+		for (node_index_t col = 0; col < 6; ++col)
+		{
+			if (col + 1 < 6) gridEdges.push_back(make_pair(row * 6 + col, row * 6 + col + 1));
+			if (row + 1 < 5) gridEdges.push_back(make_pair(row * 6 + col, (row + 1) * 6 + col));
+		}
+	}
+	addGraph(tests, createGraph("grid_5x6", 30, gridEdges));
+
+	edge_collection_t completeEdges;
+	for (node_index_t u = 0; u < 7; ++u)
+	{
+		for (node_index_t v = u + 1; v < 7; ++v) completeEdges.push_back(make_pair(u, v));
+	}
+	addGraph(tests, createGraph("complete_7", 7, completeEdges));
+
+	for (unsigned int i = 0; i < 24; ++i)
+	{
+		string suffix = "_" + to_string(static_cast<unsigned long long>(i));
+
+		//random graphs, from trees to dense ones
+		size_t n = 8 + random() % 28;
+		addGraph(tests, createGraph("random" + suffix, n, getRandomEdges(n, random() % (2 * n), random)));
+
+		//random graphs with subdivided edges (long chains of degree-2 nodes)
+		n = 5 + random() % 8;
+		edge_collection_t edges = getRandomEdges(n, 1 + random() % n, random);
+		edge_collection_t subdividedEdges;
+		for (edge_collection_t::const_iterator it = edges.cbegin(); it != edges.cend(); ++it)
+		{
+			node_index_t last = it->first;
+			for (unsigned int length = random() % 4; length > 0; --length)
+			{
+				subdividedEdges.push_back(make_pair(last, static_cast<node_index_t>(n)));
+				last = static_cast<node_index_t>(n++);
+			}
+			subdividedEdges.push_back(make_pair(last, it->second));
+		}
+		addGraph(tests, createGraph("subdivided" + suffix, n, subdividedEdges));
+
+		//random graphs with pendant trees
+		n = 6 + random() % 10;
+		edges = getRandomEdges(n, 1 + random() % n, random);
+		size_t treeNodeCount = 1 + random() % 12;
+		for (size_t j = 0; j < treeNodeCount; ++j, ++n) edges.push_back(make_pair(static_cast<node_index_t>(random() % n), static_cast<node_index_t>(n)));
+		addGraph(tests, createGraph("pendant_trees" + suffix, n, edges));
+
+		//random graphs with false twins (copies of nodes, sharing their neighbors)
+		n = 6 + random() % 12;
+		edges = getRandomEdges(n, random() % n, random);
+		size_t twinCount = 1 + random() % 4;
+		for (size_t j = 0; j < twinCount; ++j, ++n)
+		{
+			node_index_t original = static_cast<node_index_t>(random() % n);
+			size_t edgeCount = edges.size();
+			for (size_t k = 0; k < edgeCount; ++k)
+			{
+				if (edges[k].first == original) edges.push_back(make_pair(static_cast<node_index_t>(n), edges[k].second));
+				if (edges[k].second == original) edges.push_back(make_pair(static_cast<node_index_t>(n), edges[k].first));
+			}
+		}
+		addGraph(tests, createGraph("twins" + suffix, n, edges));
+
+		//two random graphs, joined by all the edges between a few nodes of each (a split)
+		size_t n1 = 3 + random() % 10;
+		size_t n2 = 3 + random() % 10;
+		edges = getRandomEdges(n1, random() % n1, random);
+		edge_collection_t otherEdges = getRandomEdges(n2, random() % n2, random);
+		for (edge_collection_t::const_iterator it = otherEdges.cbegin(); it != otherEdges.cend(); ++it)
+		{
+			edges.push_back(make_pair(static_cast<node_index_t>(n1 + it->first), static_cast<node_index_t>(n1 + it->second)));
+		}
+		size_t frontier1 = 1 + random() % min<size_t>(n1, 3);
+		size_t frontier2 = 1 + random() % min<size_t>(n2, 3);
+		for (node_index_t u = 0; u < frontier1; ++u)
+		{
+			for (node_index_t v = 0; v < frontier2; ++v) edges.push_back(make_pair(u, static_cast<node_index_t>(n1 + v)));
+		}
+		addGraph(tests, createGraph("split" + suffix, n1 + n2, edges));
+	}
+
+	return tests;
+}
+
+/*
+ * @brief	Checks every distance, every row and the largest distance of the matrix against the BFS distances.
+ */
+void checkDistanceMatrix(const TestGraph& test, const IDistanceMatrix& matrix, const string& description)
+{
+	size_t n = test.distances.size();
+	check(matrix.size() == n, description + ": wrong size");
+	if (matrix.size() != n) return;
+
+	vector<compact_distance_t> row(n);
+	distance_t maxDistance = 0;
+	size_t wrongCount = 0;
+	for (node_index_t u = 0; u < n; ++u)
+	{
+		matrix.getRow(u, &row[0]);
+		for (node_index_t v = 0; v < n; ++v)
+		{
+			distance_t distance = test.distances[u][v];
+			maxDistance = max(maxDistance, distance);
+			if ( (row[v] != distance) || (matrix.getDistance(u, v) != distance) ) ++wrongCount;
+		}
+	}
+
+	check(0 == wrongCount, description + ": " + to_string(static_cast<unsigned long long>(wrongCount)) + " wrong distances");
+	check(matrix.getMaxDistance() == maxDistance, description + ": wrong largest distance");
+}
+
+/*
+ * @brief	Checks the tiles read in file order against the BFS distances, and their far-apart marks against the pairs found from them.
+ */
+void checkTileReader(const TestGraph& test, const TiledDistanceMatrix& matrix, const string& description)
+{
+	size_t n = test.distances.size();
+	vector<vector<bool>> isRead(n, vector<bool>(n, false));
+	size_t wrongCount = 0, wrongMarkCount = 0;
+	TiledDistanceMatrix::TileReader reader(matrix);
+	const TiledDistanceMatrix::TileReader::Tile* tile = nullptr;
+	while (reader.next(tile))
+	{
+		for (node_index_t u = tile->rowBegin; u < tile->rowEnd; ++u)
+		{
+			for (node_index_t v = tile->colBegin; v < tile->colEnd; ++v)
+			{
+				isRead[u][v] = true;
+				if (tile->getDistance(u - tile->rowBegin, v - tile->colBegin) != test.distances[u][v]) ++wrongCount;
+
+				//(u, v) is far-apart if neither node has a neighbor farther from the other one
+				bool isFarApart = (u != v);
+				for (unsigned int k = 0; (k < 2) && isFarApart; ++k)
+				{
+					node_index_t from = (0 == k ? u : v), to = (0 == k ? v : u);
+					const node_weak_ptr_collection_t& edges = test.graph->getNode(to)->getEdges();
+					for (node_weak_ptr_collection_t::const_iterator it = edges.cbegin(); it != edges.cend(); ++it)
+					{
+						if (test.distances[from][it->lock()->getIndex()] > test.distances[from][to]) isFarApart = false;
+					}
+				}
+				if (tile->isFarApart(u - tile->rowBegin, v - tile->colBegin) != (isFarApart && matrix.hasFarApartPairs())) ++wrongMarkCount;
+			}
+		}
+	}
+
+	size_t missingCount = 0;
+	for (node_index_t u = 0; u < n; ++u)
+	{
+		for (node_index_t v = u; v < n; ++v)
+		{
+			if (!isRead[u][v]) ++missingCount;
+		}
+	}
+	check(0 == missingCount, description + ": " + to_string(static_cast<unsigned long long>(missingCount)) + " distances were not read");
+	check(0 == wrongCount, description + ": " + to_string(static_cast<unsigned long long>(wrongCount)) + " wrong distances read");
+	check(0 == wrongMarkCount, description + ": " + to_string(static_cast<unsigned long long>(wrongMarkCount)) + " wrong far-apart marks");
+}
+
+void checkDistanceMatrices(const TestGraph& test)
+{
+	string title = test.graph->getTitle();
+	CompactGraph compactGraph(test.graph);
+
+	DenseDistanceMatrix dense(compactGraph);
+	checkDistanceMatrix(test, dense, title + " (dense)");
+	size_t wrongCount = 0;
+	for (node_index_t u = 0; u < test.distances.size(); ++u)
+	{
+		const compact_distance_t* row = dense.row(u);
+		for (node_index_t v = 0; v < test.distances.size(); ++v)
+		{
+			if (row[v] != test.distances[u][v]) ++wrongCount;
+		}
+	}
+	check(0 == wrongCount, title + " (dense): " + to_string(static_cast<unsigned long long>(wrongCount)) + " wrong distances in the rows");
+
+	//a budget of the encoded rows alone caches only a few decoded rows, a large one caches them all
+	unsigned long long encodedSize = DeltaEncodedDistanceMatrix::getEncodedSize(test.distances.size());
+	checkDistanceMatrix(test, DeltaEncodedDistanceMatrix(compactGraph, encodedSize), title + " (delta encoded, small cache)");
+	checkDistanceMatrix(test, DeltaEncodedDistanceMatrix(compactGraph, encodedSize + (1ULL << 20)), title + " (delta encoded, large cache)");
+
+	//a budget of 1 byte makes the smallest tiles and caches only a few of them, a large one caches them all
+	checkDistanceMatrix(test, TiledDistanceMatrix(compactGraph, 1), title + " (tiled, small cache)");
+	TiledDistanceMatrix tiled(compactGraph, 1ULL << 24);
+	checkDistanceMatrix(test, tiled, title + " (tiled, large cache)");
+	checkTileReader(test, tiled, title + " (tiled, read in order)");
+	TiledDistanceMatrix marked(compactGraph, 1, progress_callback_t(), true);
+	checkDistanceMatrix(test, marked, title + " (tiled, far-apart pairs marked)");
+	checkTileReader(test, marked, title + " (tiled, far-apart pairs marked, read in order)");
+}
+
+/*
+ * @brief	Checks the stored rows against a plain BFS on the graph as it is now - the rows of all its nodes must be stored.
+ */
+void checkDynamicRows(DynamicDistances& dynamicDistances, const graph_ptr_t graph, const string& description)
+{
+	distances_t distances = getDistances(graph);
+	size_t missingCount = 0, wrongCount = 0;
+	for (node_index_t u = 0; u < graph->size(); ++u)
+	{
+		if (!dynamicDistances.hasRow(u))
+		{
+			++missingCount;
+			continue;
+		}
+
+		const vector<compact_distance_t>& row = dynamicDistances.getRow(u);
+		for (node_index_t v = 0; v < graph->size(); ++v)
+		{
+			compact_distance_t distance = (InfiniteDistance == distances[u][v] ? CompactInfiniteDistance : static_cast<compact_distance_t>(distances[u][v]));
+			if ( (row.size() != graph->size()) || (row[v] != distance) ) ++wrongCount;
+		}
+	}
+	check(0 == missingCount, description + ": " + to_string(static_cast<unsigned long long>(missingCount)) + " rows were dropped");
+	check(0 == wrongCount, description + ": " + to_string(static_cast<unsigned long long>(wrongCount)) + " wrong distances");
+}
+
+/*
+ * @brief	Deletes nodes & edges from a copy of the graph, and checks the dynamic rows of all its nodes after each deletion - random nodes
+ *			(which may change any distance), a random edge, and a leaf (which changes no distance).
+ */
+void checkDynamicDistances(const TestGraph& test, mt19937& random)
+{
+	string title = test.graph->getTitle();
+	vector<node_index_t> allNodes;
+	for (node_index_t u = 0; u < test.graph->size(); ++u) allNodes.push_back(u);
+	graph_ptr_t graph = GraphAlgorithms::getInducedSubgraph(test.graph, allNodes, title);
+	DynamicDistances dynamicDistances(graph);
+	dynamicDistances.loadRows(allNodes.data(), allNodes.size());
+	checkDynamicRows(dynamicDistances, graph, title + " (dynamic distances)");
+
+	graph->unmarkNodes();
+	size_t deletedCount = 1 + random() % 3;
+	for (size_t i = 0; i < deletedCount; ++i) graph->getNode(random() % graph->size())->setMarked(true);
+	graph->deleteMarkedNodes();
+	const vector<node_index_t>& mapping = dynamicDistances.synchronize();
+	size_t mappedCount = 0;
+	for (vector<node_index_t>::const_iterator it = mapping.cbegin(); it != mapping.cend(); ++it)
+	{
+		if (DynamicDistances::DeletedNode != *it) ++mappedCount;
+	}
+	check( (mapping.size() == test.graph->size()) && (mappedCount == graph->size()), title + " (dynamic distances): wrong mapping of the remaining nodes");
+	checkDynamicRows(dynamicDistances, graph, title + " (dynamic distances, nodes deleted)");
+
+	for (node_index_t u = 0; u < graph->size(); ++u)
+	{
+		const node_weak_ptr_collection_t& edges = graph->getNode(u)->getEdges();
+		if (edges.empty()) continue;
+		node_ptr_t v = edges[random() % edges.size()].lock();
+		graph->getNode(u)->removeEdge(v);
+		v->removeEdge(graph->getNode(u));
+		dynamicDistances.edgeRemoved(u, v->getIndex());
+		checkDynamicRows(dynamicDistances, graph, title + " (dynamic distances, edge removed)");
+		break;
+	}
+
+	for (node_index_t u = 0; u < graph->size(); ++u)
+	{
+		if (1 != graph->getNode(u)->getEdges().size()) continue;
+		graph->removeNode(u);
+		dynamicDistances.synchronize(true);
+		checkDynamicRows(dynamicDistances, graph, title + " (dynamic distances, leaf deleted)");
+		break;
+	}
+}
+
+/*
+ * @returns	The number of distances between the nodes of the sub-graph (which keep their labels) that differ from those in the test graph.
+ */
+size_t countChangedDistances(const TestGraph& test, const graph_ptr_t subgraph, const distances_t& subgraphDistances)
+{
+	size_t changedCount = 0;
+	for (node_index_t u = 0; u < subgraph->size(); ++u)
+	{
+		for (node_index_t v = 0; v < subgraph->size(); ++v)
+		{
+			if (subgraphDistances[u][v] != test.distances[getOriginalIndex(subgraph->getNode(u))][getOriginalIndex(subgraph->getNode(v))]) ++changedCount;
+		}
+	}
+	return changedCount;
+}
+
+/*
+ * @brief	Checks the decompositions & reductions against the brute force delta of the graph.
+ */
+void checkDecompositions(const TestGraph& test)
+{
+	string title = test.graph->getTitle();
+	size_t n = test.graph->size();
+	vector<node_index_t> allNodes;
+	for (node_index_t u = 0; u < n; ++u) allNodes.push_back(u);
+
+	//atoms - they cover the graph and keep its distances, and the delta is at least the largest delta of an atom, and at most 1 more
+	graph_ptr_collection_t atoms = GraphAlgorithms::getAtoms(test.graph);
+	delta_t atomDelta = 0;
+	vector<bool> isCovered(n, false);
+	size_t wrongCount = 0;
+	for (graph_ptr_collection_t::const_iterator it = atoms.cbegin(); it != atoms.cend(); ++it)
+	{
+		distances_t atomDistances = getDistances(*it);
+		for (node_index_t u = 0; u < (*it)->size(); ++u) isCovered[getOriginalIndex((*it)->getNode(u))] = true;
+		wrongCount += countChangedDistances(test, *it, atomDistances);
+		atomDelta = max(atomDelta, getBruteForceDelta(atomDistances));
+	}
+	check(count(isCovered.cbegin(), isCovered.cend(), false) == 0, title + ": the atoms do not cover every node");
+	check(0 == wrongCount, title + ": the atoms changed " + to_string(static_cast<unsigned long long>(wrongCount)) + " distances");
+	check( (test.delta >= atomDelta) && (test.delta <= atomDelta + 1), title + ": the atoms' delta is " + to_string(static_cast<long double>(atomDelta)));
+
+	//false twins - the distances are kept, and the delta is the larger of the reduced graph's delta and the one returned
+	graph_ptr_t reduced = GraphAlgorithms::getInducedSubgraph(test.graph, allNodes, title);
+	DeltaHyperbolicity twinsDelta = HyperbolicityAlgorithms::reduceFalseTwins(reduced);
+	distances_t reducedDistances = getDistances(reduced);
+	wrongCount = countChangedDistances(test, reduced, reducedDistances);
+	check(0 == wrongCount, title + ": reducing the false twins changed " + to_string(static_cast<unsigned long long>(wrongCount)) + " distances");
+	check(max(getBruteForceDelta(reducedDistances), twinsDelta.getDelta()) == test.delta, title + ": wrong delta once the false twins are reduced");
+	checkState(test, twinsDelta, title + " (false twins)");
+
+	//splits - the components keep the distances, and the delta is the largest delta of a component, or of the quads crossing a split
+	DeltaHyperbolicity splitDelta;
+	graph_ptr_collection_t components = HyperbolicityAlgorithms::getSplitComponents(test.graph, numeric_limits<unsigned long long>::max(), splitDelta);
+	delta_t componentDelta = splitDelta.getDelta();
+	wrongCount = 0;
+	for (graph_ptr_collection_t::const_iterator it = components.cbegin(); it != components.cend(); ++it)
+	{
+		distances_t componentDistances = getDistances(*it);
+		wrongCount += countChangedDistances(test, *it, componentDistances);
+		componentDelta = max(componentDelta, getBruteForceDelta(componentDistances));
+	}
+	check(0 == wrongCount, title + ": the split components changed " + to_string(static_cast<unsigned long long>(wrongCount)) + " distances");
+	check(componentDelta == test.delta, title + ": the split components' delta is " + to_string(static_cast<long double>(componentDelta)));
+	checkState(test, splitDelta, title + " (splits)");
+
+	//a graph whose split search costs more than allowed is left whole
+	components = HyperbolicityAlgorithms::getSplitComponents(test.graph, 0, splitDelta);
+	check( (1 == components.size()) && (components.front()->size() == n) && (0 == splitDelta.getDelta()), title + ": split beyond the cost allowed");
+
+	//2-core - the nodes left by peeling nodes of degree 0 or 1 one at a time, and pruning the trees keeps the distances & the delta
+	vector<size_t> degrees(n);
+	vector<bool> isPeeled(n, false);
+	for (node_index_t u = 0; u < n; ++u) degrees[u] = test.graph->getNode(u)->getEdges().size();
+	for (bool isChanged = true; isChanged; )
+	{
+		isChanged = false;
+		for (node_index_t u = 0; u < n; ++u)
+		{
+			if (isPeeled[u] || (degrees[u] > 1)) continue;
+			isPeeled[u] = true;
+			isChanged = true;
+			const node_weak_ptr_collection_t& edges = test.graph->getNode(u)->getEdges();
+			for (node_weak_ptr_collection_t::const_iterator it = edges.cbegin(); it != edges.cend(); ++it) --degrees[it->lock()->getIndex()];
+		}
+	}
+	vector<node_index_t> expectedCore;
+	for (node_index_t u = 0; u < n; ++u)
+	{
+		if (!isPeeled[u]) expectedCore.push_back(u);
+	}
+	check(GraphAlgorithms::getTwoCore(CompactGraph(test.graph)) == expectedCore, title + ": wrong 2-core");
+	graph_ptr_t pruned = GraphAlgorithms::getInducedSubgraph(test.graph, allNodes, title);
+	HyperbolicityAlgorithms::pruneTrees(pruned);
+	vector<node_index_t> prunedNodes;
+	for (node_index_t u = 0; u < pruned->size(); ++u) prunedNodes.push_back(getOriginalIndex(pruned->getNode(u)));
+	sort(prunedNodes.begin(), prunedNodes.end());
+	check(prunedNodes == expectedCore, title + ": pruning the trees left the wrong nodes");
+	distances_t prunedDistances = getDistances(pruned);
+	wrongCount = countChangedDistances(test, pruned, prunedDistances);
+	check(0 == wrongCount, title + ": pruning the trees changed " + to_string(static_cast<unsigned long long>(wrongCount)) + " distances");
+	check(getBruteForceDelta(prunedDistances) == test.delta, title + ": pruning the trees changed the delta");
+
+	//chains - the cycle through a chain is isometric, so its delta is at most the graph's
+	size_t chainCount = 0;
+	DeltaHyperbolicity chainsDelta = HyperbolicityAlgorithms::getChainCycleDelta(test.graph, chainCount);
+	check(chainsDelta.getDelta() <= test.delta, title + ": the chains' cycles have delta " + to_string(static_cast<long double>(chainsDelta.getDelta())));
+	checkState(test, chainsDelta, title + " (chains)");
+
+	//the chain core keeps the graph's distances between its nodes (on the weighted core, and in any distance matrix of it), and the graph's
+	//delta is at least the core's, and at most 4 times the chains' reach more
+	const HyperbolicityAlgorithms::WeightedCore& core = test.core;
+	wrongCount = 0;
+	for (node_index_t u = 0; u < core.nodes.size(); ++u)
+	{
+		if (getOriginalIndex(core.graph->getNode(u)) != core.nodes[u]) ++wrongCount;
+	}
+	check( (core.graph->size() == core.nodes.size()) && (core.weights->size() == core.nodes.size()) && (0 == wrongCount), title + ": the chain core's nodes do not match");
+	TestGraph coreTest;
+	coreTest.graph = core.graph;
+	coreTest.distances.assign(core.nodes.size(), vector<distance_t>(core.nodes.size()));
+	for (node_index_t u = 0; u < core.nodes.size(); ++u)
+	{
+		for (node_index_t v = 0; v < core.nodes.size(); ++v) coreTest.distances[u][v] = test.distances[core.nodes[u]][core.nodes[v]];
+	}
+	checkDistanceMatrix(coreTest, DenseDistanceMatrix(*core.weights), title + " (chain core, dense)");
+	checkDistanceMatrix(coreTest, TiledDistanceMatrix(*core.weights, 1, progress_callback_t(), true), title + " (chain core, tiled)");
+	bool isEncodingRejected = false;
+	try
+	{
+		DeltaEncodedDistanceMatrix encoded(*core.weights, 1ULL << 20);
+	}
+	catch (const std::invalid_argument&)
+	{
+		isEncodingRejected = true;
+	}
+	check(isEncodingRejected || !core.weights->isWeighted(), title + ": the chain core was delta encoded");
+	check( (test.coreDelta <= test.delta) && (test.delta <= test.coreDelta + 4 * core.chainReach), title + ": the chain core's delta is " +
+		  to_string(static_cast<long double>(test.coreDelta)) + ", its chains' reach is " + to_string(static_cast<long long>(core.chainReach)));
+}
+
+/*
+ * @brief	Compares scanRows() & scanPairs() with a scalar loop, on random distances - small ones (with many ties), ones with infinite
+ *			distances, and ones too large for the 16-bit lanes. The lengths cross the block size, and are not all multiples of 8.
+ */
+void checkKernel(mt19937& random)
+{
+	const size_t lengths[] = { 0, 1, 7, 8, 9, 100, 511, 512, 513, 1031, 2050 };
+	for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i)
+	{
+		size_t count = lengths[i];
+		for (unsigned int mode = 0; mode < 3; ++mode)
+		{
+			vector<compact_distance_t> values[6];
+			for (unsigned int j = 0; j < 6; ++j)
+			{
+				values[j].resize(count + 1);
+				for (size_t c = 0; c < count; ++c)
+				{
+					compact_distance_t value = static_cast<compact_distance_t>(random() % 9);
+					if ( (1 == mode) && (0 == random() % 20) ) value = CompactInfiniteDistance;
+					if ( (2 == mode) && (0 == random() % 50) ) value = static_cast<compact_distance_t>(16384 + random() % 40000);
+					values[j][c] = value;
+				}
+			}
+
+			distance_t k1 = random() % 9, k2 = random() % 9, k3 = random() % 9;
+			//no candidate evaluated is reported as 0, at index count
+			FourPointKernel::Result expectedRows = { -1, count };
+			FourPointKernel::Result expectedPairs = { -1, count };
+			for (size_t c = 0; c < count; ++c)
+			{
+				bool isInfinite = false;
+				for (unsigned int j = 0; j < 6; ++j) isInfinite = (isInfinite || (CompactInfiniteDistance == values[j][c]));
+				if (isInfinite) continue;
+
+				distance_t doubleDelta = getDoubleDelta(k1 + values[0][c], k2 + values[1][c], k3 + values[2][c]);
+				if (doubleDelta > expectedRows.doubleDelta)
+				{
+					expectedRows.doubleDelta = doubleDelta;
+					expectedRows.index = c;
+				}
+				doubleDelta = getDoubleDelta(values[0][c] + values[3][c], values[1][c] + values[4][c], values[2][c] + values[5][c]);
+				if (doubleDelta > expectedPairs.doubleDelta)
+				{
+					expectedPairs.doubleDelta = doubleDelta;
+					expectedPairs.index = c;
+				}
+			}
+			if (expectedRows.doubleDelta < 0) expectedRows.doubleDelta = 0;
+			if (expectedPairs.doubleDelta < 0) expectedPairs.doubleDelta = 0;
+
+			//the rows scan only skips candidates infinite in its own rows, so the other rows are made finite where these are
+			vector<compact_distance_t> rows[3];
+			for (unsigned int j = 0; j < 3; ++j)
+			{
+				rows[j] = values[j];
+				for (size_t c = 0; c < count; ++c)
+				{
+					if ( (CompactInfiniteDistance == values[3][c]) || (CompactInfiniteDistance == values[4][c]) || (CompactInfiniteDistance == values[5][c]) ) rows[j][c] = CompactInfiniteDistance;
+				}
+			}
+
+			string description = "kernel (" + to_string(static_cast<unsigned long long>(count)) + " candidates, mode " + to_string(static_cast<unsigned long long>(mode)) + ")";
+			FourPointKernel::Result result = FourPointKernel::scanRows(k1, &rows[0][0], k2, &rows[1][0], k3, &rows[2][0], count);
+			check( (result.doubleDelta == expectedRows.doubleDelta) && (result.index == expectedRows.index), description + ": wrong rows scan");
+			result = FourPointKernel::scanPairs(&values[0][0], &values[3][0], &values[1][0], &values[4][0], &values[2][0], &values[5][0], count);
+			check( (result.doubleDelta == expectedPairs.doubleDelta) && (result.index == expectedPairs.index), description + ": wrong pairs scan");
+		}
+	}
+}
+
+/*
+ * @brief	Checks the bounds' updates - each bound only ever improves, the upper one is rounded down to a multiple of 0.5, and the bounds
+ *			are cancelled once they meet - also when they are published from several threads at once.
+ */
+void checkBoundChannel()
+{
+	BoundChannel bounds;
+	check( (0 == bounds.currentLowerBound()) && (InfiniteDelta == bounds.currentUpperBound()) && !bounds.isCancelled(), "Bounds: wrong initial bounds");
+	bounds.publishLowerBound(1.5);
+	bounds.publishLowerBound(1);
+	check(1.5 == bounds.currentLowerBound(), "Bounds: the lower bound was lowered");
+	bounds.publishUpperBound(3.7);
+	check(3.5 == bounds.currentUpperBound(), "Bounds: the upper bound was not rounded down");
+	bounds.publishUpperBound(4);
+	check(3.5 == bounds.currentUpperBound(), "Bounds: the upper bound was raised");
+	check(!bounds.isSettled() && !bounds.isCancelled(), "Bounds: settled before the bounds met");
+	bounds.publishUpperBound(1.5);
+	check(bounds.isSettled() && bounds.isCancelled(), "Bounds: not settled once the bounds met");
+
+	BoundChannel cancelled;
+	cancelled.cancel();
+	check(cancelled.isCancelled() && !cancelled.isSettled(), "Bounds: cancelling settled the bounds");
+
+	//each thread publishes every other bound, from both ends
+	const unsigned int ThreadCount = 4;
+	const unsigned int DoubleBoundCount = 1000;
+	BoundChannel shared;
+	vector<thread> threads;
+	for (unsigned int i = 0; i < ThreadCount; ++i)
+	{
+		threads.push_back(thread([&shared, i, ThreadCount, DoubleBoundCount]()
+		{
+			for (unsigned int doubleDelta = i + 1; doubleDelta <= DoubleBoundCount; doubleDelta += ThreadCount)
+			{
+				shared.publishLowerBound(doubleDelta / 2.0);
+				shared.publishUpperBound((DoubleBoundCount + 1 - doubleDelta) / 2.0);
+			}
+		}));
+	}
+	for (vector<thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+	{
+		it->join();
+	}
+	check(DoubleBoundCount / 2.0 == shared.currentLowerBound(), "Bounds: a lower bound published by one of the threads was lost");
+	check(0.5 == shared.currentUpperBound(), "Bounds: an upper bound published by one of the threads was lost");
+}
+
+/*
+ * @brief	Runs the given plugin on a test graph (or on its chain core, whose nodes keep the test graph's labels), checking the states it
+ *			reports, and that its bounds are settled as soon as it is complete (which, given a high enough lower bound, an exact plugin may
+ *			be once it is initialized).
+ * @returns	The best delta it reported.
+ */
+delta_t runPlugin(IGraphAlg& alg, const graph_ptr_t graph, const TestGraph& test, const bound_channel_ptr_t& bounds, const string& description)
+{
+	alg.initialize(graph, node_combination_t(), bounds);
+	check(!alg.isExact() || !alg.isComplete() || bounds->isSettled(), description + ": complete once initialized, but the bounds were not settled");
+
+	delta_t bestDelta = 0;
+	//the run also ends once the bounds meet, as it does in the runner
+	for (unsigned int stepCount = 0; (!alg.isComplete()) && (!alg.isStopRequested()) && (stepCount < MaxPluginSteps); ++stepCount)
+	{
+		DeltaHyperbolicity result = alg.step();
+		checkState(test, result, description);
+		bestDelta = max(bestDelta, result.getDelta());
+	}
+	check(!alg.isExact() || !alg.isComplete() || bounds->isSettled(), description + ": complete, but the bounds were not settled");
+	return bestDelta;
+}
+
+/*
+ * @brief	Initializes the given plugin, which was asked to stop beforehand (by its deadline, or by its bounds). The initialization must
+ *			return early, and take no step - and whatever it found must not exceed the graph's delta, unless the plugin claims to have
+ *			completed an exact search.
+ */
+void checkStoppedPlugin(IGraphAlg& alg, const TestGraph& test, const bound_channel_ptr_t& bounds, const string& description)
+{
+	alg.initialize(test.graph, node_combination_t(), bounds);
+	check(alg.isStopRequested(), description + ": the stop request was withdrawn");
+	check(bounds->currentLowerBound() <= test.delta, description + ": the lower bound is " + to_string(static_cast<long double>(bounds->currentLowerBound())));
+	check(!alg.isExact() || !alg.isComplete() || (bounds->currentLowerBound() == test.delta), description + ": complete, with a lower bound of " +
+		  to_string(static_cast<long double>(bounds->currentLowerBound())));
+	check( (alg.getProgress() >= 0) && (alg.getProgress() <= 1), description + ": the progress is " + to_string(static_cast<long double>(alg.getProgress())));
+
+	bool isRefused = false;
+	try
+	{
+		alg.step();
+	}
+	catch (const std::logic_error&)
+	{
+		isRefused = true;
+	}
+	check(isRefused, description + ": a step was taken");
+}
+
+/*
+ * @brief	Runs the plugin in the given directory on every test graph. The states it reports must attain their deltas, which must not
+ *			exceed the graph's delta - and an exact plugin must complete, with the graph's delta, and with the bounds settled at it. An
+ *			exact plugin is also run from the graph's delta as a lower bound, which must only be confirmed.
+ *			A plugin that supports weighted graphs is run on the graph's chain core as well, where the same holds for the core's delta.
+ *			Finally, every plugin is run past its deadline and with cancelled bounds (see checkStoppedPlugin()).
+ */
+void checkPlugin(const string& directory, const PluginInfo& plugin, const vector<TestGraph>& tests)
+{
+	string path = directory + "\\" + plugin.name + ".dll";
+	shared_ptr<HINSTANCE__> library(LoadLibraryA(path.c_str()), &FreeLibrary);
+	AlgCreationMethod createAlg = (nullptr == library.get() ? nullptr : reinterpret_cast<AlgCreationMethod>(GetProcAddress(library.get(), "CreateAlgorithm")));
+	AlgReleaseMethod releaseAlg = (nullptr == library.get() ? nullptr : reinterpret_cast<AlgReleaseMethod>(GetProcAddress(library.get(), "ReleaseAlgorithm")));
+	if ( (nullptr == createAlg) || (nullptr == releaseAlg) )
+	{
+		cout << "Failed loading " << path << ", skipping it" << endl;
+		return;
+	}
+
+	for (vector<TestGraph>::const_iterator it = tests.cbegin(); it != tests.cend(); ++it)
+	{
+		//the threads of a plugin share its search, so each graph is searched by a different number of them
+		const unsigned int threadLimit = 1 + static_cast<unsigned int>(it - tests.cbegin()) % MaxPluginThreads;
+		string description = string(plugin.name) + " on " + it->graph->getTitle() + " with " + to_string(static_cast<unsigned long long>(threadLimit)) + " thread(s)";
+		IGraphAlg* alg = createAlg();
+		try
+		{
+			alg->setThreadLimit(threadLimit);
+			bound_channel_ptr_t bounds(new BoundChannel());
+			delta_t bestDelta = runPlugin(*alg, it->graph, *it, bounds, description);
+			check(bestDelta <= it->delta, description + ": found delta " + to_string(static_cast<long double>(bestDelta)) + ", larger than " +
+				  to_string(static_cast<long double>(it->delta)));
+			if (plugin.isExact)
+			{
+				check(alg->isComplete(), description + ": did not complete");
+				check(bestDelta == it->delta, description + ": found delta " + to_string(static_cast<long double>(bestDelta)) + " instead of " +
+					  to_string(static_cast<long double>(it->delta)));
+				check(bounds->currentUpperBound() == it->delta, description + ": the upper bound is " + to_string(static_cast<long double>(bounds->currentUpperBound())));
+
+				//nothing beats the graph's delta, so only the upper bound is left to find
+				bound_channel_ptr_t seededBounds(new BoundChannel());
+				seededBounds->publishLowerBound(it->delta);
+				bestDelta = runPlugin(*alg, it->graph, *it, seededBounds, description + " (seeded)");
+				check(alg->isComplete(), description + " (seeded): did not complete");
+				check(bestDelta <= it->delta, description + " (seeded): found delta " + to_string(static_cast<long double>(bestDelta)));
+				check(seededBounds->currentUpperBound() == it->delta, description + " (seeded): the upper bound is " +
+					  to_string(static_cast<long double>(seededBounds->currentUpperBound())));
+			}
+
+			//on the chain core, the delta found is the core's - and a plugin that does not support weighted graphs must refuse it
+			alg->setWeightedGraph(it->core.weights);
+			if (!alg->supportsWeightedGraph())
+			{
+				bool isRefused = false;
+				try
+				{
+					alg->initialize(it->core.graph);
+				}
+				catch (const std::exception&)
+				{
+					isRefused = true;
+				}
+				check(isRefused, description + " (chain core): a weighted graph was accepted");
+			}
+			else if (it->core.graph->size() >= node_combination_t::size())
+			{
+				bound_channel_ptr_t coreBounds(new BoundChannel());
+				bestDelta = runPlugin(*alg, it->core.graph, *it, coreBounds, description + " (chain core)");
+				check(bestDelta <= it->coreDelta, description + " (chain core): found delta " + to_string(static_cast<long double>(bestDelta)) + ", larger than " +
+					  to_string(static_cast<long double>(it->coreDelta)));
+				if (plugin.isExact)
+				{
+					check(alg->isComplete(), description + " (chain core): did not complete");
+					check(bestDelta == it->coreDelta, description + " (chain core): found delta " + to_string(static_cast<long double>(bestDelta)) + " instead of " +
+						  to_string(static_cast<long double>(it->coreDelta)));
+					check(coreBounds->currentUpperBound() == it->coreDelta, description + " (chain core): the upper bound is " +
+						  to_string(static_cast<long double>(coreBounds->currentUpperBound())));
+				}
+			}
+			alg->setWeightedGraph(compact_graph_ptr_t());
+
+			//past the deadline, or with the bounds cancelled, the run is over before it starts
+			alg->setDeadline(0);
+			checkStoppedPlugin(*alg, *it, bound_channel_ptr_t(new BoundChannel()), description + " (past the deadline)");
+			alg->setDeadline(IGraphAlg::NoDeadline);
+			bound_channel_ptr_t cancelledBounds(new BoundChannel());
+			cancelledBounds->cancel();
+			checkStoppedPlugin(*alg, *it, cancelledBounds, description + " (cancelled)");
+		}
+		catch (const std::exception& ex)
+		{
+			check(false, description + ": exception caught: " + ex.what());
+		}
+		releaseAlg(alg);
+	}
+}
+
+/*
+ * @brief	Times loading the given graph, finding its biconnected components, distances and spanning tree.
+ */
+void runLoadingBenchmark(const string& path)
+{
+	clock_t t1 = clock();
+	graph_ptr_t graph = GraphAlgorithms::LoadGraphFromFile(path);
+	double timeElapsed = (clock() - t1) / static_cast<double>(CLOCKS_PER_SEC);
+	cout << "Loading took " << timeElapsed << " seconds" << endl;
+	cout << "# of vertices: " << graph->size() << endl;
+	cout << "# of edges: " << (graph->edgeCount() / 2) << endl << endl;
+
+	t1 = clock();
+	graph_ptr_collection_t graphs = GraphAlgorithms::getBiconnectedComponents(graph);
+	timeElapsed = (clock() - t1) / static_cast<double>(CLOCKS_PER_SEC);
+	cout << "Getting biconnected components took " << timeElapsed << " seconds" << endl;
+	cout << "# of graphs: " << graphs.size() << endl;
+	size_t nodeCount = 0;
+	size_t edgeCount = 0;
+	for (graph_ptr_collection_t::const_iterator it = graphs.cbegin(); it != graphs.cend(); ++it)
+	{
+		nodeCount += (*it)->size();
+		edgeCount += ((*it)->edgeCount() / 2);
+	}
+
+	check(nodeCount >= graph->size(), "Node count is larger than the sum of nodes in the biconnected components");
+	check(edgeCount == (graph->edgeCount() / 2), "Edge count is different than the sum of edges in the biconnected components");
+
+	NodeDistances nds(graph, graph->getNode(0));
+
+	t1 = clock();
+	distance_dict_t distances = nds.getDistances();
+	timeElapsed = (clock() - t1) / static_cast<double>(CLOCKS_PER_SEC);
+	cout << "Calculating distances took: " << timeElapsed << endl;
+	cout << "# of vertices: " << graph->size() << endl;
+	cout << "# of distances: " << distances.size() << endl << endl;
+
+	t1 = clock();
+	SpanningTree st(graph, graph->getNode(0));
+	timeElapsed = (clock() - t1) / static_cast<double>(CLOCKS_PER_SEC);
+	cout << "Calculating spanning tree took: " << timeElapsed << endl;
+	graph_ptr_t tree = st.getTree();
+	cout << "Tree node count: " << tree->size() << endl;
+	cout << "Tree edge count: " << (tree->edgeCount() / 2) << endl << endl;
+}
+
+/*
+ * @brief	Usage: Tester [plugins directory] [graph file]
+ *			Checks the distance matrices & the dynamic distances on small graphs against a plain BFS from every node, the decompositions
+ *			& the chain cores against a brute force search of the graphs' delta, the SSE kernel against a scalar loop, and the bounds' updates - and the
+ *			plugins in the given directory (e.g. Algorithms\bin\x64\Release), if any, against the brute force delta.
+ *			If a graph file is given, the time it takes to load it & run the basic graph algorithms on it is measured as well.
+ * @returns	0 if all checks passed, 1 otherwise.
+ */
+int main(int argc, char* argv[])
 {
 	try
 	{
 		srand(static_cast<unsigned int>(time(nullptr)));
+		mt19937 random(RandomSeed);
 
 		clock_t t1 = clock();
-		graph_ptr_t graph = GraphAlgorithms::LoadGraphFromFile("D:\\Eran\\Dropbox\\University\\Thesis\\Shavitt\\Code\\Graphs\\Stanford\\Formatted\\Email-Enron.txt"); //C:\\Users\\Eran\\Dropbox\\University\\Thesis\\Shavitt\\Code\\Graphs\\Stanford\\Formatted\\roadNet-PA.txt");
+		vector<TestGraph> tests = getTestGraphs(random);
+		for (vector<TestGraph>::const_iterator it = tests.cbegin(); it != tests.cend(); ++it)
+		{
+			checkDistanceMatrices(*it);
+			checkDynamicDistances(*it, random);
+			checkDecompositions(*it);
+		}
+
+		//a larger graph for the distance matrices, spanning many tiles & more rows than their caches hold
+		TestGraph large;
+		large.graph = createGraph("random_large", 700, getRandomEdges(700, 350, random));
+		large.distances = getDistances(large.graph);
+		large.delta = 0;
+		checkDistanceMatrices(large);
+
+		//a long path ending in a triangle is peeled down to the triangle (without running out of stack)
+		const size_t pathLength = 200000;
+		edge_collection_t pathEdges;
+		for (node_index_t v = 1; v <= pathLength; ++v)
+		{
+			node_index_t u = (pathLength == v ? 0 : v - 1);
+			node_index_t w = (pathLength == v ? 2 : v);
+			pathEdges.push_back(make_pair(u, w));
+			pathEdges.push_back(make_pair(w, u));
+		}
+		vector<node_index_t> triangle;
+		for (node_index_t v = 0; v < 3; ++v) triangle.push_back(v);
+		check(GraphAlgorithms::getTwoCore(CompactGraph(pathLength, pathEdges)) == triangle, "long_path: wrong 2-core");
+
+		checkKernel(random);
+		checkBoundChannel();
 		double timeElapsed = (clock() - t1) / static_cast<double>(CLOCKS_PER_SEC);
-		cout << "Loading took " << timeElapsed << " seconds" << endl;
-        cout << "# of vertices: " << graph->size() << endl;
-        cout << "# of edges: " << (graph->edgeCount() / 2) << endl << endl;
-		
-		t1 = clock();
-		graph_ptr_collection_t graphs = GraphAlgorithms::getBiconnectedComponents(graph);
-		timeElapsed = (clock() - t1) / static_cast<double>(CLOCKS_PER_SEC);
-		cout << "Getting biconnected components took " << timeElapsed << " seconds" << endl;
-		cout << "# of graphs: " << graphs.size() << endl;
-		size_t nodeCount = 0;
-		size_t edgeCount = 0;
-		unsigned int i = 0;
-		for (graph_ptr_collection_t::const_iterator it = graphs.cbegin(); it != graphs.cend(); ++it)
-		{
-			nodeCount += (*it)->size();
-			edgeCount += ((*it)->edgeCount() / 2);
-		}
-
-		if (nodeCount < graph->size()) cout << "***ERROR*** - Node count is smaller than the sum of nodes in the biconnected components (" << nodeCount << ", " << graph->size() << ")!" << endl;
-		if (edgeCount != (graph->edgeCount() / 2) ) cout << "***ERROR*** - Edge count is different than the sum of nodes in the biconnected components (" << edgeCount << ", " << graph->edgeCount() << ")!" << endl;
-
-		NodeDistances nds(graph, graph->getNode(0));
-		
-		t1 = clock();
-		distance_dict_t distances = nds.getDistances();
-		timeElapsed = (clock() - t1) / static_cast<double>(CLOCKS_PER_SEC);
-		cout << "Calculating distances took: " << timeElapsed << endl;
-		cout << "0-->123: " << distances[123] << endl;
-		cout << "# of vertices: " << graph->size() << endl;
-		cout << "# of distances: " << distances.size() << endl << endl;
-
-		t1 = clock();
-		SpanningTree st(graph, graph->getNode(0));
-		timeElapsed = (clock() - t1) / static_cast<double>(CLOCKS_PER_SEC);
-		cout << "Calculating spanning tree took: " << timeElapsed << endl;
-		graph_ptr_t tree = st.getTree();
-		cout << "Tree node count: " << tree->size() << endl;
-		cout << "Tree edge count: " << (tree->edgeCount() / 2) << endl;
+		cout << "Checking " << tests.size() << " graphs, the kernel & the bounds took " << timeElapsed << " seconds" << endl;
+
+		if (argc > 1)
+		{
+			for (size_t i = 0; i < sizeof(Plugins) / sizeof(Plugins[0]); ++i)
+			{
+				t1 = clock();
+				checkPlugin(argv[1], Plugins[i], tests);
+				timeElapsed = (clock() - t1) / static_cast<double>(CLOCKS_PER_SEC);
+				cout << "Checking " << Plugins[i].name << " took " << timeElapsed << " seconds" << endl;
+			}
+		}
+		cout << endl;
+
+		if (argc > 2) runLoadingBenchmark(argv[2]);
 	}
 	catch (const std::exception& ex)
 	{
-		cout << "Exception caught: " << ex.what() << endl;
+		check(false, string("Exception caught: ") + ex.what());
 	}
 
-	return 0;
-}
\ No newline at end of file
+	cout << failureCount << " checks failed" << endl;
+	return (0 == failureCount ? 0 : 1);
+}